@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         AES-128 driver for the native platform, using the AES-NI
+ *         instructions of x86 CPUs.
+ */
+
+#include "dev/native-aes-128.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+
+/* Enable the instructions for these functions only, so that the rest of
+   the build keeps running on any x86 CPU */
+#define AESNI __attribute__((target("aes,sse2")))
+
+static __m128i round_keys[11];
+static int has_aesni = -1;
+
+/*---------------------------------------------------------------------------*/
+AESNI static __m128i
+expand_step(__m128i key, __m128i assist)
+{
+  assist = _mm_shuffle_epi32(assist, 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+/*---------------------------------------------------------------------------*/
+/* The round constant of _mm_aeskeygenassist_si128 must be an immediate */
+#define EXPAND(i, rcon) \
+  round_keys[i] = expand_step(round_keys[i - 1], \
+                              _mm_aeskeygenassist_si128(round_keys[i - 1], rcon))
+
+AESNI static void
+aesni_set_key(const uint8_t *key)
+{
+  round_keys[0] = _mm_loadu_si128((const __m128i *)key);
+  EXPAND(1, 0x01);
+  EXPAND(2, 0x02);
+  EXPAND(3, 0x04);
+  EXPAND(4, 0x08);
+  EXPAND(5, 0x10);
+  EXPAND(6, 0x20);
+  EXPAND(7, 0x40);
+  EXPAND(8, 0x80);
+  EXPAND(9, 0x1b);
+  EXPAND(10, 0x36);
+}
+/*---------------------------------------------------------------------------*/
+AESNI static void
+aesni_encrypt(uint8_t *state)
+{
+  __m128i s;
+  int round;
+
+  s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)state), round_keys[0]);
+  for(round = 1; round < 10; round++) {
+    s = _mm_aesenc_si128(s, round_keys[round]);
+  }
+  s = _mm_aesenclast_si128(s, round_keys[10]);
+  _mm_storeu_si128((__m128i *)state, s);
+}
+/*---------------------------------------------------------------------------*/
+static int
+aesni_available(void)
+{
+  if(has_aesni < 0) {
+    __builtin_cpu_init();
+    has_aesni = __builtin_cpu_supports("aes");
+  }
+  return has_aesni;
+}
+#else /* defined(__x86_64__) || defined(__i386__) */
+#define aesni_available()    0
+#define aesni_set_key(key)
+#define aesni_encrypt(state)
+#endif /* defined(__x86_64__) || defined(__i386__) */
+/*---------------------------------------------------------------------------*/
+static void
+set_key(const uint8_t *key)
+{
+  if(aesni_available()) {
+    aesni_set_key(key);
+  } else {
+    aes_128_ttable_driver.set_key(key);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+encrypt(uint8_t *plaintext_and_result)
+{
+  if(aesni_available()) {
+    aesni_encrypt(plaintext_and_result);
+  } else {
+    aes_128_ttable_driver.encrypt(plaintext_and_result);
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct aes_128_driver native_aes_128_driver = {
+  set_key,
+  encrypt
+};
+/*---------------------------------------------------------------------------*/
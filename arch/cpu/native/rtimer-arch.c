@@ -43,9 +43,20 @@
 #endif /* !_WIN32 */
 #include <stddef.h>
 
+#include "contiki.h"
 #include "sys/rtimer.h"
 #include "sys/clock.h"
 
+#if RTIMER_ARCH_TIMERFD
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif /* RTIMER_ARCH_TIMERFD */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -54,6 +65,88 @@
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+#if RTIMER_ARCH_TIMERFD
+static int timer_fd = -1;
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_arch_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (rtimer_clock_t)((uint64_t)ts.tv_sec * RTIMER_ARCH_SECOND +
+                          ts.tv_nsec / 1000);
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(timer_fd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  uint64_t expirations;
+
+  if(FD_ISSET(timer_fd, rset)) {
+    /* The timer is one-shot and non-blocking; a failed read means it was
+       re-armed or disarmed since select() returned */
+    if(read(timer_fd, &expirations, sizeof(expirations)) ==
+       (ssize_t)sizeof(expirations)) {
+      rtimer_run_next();
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback timer_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_init(void)
+{
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(timer_fd == -1) {
+    perror("rtimer-arch: timerfd_create");
+    exit(1);
+  }
+  if(!select_set_callback(timer_fd, &timer_callback)) {
+    fprintf(stderr, "rtimer-arch: could not register timerfd %d\n",
+            timer_fd);
+    exit(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  struct itimerspec val;
+  rtimer_clock_t now;
+  int32_t c;
+
+  now = rtimer_arch_now();
+  c = (int32_t)RTIMER_CLOCK_DIFF(t, now);
+
+  memset(&val, 0, sizeof(val));
+  if(c <= 0) {
+    /* Already due: an all-zero it_value would disarm the timer, so let it
+       expire as soon as possible instead */
+    val.it_value.tv_nsec = 1;
+  } else {
+    val.it_value.tv_sec = c / RTIMER_ARCH_SECOND;
+    val.it_value.tv_nsec = (c % RTIMER_ARCH_SECOND) * 1000;
+  }
+
+  PRINTF("rtimer_arch_schedule time %lu in %ld us\n",
+         (unsigned long)t, (long)c);
+
+  if(timerfd_settime(timer_fd, 0, &val, NULL) == -1) {
+    perror("rtimer-arch: timerfd_settime");
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* RTIMER_ARCH_TIMERFD */
 /*---------------------------------------------------------------------------*/
 static void
 interrupt(int sig)
@@ -90,3 +183,5 @@ rtimer_arch_schedule(rtimer_clock_t t)
 #endif /* !_WIN32 */
 }
 /*---------------------------------------------------------------------------*/
+#endif /* RTIMER_ARCH_TIMERFD */
+/*---------------------------------------------------------------------------*/
@@ -42,8 +42,34 @@
 
 #include "contiki.h"
 
+/**
+ * Set non-zero (1) to drive rtimers from a CLOCK_MONOTONIC timerfd that is
+ * polled by the native main loop instead of from SIGALRM/setitimer(). The
+ * rtimer then ticks in microseconds and its callbacks run synchronously
+ * from the main loop rather than from a signal handler. Linux only.
+ */
+#ifdef RTIMER_ARCH_CONF_TIMERFD
+#define RTIMER_ARCH_TIMERFD RTIMER_ARCH_CONF_TIMERFD
+#else
+#define RTIMER_ARCH_TIMERFD 0
+#endif
+
+#if RTIMER_ARCH_TIMERFD
+
+#define RTIMER_ARCH_SECOND 1000000UL
+
+#define US_TO_RTIMERTICKS(US)   (US)
+#define RTIMERTICKS_TO_US(T)    (T)
+#define RTIMERTICKS_TO_US_64(T) (T)
+
+rtimer_clock_t rtimer_arch_now(void);
+
+#else /* RTIMER_ARCH_TIMERFD */
+
 #define RTIMER_ARCH_SECOND CLOCK_CONF_SECOND
 
 #define rtimer_arch_now() clock_time()
 
+#endif /* RTIMER_ARCH_TIMERFD */
+
 #endif /* RTIMER_ARCH_H_ */
@@ -132,6 +132,11 @@ typedef unsigned long clock_time_t;
 
 #define UIP_ARCH_IPCHKSUM        1
 
+/* Flash size is no concern, so use the fastest software CRC16 */
+#ifndef CRC16_CONF_TABLE
+#define CRC16_CONF_TABLE CRC16_TABLE_BYTE
+#endif /* CRC16_CONF_TABLE */
+
 #if MAC_CONF_WITH_TSCH
 /* A bug in cooja causes many EBs to be missed at scan. Increase EB
    frequency to shorten the join process */
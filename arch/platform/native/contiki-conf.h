@@ -96,6 +96,11 @@ typedef unsigned int uip_stats_t;
 
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 
+/* Flash size is no concern, so use the fastest software CRC16 */
+#ifndef CRC16_CONF_TABLE
+#define CRC16_CONF_TABLE CRC16_TABLE_BYTE
+#endif /* CRC16_CONF_TABLE */
+
 #include <ctype.h>
 
 typedef unsigned long clock_time_t;
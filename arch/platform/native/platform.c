@@ -108,11 +108,41 @@
 #else
 #define SELECT_STDIN 1
 #endif
+
+/*
+ * Uses epoll(7) instead of select(2) in the platform main loop (Linux only).
+ * File descriptors are registered with the kernel once, in
+ * select_set_callback(), and SELECT_MAX then limits the number of monitored
+ * file descriptors rather than their value.
+ */
+#ifdef SELECT_CONF_EPOLL
+#define SELECT_EPOLL SELECT_CONF_EPOLL
+#else
+#define SELECT_EPOLL 0
+#endif
 /** @} */
 /*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+#include <sys/epoll.h>
 
+/* A file descriptor registered with epoll, with the events currently
+ * requested for it. Descriptors that epoll cannot monitor, such as regular
+ * files, are not registered and are handled as always ready, which is
+ * what select() reports for them. */
+struct select_entry {
+  int fd;
+  const struct select_callback *callback;
+  uint32_t events;
+  uint8_t pollable;
+};
+static struct select_entry select_entries[SELECT_MAX];
+static int epoll_fd = -1;
+/* The number of descriptors registered with epoll */
+static int epoll_count;
+#else /* SELECT_EPOLL */
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
+#endif /* SELECT_EPOLL */
 
 #ifdef PLATFORM_CONF_MAC_ADDR
 static uint8_t mac_addr[] = PLATFORM_CONF_MAC_ADDR;
@@ -121,6 +151,75 @@ static uint8_t mac_addr[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
 #endif /* PLATFORM_CONF_MAC_ADDR */
 
 /*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+int
+select_set_callback(int fd, const struct select_callback *callback)
+{
+  struct select_entry *entry;
+  struct select_entry *free_entry;
+  struct epoll_event ev;
+  int i;
+
+  if(fd < 0 || fd >= FD_SETSIZE) {
+    return 0;
+  }
+
+  /* Check that the callback functions are set */
+  if(callback != NULL &&
+     (callback->set_fd == NULL || callback->handle_fd == NULL)) {
+    callback = NULL;
+  }
+
+  entry = NULL;
+  free_entry = NULL;
+  for(i = 0; i < SELECT_MAX; i++) {
+    if(select_entries[i].callback == NULL) {
+      if(free_entry == NULL) {
+        free_entry = &select_entries[i];
+      }
+    } else if(select_entries[i].fd == fd) {
+      entry = &select_entries[i];
+    }
+  }
+
+  if(entry != NULL) {
+    if(callback == NULL && entry->pollable) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      epoll_count--;
+    }
+    entry->callback = callback;
+    return 1;
+  }
+
+  if(callback == NULL) {
+    return 1;
+  }
+
+  if(free_entry == NULL) {
+    /* Maximum number of file descriptors exceeded */
+    return 0;
+  }
+
+  /* The requested events are updated from set_fd() in the main loop */
+  memset(&ev, 0, sizeof(ev));
+  ev.events = 0;
+  ev.data.ptr = free_entry;
+  free_entry->pollable = 0;
+  if(epoll_fd == -1) {
+    /* epoll is not available, see platform_init_stage_one() */
+  } else if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+    free_entry->pollable = 1;
+    epoll_count++;
+  } else if(errno != EPERM) {
+    perror("epoll_ctl");
+    return 0;
+  }
+  free_entry->fd = fd;
+  free_entry->events = 0;
+  free_entry->callback = callback;
+  return 1;
+}
+#else /* SELECT_EPOLL */
 int
 select_set_callback(int fd, const struct select_callback *callback)
 {
@@ -152,6 +251,7 @@ select_set_callback(int fd, const struct select_callback *callback)
   }
   return 0;
 }
+#endif /* SELECT_EPOLL */
 /*---------------------------------------------------------------------------*/
 #if SELECT_STDIN
 static int
@@ -246,6 +346,12 @@ platform_process_args(int argc, char**argv)
 void
 platform_init_stage_one()
 {
+#if SELECT_EPOLL
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if(epoll_fd == -1) {
+    perror("epoll_create1");
+  }
+#endif /* SELECT_EPOLL */
   gpio_hal_init();
   button_hal_init();
   leds_init();
@@ -275,6 +381,129 @@ platform_init_stage_three()
   setvbuf(stdout, (char *)NULL, _IONBF, 0);
 }
 /*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+/* Asks the callback of an entry which events it wants and updates the epoll
+ * registration only if they changed */
+static void
+update_events(struct select_entry *entry, fd_set *fdr, fd_set *fdw)
+{
+  struct epoll_event ev;
+  uint32_t events = 0;
+
+  if(entry->callback->set_fd(fdr, fdw)) {
+    if(FD_ISSET(entry->fd, fdr)) {
+      events |= EPOLLIN;
+    }
+    if(FD_ISSET(entry->fd, fdw)) {
+      events |= EPOLLOUT;
+    }
+  }
+  FD_CLR(entry->fd, fdr);
+  FD_CLR(entry->fd, fdw);
+
+  if(!entry->pollable) {
+    entry->events = events;
+  } else if(events != entry->events) {
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = entry;
+    if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, entry->fd, &ev) == -1) {
+      perror("epoll_ctl");
+    } else {
+      entry->events = events;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Calls the handler of an entry for the given events */
+static void
+handle_events(struct select_entry *entry, uint32_t events,
+              fd_set *fdr, fd_set *fdw)
+{
+  /* Errors and hang-ups are reported as readable, so that the handler
+   * finds out when reading */
+  if(events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+    FD_SET(entry->fd, fdr);
+  }
+  if(events & EPOLLOUT) {
+    FD_SET(entry->fd, fdw);
+  }
+  entry->callback->handle_fd(fdr, fdw);
+  FD_CLR(entry->fd, fdr);
+  FD_CLR(entry->fd, fdw);
+}
+/*---------------------------------------------------------------------------*/
+void
+platform_main_loop()
+{
+  /* Only the bits of the fd being handled are ever set, so the sets need
+   * to be cleared only once */
+  static fd_set fdr;
+  static fd_set fdw;
+  struct epoll_event events[SELECT_MAX];
+  struct select_entry *entry;
+  int always_ready;
+  int timeout;
+  int i;
+  int retval;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+
+#if SELECT_STDIN
+  select_set_callback(STDIN_FILENO, &stdin_fd);
+#endif /* SELECT_STDIN */
+  while(1) {
+    retval = process_run();
+
+    always_ready = 0;
+    for(i = 0; i < SELECT_MAX; i++) {
+      if(select_entries[i].callback != NULL) {
+        update_events(&select_entries[i], &fdr, &fdw);
+        if(!select_entries[i].pollable && select_entries[i].events != 0) {
+          always_ready = 1;
+        }
+      }
+    }
+
+    /* SELECT_TIMEOUT is in microseconds, epoll has millisecond resolution */
+    timeout = (retval || always_ready) ? 0 : (SELECT_TIMEOUT + 999) / 1000;
+    if(epoll_count > 0) {
+      retval = epoll_wait(epoll_fd, events, SELECT_MAX, timeout);
+      if(retval < 0) {
+        if(errno != EINTR) {
+          perror("epoll_wait");
+        }
+      }
+    } else {
+      /* Nothing to wait for but the next timer */
+      if(timeout > 0) {
+        usleep(SELECT_TIMEOUT);
+      }
+      retval = 0;
+    }
+    for(i = 0; i < retval; i++) {
+      entry = events[i].data.ptr;
+      /* The callback may have been removed by a previous handler */
+      if(entry->callback != NULL) {
+        handle_events(entry, events[i].events, &fdr, &fdw);
+      }
+    }
+    if(always_ready) {
+      for(i = 0; i < SELECT_MAX; i++) {
+        entry = &select_entries[i];
+        if(entry->callback != NULL && !entry->pollable && entry->events != 0) {
+          handle_events(entry, entry->events, &fdr, &fdw);
+        }
+      }
+    }
+
+    etimer_request_poll();
+  }
+
+  return;
+}
+#else /* SELECT_EPOLL */
 void
 platform_main_loop()
 {
@@ -322,6 +551,7 @@ platform_main_loop()
 
   return;
 }
+#endif /* SELECT_EPOLL */
 /*---------------------------------------------------------------------------*/
 void
 log_message(char *m1, char *m2)
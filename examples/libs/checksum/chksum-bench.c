@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Measures the Internet checksum kernel on packet sizes from 64 to 1280
+ * bytes, and compares updating the checksum of a 1280-byte packet for
+ * a changed pseudo-header with computing it over the whole packet
+ * again. Build with UIP_CONF_CHKSUM_WIDE=0 to measure the 16-bit
+ * kernel instead, e.g.:
+ *
+ * make TARGET=native chksum-bench DEFINES=UIP_CONF_CHKSUM_WIDE=0
+ */
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+#include "dev/watchdog.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef CHKSUM_BENCH_CONF_OPERATIONS
+#define CHKSUM_BENCH_OPERATIONS CHKSUM_BENCH_CONF_OPERATIONS
+#else
+#define CHKSUM_BENCH_OPERATIONS 1000000UL
+#endif
+
+#define MAX_PACKET_LEN 1280
+/*---------------------------------------------------------------------------*/
+PROCESS(chksum_bench_process, "Internet checksum benchmark");
+AUTOSTART_PROCESSES(&chksum_bench_process);
+/*---------------------------------------------------------------------------*/
+/* RFC 1071, section 3 */
+static const uint8_t rfc1071_data[8] = {
+  0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7
+};
+#define RFC1071_SUM 0xddf2
+
+static const uint16_t packet_lens[] = { 64, 128, 256, 512, 1024, 1280 };
+
+static uint8_t packet[MAX_PACKET_LEN + 1];
+
+/* Keeps the compiler from optimizing the measured calls away */
+static volatile uint16_t sink;
+/*---------------------------------------------------------------------------*/
+/* A plain 16-bit sum to check the kernel against */
+static uint16_t
+reference_sum(const uint8_t *data, uint16_t len)
+{
+  uint32_t sum;
+  uint16_t i;
+
+  sum = 0;
+  for(i = 0; i + 1 < len; i += 2) {
+    sum += (data[i] << 8) | data[i + 1];
+  }
+  if(len & 1) {
+    sum += data[len - 1] << 8;
+  }
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_kernel(void)
+{
+  uint16_t len;
+  uint8_t offset;
+
+  if(uip_chksum_add(0, rfc1071_data, sizeof(rfc1071_data)) != RFC1071_SUM) {
+    return 0;
+  }
+
+  /* Every length and alignment up to a few words */
+  for(offset = 0; offset < 4; offset++) {
+    for(len = 0; len <= 64; len++) {
+      if(uip_chksum_add(0, packet + offset, len) !=
+         reference_sum(packet + offset, len)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_update(void)
+{
+  uip_ip6addr_t old_addrs[2];
+  uip_ip6addr_t new_addrs[2];
+  uint16_t chksum;
+
+  /* The first 32 bytes of the packet stand in for the addresses */
+  memcpy(old_addrs, packet, sizeof(old_addrs));
+  memset(new_addrs, 0x5a, sizeof(new_addrs));
+
+  chksum = uip_htons(~reference_sum(packet, MAX_PACKET_LEN));
+  chksum = uip_chksum_update(chksum, old_addrs, sizeof(old_addrs),
+                             new_addrs, sizeof(new_addrs));
+  memcpy(packet, new_addrs, sizeof(new_addrs));
+
+  return chksum == uip_htons(~reference_sum(packet, MAX_PACKET_LEN));
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *what, uint16_t len, unsigned long operations,
+       clock_time_t ticks)
+{
+  if(ticks == 0) {
+    ticks = 1;
+  }
+  printf("%s, %u bytes: %lu in %lu ticks, %lu per second\n", what, len,
+         operations, (unsigned long)ticks,
+         (unsigned long)(operations / ticks * CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(chksum_bench_process, ev, data)
+{
+  uip_ip6addr_t addrs[2];
+  clock_time_t start;
+  unsigned long n;
+  unsigned long operations;
+  uint16_t chksum;
+  uint8_t i;
+
+  PROCESS_BEGIN();
+
+  for(n = 0; n < sizeof(packet); n++) {
+    packet[n] = n * 131 + 7;
+  }
+
+  printf("Internet checksum benchmark, %lu operations per 64 bytes, "
+         "CLOCK_SECOND %lu\n", (unsigned long)CHKSUM_BENCH_OPERATIONS,
+         (unsigned long)CLOCK_SECOND);
+  printf("Checksum kernel: %s\n", check_kernel() ? "ok" : "FAILED");
+  printf("Incremental update: %s\n", check_update() ? "ok" : "FAILED");
+
+  for(i = 0; i < sizeof(packet_lens) / sizeof(packet_lens[0]); i++) {
+    /* Keep the amount of data summed per run the same */
+    operations = CHKSUM_BENCH_OPERATIONS * 64 / packet_lens[i];
+    start = clock_time();
+    for(n = 0; n < operations; n++) {
+      sink = uip_chksum_add(n, packet, packet_lens[i]);
+      if((n & 0x3ff) == 0) {
+        watchdog_periodic();
+      }
+    }
+    report("Full checksum", packet_lens[i], operations, clock_time() - start);
+  }
+
+  /* What a translator or forwarder saves by not summing the payload */
+  memset(addrs, 0x5a, sizeof(addrs));
+  chksum = 0;
+  start = clock_time();
+  for(n = 0; n < CHKSUM_BENCH_OPERATIONS; n++) {
+    chksum = uip_chksum_update(chksum, packet, sizeof(addrs),
+                               addrs, sizeof(addrs));
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  sink = chksum;
+  report("Pseudo-header update", MAX_PACKET_LEN, CHKSUM_BENCH_OPERATIONS,
+         clock_time() - start);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
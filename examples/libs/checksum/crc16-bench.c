@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Measures the per-byte cost of the CRC16 module on 802.15.4 frame
+ * sized buffers, after checking it against a known answer. Build with
+ * a different CRC16_CONF_TABLE to compare implementations, e.g.:
+ *
+ * make TARGET=native crc16-bench DEFINES=CRC16_CONF_TABLE=CRC16_TABLE_NIBBLE
+ * make TARGET=native crc16-bench DEFINES=CRC16_CONF_TABLE=CRC16_TABLE_BYTE
+ */
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "dev/watchdog.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef CRC16_BENCH_CONF_OPERATIONS
+#define CRC16_BENCH_OPERATIONS CRC16_BENCH_CONF_OPERATIONS
+#else
+#define CRC16_BENCH_OPERATIONS 100000UL
+#endif
+
+#define FRAME_LEN 127
+/*---------------------------------------------------------------------------*/
+PROCESS(crc16_bench_process, "CRC16 benchmark");
+AUTOSTART_PROCESSES(&crc16_bench_process);
+/*---------------------------------------------------------------------------*/
+/* CRC-16/KERMIT check value */
+static const unsigned char check_data[9] = "123456789";
+#define CHECK_CRC 0x2189
+
+static unsigned char frame[FRAME_LEN];
+
+/* Keeps the compiler from optimizing the measured calls away */
+static volatile unsigned short sink;
+/*---------------------------------------------------------------------------*/
+static int
+check_crc16(void)
+{
+  unsigned short crc;
+  int i;
+
+  if(crc16_data(check_data, sizeof(check_data), 0) != CHECK_CRC) {
+    return 0;
+  }
+
+  crc = 0;
+  for(i = 0; i < sizeof(check_data); i++) {
+    crc = crc16_add(check_data[i], crc);
+  }
+  return crc == CHECK_CRC;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *what, unsigned long bytes, clock_time_t ticks)
+{
+  if(ticks == 0) {
+    ticks = 1;
+  }
+  printf("%s: %lu bytes in %lu ticks, %lu ns per byte\n", what, bytes,
+         (unsigned long)ticks,
+         (unsigned long)((unsigned long long)ticks * 1000000000ULL /
+                         CLOCK_SECOND / bytes));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(crc16_bench_process, ev, data)
+{
+  clock_time_t start;
+  unsigned long n;
+  unsigned short crc;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < FRAME_LEN; i++) {
+    frame[i] = i * 131 + 7;
+  }
+
+  printf("CRC16 benchmark, table %u, %lu frames of %u bytes per run, "
+         "CLOCK_SECOND %lu\n", CRC16_TABLE,
+         (unsigned long)CRC16_BENCH_OPERATIONS, FRAME_LEN,
+         (unsigned long)CLOCK_SECOND);
+  printf("CRC16 known answer: %s\n", check_crc16() ? "ok" : "FAILED");
+
+  start = clock_time();
+  for(n = 0; n < CRC16_BENCH_OPERATIONS; n++) {
+    sink = crc16_data(frame, FRAME_LEN, n);
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  report("crc16_data", CRC16_BENCH_OPERATIONS * FRAME_LEN,
+         clock_time() - start);
+
+  /* As a radio driver would, one byte at a time */
+  start = clock_time();
+  for(n = 0; n < CRC16_BENCH_OPERATIONS; n++) {
+    crc = n;
+    for(i = 0; i < FRAME_LEN; i++) {
+      crc = crc16_add(frame[i], crc);
+    }
+    sink = crc;
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  report("crc16_add", CRC16_BENCH_OPERATIONS * FRAME_LEN,
+         clock_time() - start);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
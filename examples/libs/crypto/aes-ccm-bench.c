@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*
+ * Measures the throughput of the AES-128 driver and of CCM* on top of
+ * it, after checking both against known answers. Build with a different
+ * AES_128_CONF to compare drivers, e.g.:
+ *
+ * make TARGET=native aes-ccm-bench DEFINES=AES_128_CONF=aes_128_ttable_driver
+ * make TARGET=native aes-ccm-bench DEFINES=AES_128_CONF=native_aes_128_driver
+ */
+#include "contiki.h"
+#include "lib/aes-128.h"
+#include "lib/ccm-star.h"
+#include "dev/watchdog.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef AES_CCM_BENCH_CONF_OPERATIONS
+#define AES_CCM_BENCH_OPERATIONS AES_CCM_BENCH_CONF_OPERATIONS
+#else
+#define AES_CCM_BENCH_OPERATIONS 100000UL
+#endif
+
+/* A typical 802.15.4 frame: header authenticated, payload encrypted */
+#define FRAME_HEADER_LEN  21
+#define FRAME_PAYLOAD_LEN 96
+#define FRAME_MIC_LEN      8
+/*---------------------------------------------------------------------------*/
+PROCESS(aes_ccm_bench_process, "AES-128 and CCM* benchmark");
+AUTOSTART_PROCESSES(&aes_ccm_bench_process);
+/*---------------------------------------------------------------------------*/
+/* FIPS-197, appendix C.1 */
+static const uint8_t aes_key[16] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t aes_plaintext[16] = {
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t aes_ciphertext[16] = {
+  0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+  0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+/* RFC 3610, packet vector #1 */
+static const uint8_t ccm_key[16] = {
+  0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+  0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+};
+static const uint8_t ccm_nonce[CCM_STAR_NONCE_LENGTH] = {
+  0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00,
+  0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5
+};
+static const uint8_t ccm_header[8] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07
+};
+static const uint8_t ccm_plaintext[23] = {
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+  0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e
+};
+static const uint8_t ccm_ciphertext[23] = {
+  0x58, 0x8c, 0x97, 0x9a, 0x61, 0xc6, 0x63, 0xd2,
+  0xf0, 0x66, 0xd0, 0xc2, 0xc0, 0xf9, 0x89, 0x80,
+  0x6d, 0x5f, 0x6b, 0x61, 0xda, 0xc3, 0x84
+};
+static const uint8_t ccm_mic[8] = {
+  0x17, 0xe8, 0xd1, 0x2c, 0xfd, 0xf9, 0x26, 0xe0
+};
+/*---------------------------------------------------------------------------*/
+static int
+check_aes(void)
+{
+  uint8_t block[16];
+
+  memcpy(block, aes_plaintext, sizeof(block));
+  AES_128.set_key(aes_key);
+  AES_128.encrypt(block);
+  return memcmp(block, aes_ciphertext, sizeof(block)) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_ccm(void)
+{
+  uint8_t m[sizeof(ccm_plaintext)];
+  uint8_t mic[sizeof(ccm_mic)];
+
+  memcpy(m, ccm_plaintext, sizeof(m));
+  CCM_STAR.set_key(ccm_key);
+  CCM_STAR.aead(ccm_nonce, m, sizeof(m), ccm_header, sizeof(ccm_header),
+                mic, sizeof(mic), 1);
+  if(memcmp(m, ccm_ciphertext, sizeof(m)) || memcmp(mic, ccm_mic, sizeof(mic))) {
+    return 0;
+  }
+
+  CCM_STAR.aead(ccm_nonce, m, sizeof(m), ccm_header, sizeof(ccm_header),
+                mic, sizeof(mic), 0);
+  return memcmp(m, ccm_plaintext, sizeof(m)) == 0
+    && memcmp(mic, ccm_mic, sizeof(mic)) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *what, unsigned long bytes, clock_time_t ticks)
+{
+  if(ticks == 0) {
+    ticks = 1;
+  }
+  printf("%s: %lu bytes in %lu ticks, %lu kB/s\n", what, bytes,
+         (unsigned long)ticks,
+         (unsigned long)(bytes / ticks * CLOCK_SECOND / 1000));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(aes_ccm_bench_process, ev, data)
+{
+  static uint8_t frame[FRAME_HEADER_LEN + FRAME_PAYLOAD_LEN + FRAME_MIC_LEN];
+  uint8_t nonce[CCM_STAR_NONCE_LENGTH];
+  uint8_t block[16];
+  clock_time_t start;
+  unsigned long n;
+  int forward;
+
+  PROCESS_BEGIN();
+
+  printf("AES-128 and CCM* benchmark, %lu operations per run, "
+         "CLOCK_SECOND %lu\n", (unsigned long)AES_CCM_BENCH_OPERATIONS,
+         (unsigned long)CLOCK_SECOND);
+  printf("AES-128 known answer: %s\n", check_aes() ? "ok" : "FAILED");
+  printf("CCM* known answer: %s\n", check_ccm() ? "ok" : "FAILED");
+
+  memset(block, 0, sizeof(block));
+  AES_128.set_key(aes_key);
+  start = clock_time();
+  for(n = 0; n < AES_CCM_BENCH_OPERATIONS; n++) {
+    AES_128.encrypt(block);
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  report("AES-128 blocks", AES_CCM_BENCH_OPERATIONS * 16, clock_time() - start);
+
+  memset(frame, 0, sizeof(frame));
+  memset(nonce, 0, sizeof(nonce));
+  CCM_STAR.set_key(ccm_key);
+  for(forward = 1; forward >= 0; forward--) {
+    start = clock_time();
+    for(n = 0; n < AES_CCM_BENCH_OPERATIONS / 8; n++) {
+      nonce[0] = n;
+      CCM_STAR.aead(nonce, frame + FRAME_HEADER_LEN, FRAME_PAYLOAD_LEN,
+                    frame, FRAME_HEADER_LEN,
+                    frame + FRAME_HEADER_LEN + FRAME_PAYLOAD_LEN, FRAME_MIC_LEN,
+                    forward);
+      if((n & 0x3ff) == 0) {
+        watchdog_periodic();
+      }
+    }
+    report(forward ? "CCM* frames, encryption" : "CCM* frames, decryption",
+           AES_CCM_BENCH_OPERATIONS / 8 * sizeof(frame), clock_time() - start);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*
+ * Measures the cost of nbr_table_get_from_lladdr() for tables holding
+ * 16, 64 and 256 neighbors (capped at NBR_TABLE_MAX_NEIGHBORS), both for
+ * addresses in the table and for unknown ones. Build once with and once
+ * without NBR_TABLE_CONF_WITH_HASH to compare the two lookup modes, e.g.:
+ *
+ * make TARGET=native nbr-table-bench \
+ *   DEFINES=NBR_TABLE_CONF_MAX_NEIGHBORS=256,NBR_TABLE_CONF_WITH_HASH=1
+ */
+#include "contiki.h"
+#include "net/nbr-table.h"
+#include "dev/watchdog.h"
+
+#include <string.h>
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#ifdef NBR_TABLE_BENCH_CONF_LOOKUPS
+#define NBR_TABLE_BENCH_LOOKUPS NBR_TABLE_BENCH_CONF_LOOKUPS
+#else
+#define NBR_TABLE_BENCH_LOOKUPS 100000UL
+#endif
+/*---------------------------------------------------------------------------*/
+PROCESS(nbr_table_bench_process, "Neighbor table benchmark");
+AUTOSTART_PROCESSES(&nbr_table_bench_process);
+/*---------------------------------------------------------------------------*/
+NBR_TABLE(uint8_t, bench_table);
+static const unsigned sizes[] = { 16, 64, 256 };
+/*---------------------------------------------------------------------------*/
+static void
+make_lladdr(linkaddr_t *lladdr, unsigned i, uint8_t present)
+{
+  memset(lladdr, 0, sizeof(linkaddr_t));
+  lladdr->u8[0] = present ? 0x02 : 0x06;
+  lladdr->u8[LINKADDR_SIZE - 2] = i >> 8;
+  lladdr->u8[LINKADDR_SIZE - 1] = i & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+run_lookups(unsigned count, uint8_t present, unsigned long *found)
+{
+  linkaddr_t lladdr;
+  clock_time_t start;
+  unsigned long n;
+
+  *found = 0;
+  start = clock_time();
+  for(n = 0; n < NBR_TABLE_BENCH_LOOKUPS; n++) {
+    make_lladdr(&lladdr, n % count, present);
+    if(nbr_table_get_from_lladdr(bench_table, &lladdr) != NULL) {
+      (*found)++;
+    }
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  return clock_time() - start;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(nbr_table_bench_process, ev, data)
+{
+  static unsigned filled;
+  linkaddr_t lladdr;
+  unsigned long hits, misses;
+  clock_time_t hit_ticks, miss_ticks;
+  unsigned i;
+
+  PROCESS_BEGIN();
+
+  nbr_table_register(bench_table, NULL);
+
+  printf("Neighbor table benchmark: %s lookup, %lu lookups per run, "
+         "CLOCK_SECOND %lu\n", NBR_TABLE_WITH_HASH ? "hash" : "list",
+         (unsigned long)NBR_TABLE_BENCH_LOOKUPS, (unsigned long)CLOCK_SECOND);
+
+  filled = 0;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    if(sizes[i] > NBR_TABLE_MAX_NEIGHBORS) {
+      printf("%u neighbors: skipped, NBR_TABLE_MAX_NEIGHBORS is %u\n",
+             sizes[i], (unsigned)NBR_TABLE_MAX_NEIGHBORS);
+      continue;
+    }
+
+    for(; filled < sizes[i]; filled++) {
+      make_lladdr(&lladdr, filled, 1);
+      nbr_table_add_lladdr(bench_table, &lladdr,
+                           NBR_TABLE_REASON_UNDEFINED, NULL);
+    }
+
+    hit_ticks = run_lookups(sizes[i], 1, &hits);
+    miss_ticks = run_lookups(sizes[i], 0, &misses);
+    printf("%u neighbors: hits %lu in %lu ticks, unknown %lu in %lu ticks\n",
+           sizes[i], hits, (unsigned long)hit_ticks,
+           NBR_TABLE_BENCH_LOOKUPS - misses, (unsigned long)miss_ticks);
+
+    /* Let the rest of the system run between two sizes */
+    PROCESS_PAUSE();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Measures the cost of setting event timers and of polling the event
+ * timer process while 16, 64 and 256 timers are pending, and the time it
+ * takes for a batch of timers to expire. Build once with and once
+ * without ETIMER_CONF_WHEEL to compare the timer list with the timer
+ * wheel, e.g.:
+ *
+ * make TARGET=native etimer-bench DEFINES=ETIMER_CONF_WHEEL=1
+ */
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "dev/watchdog.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#ifdef ETIMER_BENCH_CONF_OPERATIONS
+#define ETIMER_BENCH_OPERATIONS ETIMER_BENCH_CONF_OPERATIONS
+#else
+#define ETIMER_BENCH_OPERATIONS 100000UL
+#endif
+
+#define ETIMER_BENCH_MAX_TIMERS 256
+/*---------------------------------------------------------------------------*/
+PROCESS(etimer_bench_process, "Event timer benchmark");
+AUTOSTART_PROCESSES(&etimer_bench_process);
+/*---------------------------------------------------------------------------*/
+static struct etimer timers[ETIMER_BENCH_MAX_TIMERS];
+static const unsigned sizes[] = { 16, 64, 256 };
+/*---------------------------------------------------------------------------*/
+/* A spread of intervals between 10 and 60 seconds, none expiring during
+   the measurements */
+static clock_time_t
+interval(unsigned long n)
+{
+  return 10 * CLOCK_SECOND + (n * 7919) % (50 * CLOCK_SECOND);
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+run_sets(unsigned count)
+{
+  clock_time_t start;
+  unsigned long n;
+
+  start = clock_time();
+  for(n = 0; n < ETIMER_BENCH_OPERATIONS; n++) {
+    etimer_set(&timers[n % count], interval(n));
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  return clock_time() - start;
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+run_polls(void)
+{
+  clock_time_t start;
+  unsigned long n;
+
+  start = clock_time();
+  for(n = 0; n < ETIMER_BENCH_OPERATIONS; n++) {
+    process_post_synch(&etimer_process, PROCESS_EVENT_POLL, NULL);
+    if((n & 0x3ff) == 0) {
+      watchdog_periodic();
+    }
+  }
+  return clock_time() - start;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(etimer_bench_process, ev, data)
+{
+  static clock_time_t start;
+  static unsigned expired;
+  static unsigned i;
+  clock_time_t set_ticks, poll_ticks;
+  unsigned j;
+
+  PROCESS_BEGIN();
+
+  printf("Event timer benchmark: %s, %lu operations per run, "
+         "CLOCK_SECOND %lu\n", ETIMER_WHEEL ? "timer wheel" : "timer list",
+         (unsigned long)ETIMER_BENCH_OPERATIONS, (unsigned long)CLOCK_SECOND);
+
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for(j = 0; j < sizes[i]; j++) {
+      etimer_set(&timers[j], interval(j));
+    }
+
+    set_ticks = run_sets(sizes[i]);
+    poll_ticks = run_polls();
+    printf("%u timers: %lu sets in %lu ticks, %lu polls in %lu ticks\n",
+           sizes[i], (unsigned long)ETIMER_BENCH_OPERATIONS,
+           (unsigned long)set_ticks, (unsigned long)ETIMER_BENCH_OPERATIONS,
+           (unsigned long)poll_ticks);
+
+    /* Let the whole batch expire within one second and wait for it */
+    for(j = 0; j < sizes[i]; j++) {
+      etimer_set(&timers[j], 1 + j % CLOCK_SECOND);
+    }
+    start = clock_time();
+    for(expired = 0; expired < sizes[i];) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+      expired++;
+    }
+    printf("%u timers: all expired after %lu ticks\n",
+           sizes[i], (unsigned long)(clock_time() - start));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -69,4 +69,10 @@ struct aes_128_driver {
 
 extern const struct aes_128_driver AES_128;
 
+/**
+ * Software AES with a 32-bit T-table, faster than the default driver on
+ * 32-bit and 64-bit CPUs at the cost of 1 KB of constant data.
+ */
+extern const struct aes_128_driver aes_128_ttable_driver;
+
 #endif /* AES_128_H_ */
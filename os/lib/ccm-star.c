@@ -59,47 +59,28 @@ set_iv(uint8_t *iv,
   iv[15] = counter;
 }
 /*---------------------------------------------------------------------------*/
-/* XORs the block m[pos] ... m[pos + 15] with K_{counter} */
+/* Starts the CBC-MAC in x, with B_0 and the additional authenticated data */
 static void
-ctr_step(const uint8_t *nonce,
-    uint8_t pos,
-    uint8_t *m_and_result,
+mic_start(const uint8_t *nonce,
     uint8_t m_len,
-    uint8_t counter)
-{
-  uint8_t a[AES_128_BLOCK_SIZE];
-  uint8_t i;
-  
-  set_iv(a, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter);
-  AES_128.encrypt(a);
-  
-  for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-    m_and_result[pos + i] ^= a[i];
-  }
-}
-/*---------------------------------------------------------------------------*/
-static void
-mic(const uint8_t *nonce,
-    const uint8_t *m, uint8_t m_len,
     const uint8_t *a, uint8_t a_len,
-    uint8_t *result,
-    uint8_t mic_len)
+    uint8_t mic_len,
+    uint8_t *x)
 {
-  uint8_t x[AES_128_BLOCK_SIZE];
-  uint8_t pos;
+  uint16_t pos;
   uint8_t i;
-  
+
   set_iv(x, CCM_STAR_AUTH_FLAGS(a_len, mic_len), nonce, m_len);
   AES_128.encrypt(x);
-  
+
   if(a_len) {
     x[1] = x[1] ^ a_len;
     for(i = 2; (i - 2 < a_len) && (i < AES_128_BLOCK_SIZE); i++) {
       x[i] ^= a[i - 2];
     }
-    
+
     AES_128.encrypt(x);
-    
+
     pos = 14;
     while(pos < a_len) {
       for(i = 0; (pos + i < a_len) && (i < AES_128_BLOCK_SIZE); i++) {
@@ -109,35 +90,6 @@ mic(const uint8_t *nonce,
       AES_128.encrypt(x);
     }
   }
-  
-  if(m_len) {
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-        x[i] ^= m[pos + i];
-      }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
-    }
-  }
-  
-  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
-  
-  memcpy(result, x, mic_len);
-}
-/*---------------------------------------------------------------------------*/
-static void
-ctr(const uint8_t *nonce, uint8_t *m, uint8_t m_len)
-{
-  uint8_t pos;
-  uint8_t counter;
-  
-  pos = 0;
-  counter = 1;
-  while(pos < m_len) {
-    ctr_step(nonce, pos, m, m_len, counter++);
-    pos += AES_128_BLOCK_SIZE;
-  }
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -146,6 +98,11 @@ set_key(const uint8_t *key)
   AES_128.set_key(key);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Authenticates and encrypts, or decrypts and authenticates, in a single
+ * pass over m: each block goes into the CBC-MAC and is XORed with its
+ * key stream block before moving on to the next one.
+ */
 static void
 aead(const uint8_t* nonce,
     uint8_t* m, uint8_t m_len,
@@ -153,20 +110,40 @@ aead(const uint8_t* nonce,
     uint8_t *result, uint8_t mic_len,
     int forward)
 {
-  if(!forward) {
-    /* decrypt */
-    ctr(nonce, m, m_len);
+  uint8_t x[AES_128_BLOCK_SIZE];
+  uint8_t k[AES_128_BLOCK_SIZE];
+  uint16_t pos;
+  uint8_t counter;
+  uint8_t len;
+  uint8_t i;
+
+  mic_start(nonce, m_len, a, a_len, mic_len, x);
+
+  counter = 1;
+  for(pos = 0; pos < m_len; pos += AES_128_BLOCK_SIZE) {
+    len = MIN(m_len - pos, AES_128_BLOCK_SIZE);
+    set_iv(k, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter++);
+    AES_128.encrypt(k);
+
+    if(forward) {
+      for(i = 0; i < len; i++) {
+        x[i] ^= m[pos + i];
+        m[pos + i] ^= k[i];
+      }
+    } else {
+      for(i = 0; i < len; i++) {
+        m[pos + i] ^= k[i];
+        x[i] ^= m[pos + i];
+      }
+    }
+    AES_128.encrypt(x);
   }
-  
-  mic(nonce,
-    m, m_len,
-    a, a_len,
-    result,
-    mic_len);
-  
-  if(forward) {
-    /* encrypt */
-    ctr(nonce, m, m_len);
+
+  /* The MIC is the CBC-MAC encrypted with K_0 */
+  set_iv(k, CCM_STAR_ENCRYPTION_FLAGS, nonce, 0);
+  AES_128.encrypt(k);
+  for(i = 0; i < mic_len; i++) {
+    result[i] = x[i] ^ k[i];
   }
 }
 /*---------------------------------------------------------------------------*/
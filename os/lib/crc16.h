@@ -55,6 +55,32 @@
 #ifndef CRC16_H_
 #define CRC16_H_
 
+#include "contiki.h"
+
+/**
+ * \name CRC16 implementation selection
+ *
+ * By default, the CRC is updated with a few shifts and XORs per byte,
+ * which needs no table. CRC16_CONF_TABLE selects a table-driven update
+ * instead: CRC16_TABLE_NIBBLE looks up each half byte in a 32-byte
+ * table, and CRC16_TABLE_BYTE looks up each byte in a 512-byte table.
+ * The result is the same with all three.
+ *
+ * A platform with a CRC unit that computes the same CRC can define
+ * CRC16_ARCH_DATA and provide its own crc16_data().
+ * @{
+ */
+#define CRC16_TABLE_NONE   0
+#define CRC16_TABLE_NIBBLE 1
+#define CRC16_TABLE_BYTE   2
+
+#ifdef CRC16_CONF_TABLE
+#define CRC16_TABLE CRC16_CONF_TABLE
+#else
+#define CRC16_TABLE CRC16_TABLE_NONE
+#endif
+/** @} */
+
 /**
  * \brief      Update an accumulated CRC16 checksum with one byte.
  * \param b    The byte to be added to the checksum
@@ -65,11 +91,6 @@
  *             with one byte. It can be used as a running checksum, or
  *             to checksum an entire data block.
  *
- *             \note The algorithm used in this implementation is
- *             tailored for a running checksum and does not perform as
- *             well as a table-driven algorithm when checksumming an
- *             entire data block.
- *
  */
 unsigned short crc16_add(unsigned char b, unsigned short crc);
 
@@ -82,10 +103,10 @@ unsigned short crc16_add(unsigned char b, unsigned short crc);
  *
  *             This function calculates the CRC16 checksum of a data area.
  *
- *             \note The algorithm used in this implementation is
- *             tailored for a running checksum and does not perform as
- *             well as a table-driven algorithm when checksumming an
- *             entire data block.
+ *             \note Unless CRC16_CONF_TABLE is set, the algorithm used
+ *             in this implementation is tailored for a running
+ *             checksum and does not perform as well as a table-driven
+ *             algorithm when checksumming an entire data block.
  */
 unsigned short crc16_data(const unsigned char *data, int datalen,
 			  unsigned short acc);
@@ -119,12 +119,31 @@
 
 /* Macros for determining the status of a chunk. */
 #define CHUNK_FLAG_ALLOCATED		0x1
+/* Chunk of a size class that is kept on the free list of the class. */
+#define CHUNK_FLAG_CACHED		0x2
 
 #define CHUNK_ALLOCATED(chunk)			\
   ((chunk)->flags & CHUNK_FLAG_ALLOCATED)
 #define CHUNK_FREE(chunk)			\
   (~(chunk)->flags & CHUNK_FLAG_ALLOCATED)
 
+#if HEAPMEM_SIZE_CLASSES > 0
+#if HEAPMEM_SIZE_CLASSES > 63
+#error "HEAPMEM_CONF_SIZE_CLASSES must be at most 63"
+#endif
+
+/* The remaining flag bits hold the size class of a chunk plus one, or
+   zero if the chunk does not belong to a size class. */
+#define CHUNK_CLASS_SHIFT		2
+#define CHUNK_CLASS(chunk)			\
+  ((int)((chunk)->flags >> CHUNK_CLASS_SHIFT) - 1)
+#define CLASS_FLAGS(class)			\
+  ((uint8_t)(((class) + 1) << CHUNK_CLASS_SHIFT))
+
+#define CLASS_SIZE(class)			\
+  ((size_t)ALIGN(HEAPMEM_SIZE_CLASS_MIN) << (class))
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
 /*
  * We use a double-linked list of chunks, with a slight space overhead compared
  * to a single-linked list, but with the advantage of having much faster
@@ -149,6 +168,13 @@ static size_t heap_usage;
 static chunk_t *first_chunk = (chunk_t *)heap_base;
 static chunk_t *free_list;
 
+#if HEAPMEM_SIZE_CLASSES > 0
+/* Free chunks of each size class, single-linked through next. */
+static chunk_t *class_free_list[HEAPMEM_SIZE_CLASSES];
+static size_t class_allocated[HEAPMEM_SIZE_CLASSES];
+static size_t class_cached[HEAPMEM_SIZE_CLASSES];
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
 /* extend_space: Increases the current footprint used in the heap, and
    returns a pointer to the old end. */
 static void *
@@ -306,6 +332,98 @@ get_free_chunk(const size_t size)
   return best;
 }
 
+#if HEAPMEM_SIZE_CLASSES > 0
+/* get_size_class: Return the smallest size class that fits an aligned
+   size, or -1 if the size is too large for all of them. */
+static int
+get_size_class(const size_t size)
+{
+  int class;
+
+  for(class = 0; class < HEAPMEM_SIZE_CLASSES; class++) {
+    if(size <= CLASS_SIZE(class)) {
+      return class;
+    }
+  }
+  return -1;
+}
+
+/* release_cached_chunks: Give all chunks on the size class free lists
+   back to the chunk allocator. Returns non-zero if any chunk was
+   released. */
+static int
+release_cached_chunks(void)
+{
+  int class;
+  int released;
+  chunk_t *chunk;
+
+  released = 0;
+  for(class = 0; class < HEAPMEM_SIZE_CLASSES; class++) {
+    while(class_free_list[class] != NULL) {
+      chunk = class_free_list[class];
+      class_free_list[class] = chunk->next;
+      chunk->flags = CHUNK_FLAG_ALLOCATED;
+      free_chunk(chunk);
+      released = 1;
+    }
+    class_cached[class] = 0;
+  }
+  return released;
+}
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
+/* alloc_chunk: Allocate a chunk from the free list, or else from the
+   unused space at the end of the heap. */
+static chunk_t *
+alloc_chunk(const size_t size)
+{
+  chunk_t *chunk;
+
+  chunk = get_free_chunk(size);
+  if(chunk == NULL) {
+    chunk = extend_space(sizeof(chunk_t) + size);
+    if(chunk != NULL) {
+      chunk->size = size;
+    }
+  }
+
+#if HEAPMEM_SIZE_CLASSES > 0
+  if(chunk == NULL && release_cached_chunks()) {
+    /* Try again with the memory that the size classes held. */
+    return alloc_chunk(size);
+  }
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
+  return chunk;
+}
+
+#if HEAPMEM_SIZE_CLASSES > 0
+/* get_class_chunk: Take a chunk from the free list of a size class,
+   or allocate a new chunk of the class size. */
+static chunk_t *
+get_class_chunk(const int class)
+{
+  chunk_t *chunk;
+
+  chunk = class_free_list[class];
+  if(chunk != NULL) {
+    class_free_list[class] = chunk->next;
+    class_cached[class]--;
+  } else {
+    chunk = alloc_chunk(CLASS_SIZE(class));
+    if(chunk == NULL) {
+      return NULL;
+    }
+  }
+
+  chunk->flags = CHUNK_FLAG_ALLOCATED | CLASS_FLAGS(class);
+  class_allocated[class]++;
+
+  return chunk;
+}
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
 /*
  * heapmem_alloc: Allocate an object of the specified size, returning
  * a pointer to it in case of success, and NULL in case of failure.
@@ -319,6 +437,11 @@ get_free_chunk(const size_t size)
  *
  * As a last resort, heapmem_alloc() will try to extend the heap
  * space, and thereby create a new chunk available for use.
+ *
+ * With size classes, a request that fits in a class is first served
+ * from the free list of that class. Otherwise, a chunk of the full
+ * class size is allocated as above, and if that fails, a chunk of the
+ * requested size.
  */
 void *
 #if HEAPMEM_DEBUG
@@ -328,20 +451,28 @@ heapmem_alloc(size_t size)
 #endif
 {
   chunk_t *chunk;
+#if HEAPMEM_SIZE_CLASSES > 0
+  int class;
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
 
   size = ALIGN(size);
+  chunk = NULL;
+
+#if HEAPMEM_SIZE_CLASSES > 0
+  class = get_size_class(size);
+  if(class >= 0) {
+    chunk = get_class_chunk(class);
+  }
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
 
-  chunk = get_free_chunk(size);
   if(chunk == NULL) {
-    chunk = extend_space(sizeof(chunk_t) + size);
+    chunk = alloc_chunk(size);
     if(chunk == NULL) {
       return NULL;
     }
-    chunk->size = size;
+    chunk->flags = CHUNK_FLAG_ALLOCATED;
   }
 
-  chunk->flags = CHUNK_FLAG_ALLOCATED;
-
 #if HEAPMEM_DEBUG
   chunk->file = file;
   chunk->line = line;
@@ -379,6 +510,18 @@ heapmem_free(void *ptr)
     PRINTF("%s ptr %p, allocated at %s:%u\n", __func__, ptr,
            chunk->file, chunk->line);
 
+#if HEAPMEM_SIZE_CLASSES > 0
+    if(CHUNK_CLASS(chunk) >= 0) {
+      /* Keep the chunk for the next allocation of its size class. */
+      chunk->flags |= CHUNK_FLAG_CACHED;
+      chunk->next = class_free_list[CHUNK_CLASS(chunk)];
+      class_free_list[CHUNK_CLASS(chunk)] = chunk;
+      class_allocated[CHUNK_CLASS(chunk)]--;
+      class_cached[CHUNK_CLASS(chunk)]++;
+      return;
+    }
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
     free_chunk(chunk);
   }
 }
@@ -430,6 +573,23 @@ heapmem_realloc(void *ptr, size_t size)
 #endif
 
   size = ALIGN(size);
+
+#if HEAPMEM_SIZE_CLASSES > 0
+  if(CHUNK_CLASS(chunk) >= 0) {
+    /* Chunks of a size class keep their size, so the object either
+       still fits or moves to a new chunk. */
+    if(size <= chunk->size) {
+      return ptr;
+    }
+    newptr = heapmem_alloc(size);
+    if(newptr != NULL) {
+      memcpy(newptr, ptr, chunk->size);
+      heapmem_free(ptr);
+    }
+    return newptr;
+  }
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
+
   size_adj = size - chunk->size;
 
   if(size_adj <= 0) {
@@ -488,6 +648,9 @@ void
 heapmem_stats(heapmem_stats_t *stats)
 {
   chunk_t *chunk;
+#if HEAPMEM_SIZE_CLASSES > 0
+  int class;
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
 
   memset(stats, 0, sizeof(*stats));
 
@@ -495,14 +658,32 @@ heapmem_stats(heapmem_stats_t *stats)
       (char *)chunk < &heap_base[heap_usage];
       chunk = NEXT_CHUNK(chunk)) {
     if(CHUNK_ALLOCATED(chunk)) {
-      stats->allocated += chunk->size;
+      if(!(chunk->flags & CHUNK_FLAG_CACHED)) {
+        stats->allocated += chunk->size;
+      }
     } else {
       coalesce_chunks(chunk);
       stats->available += chunk->size;
+      stats->free_chunks++;
+      if(chunk->size > stats->max_available) {
+        stats->max_available = chunk->size;
+      }
     }
     stats->overhead += sizeof(chunk_t);
   }
   stats->available += HEAPMEM_ARENA_SIZE - heap_usage;
+  if(HEAPMEM_ARENA_SIZE - heap_usage > sizeof(chunk_t) &&
+     HEAPMEM_ARENA_SIZE - heap_usage - sizeof(chunk_t) > stats->max_available) {
+    stats->max_available = HEAPMEM_ARENA_SIZE - heap_usage - sizeof(chunk_t);
+  }
   stats->footprint = heap_usage;
   stats->chunks = stats->overhead / sizeof(chunk_t);
+
+#if HEAPMEM_SIZE_CLASSES > 0
+  for(class = 0; class < HEAPMEM_SIZE_CLASSES; class++) {
+    stats->classes[class].size = CLASS_SIZE(class);
+    stats->classes[class].allocated = class_allocated[class];
+    stats->classes[class].cached = class_cached[class];
+  }
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
 }
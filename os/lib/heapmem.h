@@ -52,6 +52,15 @@
  * heapmem_realloc(), because the chunk structure immediately precedes
  * the memory of the chunk.
  *
+ * Optionally, small allocations can be served from size classes by
+ * setting HEAPMEM_CONF_SIZE_CLASSES to the number of classes. The
+ * classes hold chunks of HEAPMEM_CONF_SIZE_CLASS_MIN bytes, twice that,
+ * and so on. A freed chunk of a size class is kept on a free list of
+ * that class, from which the next allocation of the class is taken in
+ * constant time. Larger allocations use the chunk allocator as before.
+ * Chunks kept on the class free lists are handed back to the chunk
+ * allocator only when an allocation would otherwise fail.
+ *
  * \note This module does not contain a corresponding function to the
  *       standard C function calloc().
  *
@@ -76,12 +85,39 @@
 
 #include <stdlib.h>
 
+#ifdef HEAPMEM_CONF_SIZE_CLASSES
+#define HEAPMEM_SIZE_CLASSES HEAPMEM_CONF_SIZE_CLASSES
+#else
+#define HEAPMEM_SIZE_CLASSES 0
+#endif /* HEAPMEM_CONF_SIZE_CLASSES */
+
+#ifdef HEAPMEM_CONF_SIZE_CLASS_MIN
+#define HEAPMEM_SIZE_CLASS_MIN HEAPMEM_CONF_SIZE_CLASS_MIN
+#else
+#define HEAPMEM_SIZE_CLASS_MIN 16
+#endif /* HEAPMEM_CONF_SIZE_CLASS_MIN */
+
 typedef struct heapmem_stats {
   size_t allocated;
   size_t overhead;
   size_t available;
   size_t footprint;
   size_t chunks;
+  /* The number of free chunks, and the largest contiguous block that
+     can be allocated. Together with available, they indicate how
+     fragmented the heap is. */
+  size_t free_chunks;
+  size_t max_available;
+#if HEAPMEM_SIZE_CLASSES > 0
+  /* Per size class: the chunk size, and the number of chunks that are
+     allocated and kept on the free list of the class. The memory of
+     the latter is counted neither as allocated nor as available. */
+  struct {
+    size_t size;
+    size_t allocated;
+    size_t cached;
+  } classes[HEAPMEM_SIZE_CLASSES];
+#endif /* HEAPMEM_SIZE_CLASSES > 0 */
 } heapmem_stats_t;
 
 #if HEAPMEM_DEBUG
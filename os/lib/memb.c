@@ -47,12 +47,70 @@
 #include "contiki.h"
 #include "lib/memb.h"
 
+/*---------------------------------------------------------------------------*/
+#if MEMB_WITH_FREE_LIST
+#define NEXT_FREE(m, i)          ((unsigned short)((m)->links[i] + (i) + 1))
+#define SET_NEXT_FREE(m, i, n)   ((m)->links[i] = (unsigned short)((n) - (i) - 1))
+#endif /* MEMB_WITH_FREE_LIST */
+
+#if MEMB_STATS
+static struct memb *memb_list;
+/*---------------------------------------------------------------------------*/
+static void
+register_memb(struct memb *m)
+{
+  if(!m->registered) {
+    m->registered = 1;
+    m->next = memb_list;
+    memb_list = m;
+  }
+}
+#endif /* MEMB_STATS */
 /*---------------------------------------------------------------------------*/
 void
 memb_init(struct memb *m)
 {
   memset(m->count, 0, m->num);
   memset(m->mem, 0, m->size * m->num);
+#if MEMB_WITH_FREE_LIST
+  memset(m->links, 0, m->num * sizeof(m->links[0]));
+  m->free = 0;
+#endif /* MEMB_WITH_FREE_LIST */
+#if MEMB_WITH_FREE_LIST || MEMB_STATS
+  m->used = 0;
+#endif /* MEMB_WITH_FREE_LIST || MEMB_STATS */
+#if MEMB_STATS
+  m->peak = 0;
+  register_memb(m);
+#endif /* MEMB_STATS */
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the index of the block to which "ptr" points, or -1 */
+static int
+block_index(struct memb *m, void *ptr)
+{
+  int i;
+  char *ptr2;
+
+#if MEMB_WITH_FREE_LIST
+  if(!memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  i = ((char *)ptr - (char *)m->mem) / m->size;
+  ptr2 = (char *)m->mem + (i * m->size);
+  return ptr2 == (char *)ptr ? i : -1;
+#else /* MEMB_WITH_FREE_LIST */
+  /* Walk through the list of blocks and try to find the block to
+     which the pointer "ptr" points to. */
+  ptr2 = (char *)m->mem;
+  for(i = 0; i < m->num; ++i) {
+    if(ptr2 == (char *)ptr) {
+      return i;
+    }
+    ptr2 += m->size;
+  }
+  return -1;
+#endif /* MEMB_WITH_FREE_LIST */
 }
 /*---------------------------------------------------------------------------*/
 void *
@@ -60,44 +118,71 @@ memb_alloc(struct memb *m)
 {
   int i;
 
+#if MEMB_STATS
+  register_memb(m);
+#endif /* MEMB_STATS */
+
+#if MEMB_WITH_FREE_LIST
+  /* Take the first block off the free list. */
+  i = m->free;
+  if(i >= m->num) {
+    return NULL;
+  }
+  m->free = NEXT_FREE(m, i);
+#else /* MEMB_WITH_FREE_LIST */
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
-      /* If this block was unused, we increase the reference count to
-	 indicate that it now is used and return a pointer to the
-	 memory block. */
-      ++(m->count[i]);
-      return (void *)((char *)m->mem + (i * m->size));
+      break;
     }
   }
+  if(i == m->num) {
+    /* No free block was found, so we return NULL to indicate failure to
+       allocate block. */
+    return NULL;
+  }
+#endif /* MEMB_WITH_FREE_LIST */
 
-  /* No free block was found, so we return NULL to indicate failure to
-     allocate block. */
-  return NULL;
+  /* This block was unused, so we increase the reference count to
+     indicate that it now is used and return a pointer to the memory
+     block. */
+  ++(m->count[i]);
+#if MEMB_WITH_FREE_LIST || MEMB_STATS
+  m->used++;
+#endif /* MEMB_WITH_FREE_LIST || MEMB_STATS */
+#if MEMB_STATS
+  if(m->used > m->peak) {
+    m->peak = m->used;
+  }
+#endif /* MEMB_STATS */
+  return (void *)((char *)m->mem + (i * m->size));
 }
 /*---------------------------------------------------------------------------*/
 char
 memb_free(struct memb *m, void *ptr)
 {
   int i;
-  char *ptr2;
 
-  /* Walk through the list of blocks and try to find the block to
-     which the pointer "ptr" points to. */
-  ptr2 = (char *)m->mem;
-  for(i = 0; i < m->num; ++i) {
-    
-    if(ptr2 == (char *)ptr) {
-      /* We've found to block to which "ptr" points so we decrease the
-	 reference count and return the new value of it. */
-      if(m->count[i] > 0) {
-	/* Make sure that we don't deallocate free memory. */
-	--(m->count[i]);
-      }
-      return m->count[i];
+  i = block_index(m, ptr);
+  if(i < 0) {
+    return -1;
+  }
+
+  /* We've found to block to which "ptr" points so we decrease the
+     reference count and return the new value of it. */
+  if(m->count[i] > 0) {
+    /* Make sure that we don't deallocate free memory. */
+    --(m->count[i]);
+#if MEMB_WITH_FREE_LIST || MEMB_STATS
+    if(m->count[i] == 0) {
+      m->used--;
+#if MEMB_WITH_FREE_LIST
+      SET_NEXT_FREE(m, i, m->free);
+      m->free = i;
+#endif /* MEMB_WITH_FREE_LIST */
     }
-    ptr2 += m->size;
+#endif /* MEMB_WITH_FREE_LIST || MEMB_STATS */
   }
-  return -1;
+  return m->count[i];
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -110,6 +195,9 @@ memb_inmemb(struct memb *m, void *ptr)
 int
 memb_numfree(struct memb *m)
 {
+#if MEMB_WITH_FREE_LIST
+  return m->num - m->used;
+#else /* MEMB_WITH_FREE_LIST */
   int i;
   int num_free = 0;
 
@@ -120,5 +208,33 @@ memb_numfree(struct memb *m)
   }
 
   return num_free;
+#endif /* MEMB_WITH_FREE_LIST */
+}
+/*---------------------------------------------------------------------------*/
+#if MEMB_STATS
+int
+memb_numused(struct memb *m)
+{
+  return m->used;
 }
+/*---------------------------------------------------------------------------*/
+int
+memb_peak(struct memb *m)
+{
+  return m->peak;
+}
+/*---------------------------------------------------------------------------*/
+struct memb *
+memb_head(void)
+{
+  return memb_list;
+}
+/*---------------------------------------------------------------------------*/
+struct memb *
+memb_next(struct memb *m)
+{
+  return m->next;
+}
+#endif /* MEMB_STATS */
+/*---------------------------------------------------------------------------*/
 /** @} */
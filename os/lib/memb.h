@@ -48,6 +48,17 @@
  * memory by the memb_alloc() function, and are deallocated with the
  * memb_free() function.
  *
+ * By default, memb_alloc() returns the first free block it finds when
+ * scanning the blocks from the start. With MEMB_CONF_WITH_FREE_LIST
+ * set, the free blocks of each memory block are instead kept on a list,
+ * so that allocating and deallocating a block takes constant time. The
+ * free list uses two additional bytes of RAM per block.
+ *
+ * With MEMB_CONF_STATS set, each memory block keeps track of how many
+ * blocks are in use and of the highest number that have been in use at
+ * once. The memory blocks are listed from memb_head() once they have
+ * been initialized or first allocated from.
+ *
  * @{
  */
 
@@ -65,6 +76,33 @@
 
 #include "sys/cc.h"
 
+#ifdef MEMB_CONF_WITH_FREE_LIST
+#define MEMB_WITH_FREE_LIST MEMB_CONF_WITH_FREE_LIST
+#else
+#define MEMB_WITH_FREE_LIST 0
+#endif
+
+#ifdef MEMB_CONF_STATS
+#define MEMB_STATS MEMB_CONF_STATS
+#else
+#define MEMB_STATS 0
+#endif
+
+#if MEMB_WITH_FREE_LIST
+#define MEMB_FREE_LIST_DECLARE(name, num) \
+        static unsigned short CC_CONCAT(name,_memb_links)[num];
+#define MEMB_FREE_LIST_INIT(name) , .links = CC_CONCAT(name,_memb_links)
+#else
+#define MEMB_FREE_LIST_DECLARE(name, num)
+#define MEMB_FREE_LIST_INIT(name)
+#endif
+
+#if MEMB_STATS
+#define MEMB_STATS_INIT(name) , .label = #name
+#else
+#define MEMB_STATS_INIT(name)
+#endif
+
 /**
  * Declare a memory block.
  *
@@ -88,16 +126,35 @@ MEMB(connections, struct connection, 16);
  */
 #define MEMB(name, structure, num) \
         static char CC_CONCAT(name,_memb_count)[num]; \
+        MEMB_FREE_LIST_DECLARE(name, num) \
         static structure CC_CONCAT(name,_memb_mem)[num]; \
         static struct memb name = {sizeof(structure), num, \
                                           CC_CONCAT(name,_memb_count), \
-                                          (void *)CC_CONCAT(name,_memb_mem)}
+                                          (void *)CC_CONCAT(name,_memb_mem) \
+                                          MEMB_FREE_LIST_INIT(name) \
+                                          MEMB_STATS_INIT(name)}
 
 struct memb {
   unsigned short size;
   unsigned short num;
   char *count;
   void *mem;
+#if MEMB_WITH_FREE_LIST
+  /* For each free block, the distance to the next free block minus
+     one, so that the all-zero initial state links the blocks in order */
+  unsigned short *links;
+  /* The first free block, or num if there is none */
+  unsigned short free;
+#endif /* MEMB_WITH_FREE_LIST */
+#if MEMB_WITH_FREE_LIST || MEMB_STATS
+  unsigned short used;
+#endif /* MEMB_WITH_FREE_LIST || MEMB_STATS */
+#if MEMB_STATS
+  unsigned short peak;
+  unsigned char registered;
+  const char *label;
+  struct memb *next;
+#endif /* MEMB_STATS */
 };
 
 /**
@@ -132,6 +189,36 @@ int memb_inmemb(struct memb *m, void *ptr);
 
 int  memb_numfree(struct memb *m);
 
+#if MEMB_STATS
+/**
+ * Get the number of blocks of a memory block that are in use.
+ *
+ * \param m A memory block previously declared with MEMB().
+ */
+int memb_numused(struct memb *m);
+
+/**
+ * Get the highest number of blocks of a memory block that have been
+ * in use at once since it was initialized.
+ *
+ * \param m A memory block previously declared with MEMB().
+ */
+int memb_peak(struct memb *m);
+
+/**
+ * Get the first memory block that has been initialized or allocated
+ * from, to iterate over all of them with memb_next().
+ */
+struct memb *memb_head(void);
+
+/**
+ * Get the memory block that follows m in the list of memory blocks.
+ *
+ * \param m A memory block returned by memb_head() or memb_next().
+ */
+struct memb *memb_next(struct memb *m);
+#endif /* MEMB_STATS */
+
 /** @} */
 /** @} */
 
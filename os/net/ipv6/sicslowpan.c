@@ -68,6 +68,7 @@
 #include "net/ipv6/tcpip.h"
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/uipbuf.h"
 #include "net/ipv6/sicslowpan.h"
 #include "net/netstack.h"
@@ -144,6 +145,22 @@
 #define IS_COMPRESSABLE_PROTO(x) (x == UIP_PROTO_UDP)
 #endif /* COMPRESS_EXT_HDR */
 
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+/* The longest source route carried in RH3-6LoRH headers. Longer ones
+   are sent in a plain routing header. */
+#ifdef SICSLOWPAN_CONF_6LORH_MAX_HOPS
+#define SICSLOWPAN_6LORH_MAX_HOPS SICSLOWPAN_CONF_6LORH_MAX_HOPS
+#else
+#define SICSLOWPAN_6LORH_MAX_HOPS 16
+#endif
+
+/* Hop-by-hop header with the RPL option, and fixed part of the RPL
+   source routing header (RFC 6553, RFC 6554) */
+#define SICSLOWPAN_RPL_HBH_LEN 8
+#define SICSLOWPAN_SRH_LEN     8
+#define SICSLOWPAN_RH_TYPE_SRH 3
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
+
 /** \name General variables
  *  @{
  */
@@ -174,7 +191,7 @@ static int packetbuf_payload_len;
  * uncomp_hdr_len is the length of the headers before compression (if HC2
  * is used this includes the UDP header in addition to the IP header).
  */
-static uint8_t uncomp_hdr_len;
+static uint16_t uncomp_hdr_len;
 
 /**
  * mac_max_payload is the maimum payload space on the MAC frame.
@@ -232,7 +249,64 @@ static uint16_t my_tag;
 #endif
 
 /* Assuming that the worst growth for uncompression is 38 bytes */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+/* The RPL headers rebuilt from 6LoRH headers also take room: an outer
+   IPv6 header with the RPL option and a few hops */
+#define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38 + 80)
+#else
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
+#endif
+
+/* Reassembly progress is tracked in units of 8 bytes of the uncompressed
+   packet, the granularity of fragment offsets */
+#define REASS_UNITS(len) (((len) + 7) >> 3)
+#define REASS_BITMAP_SIZE ((REASS_UNITS(UIP_BUFSIZE) + 7) / 8)
+
+/* Fragment forwarding: a router relays the fragments of packets that
+   are not for itself as they arrive, instead of reassembling them */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING (SICSLOWPAN_CONF_FRAG_FORWARDING && UIP_CONF_ROUTER)
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+/* The number of packets that can be forwarded fragment by fragment at
+   the same time */
+#ifdef SICSLOWPAN_CONF_VRB_ENTRIES
+#define SICSLOWPAN_VRB_ENTRIES SICSLOWPAN_CONF_VRB_ENTRIES
+#else
+#define SICSLOWPAN_VRB_ENTRIES 4
+#endif
+
+#if SICSLOWPAN_FRAG_FORWARDING
+/* A virtual reassembly buffer: how to relay the fragments of a packet */
+struct sicslowpan_vrb {
+  /** The previous hop, and the tag and size of its fragments */
+  linkaddr_t sender;
+  uint16_t in_tag;
+  /** Size of the incoming packet (if zero this entry is not allocated) */
+  uint16_t in_size;
+  /** The next hop, and the tag and size of the fragments sent to it
+      (if out_size is zero the fragments are dropped) */
+  linkaddr_t next_hop;
+  uint16_t out_tag;
+  uint16_t out_size;
+  /** Bytes of the incoming packet not relayed yet */
+  uint16_t remaining;
+  /** The units of the incoming packet relayed so far, one bit per unit */
+  uint8_t received[REASS_BITMAP_SIZE];
+  /** Priority of the packet, as found in its first fragment */
+  uint8_t priority;
+  struct timer timer;
+};
+
+static struct sicslowpan_vrb vrb[SICSLOWPAN_VRB_ENTRIES];
+/* The VRB of the first fragment being handed to the IP layer, the
+   uncompressed length of that fragment and the source of its packet */
+static struct sicslowpan_vrb *vrb_pending;
+static uint16_t vrb_first_len;
+static uip_ipaddr_t vrb_src;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
@@ -242,14 +316,16 @@ struct sicslowpan_frag_info {
   linkaddr_t receiver;
   /** When reassembling, the tag in the fragments being merged. */
   uint16_t tag;
-  /** Total length of the fragmented packet */
+  /** Total length of the fragmented packet (if zero this context is not allocated) */
   uint16_t len;
-  /** Current length of reassembled fragments */
-  uint16_t reassembled_len;
+  /** Number of units of the packet received so far */
+  uint16_t received_units;
+  /** The units of the packet received so far, one bit per unit */
+  uint8_t received[REASS_BITMAP_SIZE];
   /** Reassembly %process %timer. */
   struct timer reass_timer;
 
-  /** Fragment size of first fragment */
+  /** Fragment size of first fragment (if zero it is not stored in first_frag) */
   uint16_t first_frag_len;
   /** First fragment - needs a larger buffer since the size is uncompressed size
    and we need to know total size to know when we have received last fragment. */
@@ -277,6 +353,10 @@ clear_fragments(uint8_t frag_info_index)
   int i, clear_count;
   clear_count = 0;
   frag_info[frag_info_index].len = 0;
+  frag_info[frag_info_index].received_units = 0;
+  frag_info[frag_info_index].first_frag_len = 0;
+  memset(frag_info[frag_info_index].received, 0,
+         sizeof(frag_info[frag_info_index].received));
   for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
     if(frag_buf[i].len > 0 && frag_buf[i].index == frag_info_index) {
       /* deallocate the buffer */
@@ -302,96 +382,121 @@ timeout_fragments(int not_context)
   return count;
 }
 /*---------------------------------------------------------------------------*/
-static int
-store_fragment(uint8_t index, uint8_t offset)
+/* Returns the number of units in [start, end) set in a bitmap of
+   received units */
+static uint16_t
+count_units(const uint8_t *received, uint16_t start, uint16_t end)
 {
-  int i;
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer and store offset and len */
-      frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = packetbuf_datalen() - packetbuf_hdr_len;
-      frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len,
-             packetbuf_datalen() - packetbuf_hdr_len);
-      /* return the length of the stored fragment */
-      return frag_buf[i].len;
+  uint16_t count = 0;
+  for(; start < end; start++) {
+    if(received[start >> 3] & (1 << (start & 7))) {
+      count++;
     }
   }
-  /* failed */
-  return -1;
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+mark_units(struct sicslowpan_frag_info *info, uint16_t start, uint16_t end)
+{
+  info->received_units += end - start;
+  for(; start < end; start++) {
+    info->received[start >> 3] |= 1 << (start & 7);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the fragments received so far cover the end of the packet
+   without gaps, so that only the first fragment is missing */
+static int
+only_first_fragment_missing(int8_t context)
+{
+  const struct sicslowpan_frag_info *info = &frag_info[context];
+  uint16_t total = REASS_UNITS(info->len);
+
+  return info->received_units > 0 &&
+    count_units(info->received, total - info->received_units, total) == info->received_units;
 }
 /*---------------------------------------------------------------------------*/
-/* add a new fragment to the buffer */
+/* Find the reassembly context of the fragment in packetbuf, from its
+   sender and tag, and allocate one if this is the first fragment of
+   the packet to arrive, whatever its offset */
 static int8_t
-add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
+get_fragment_context(uint16_t tag, uint16_t frag_size)
 {
   int i;
-  int len;
   int8_t found = -1;
 
-  if(offset == 0) {
-    /* This is a first fragment - check if we can add this */
-    for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-      /* clear all fragment info with expired timer to free all fragment buffers */
-      if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(frag_info[i].len > 0 && frag_info[i].tag == tag &&
+       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      if(timer_expired(&frag_info[i].reass_timer)) {
+        /* A stale reassembly with a reused tag: start over */
         clear_fragments(i);
+        break;
       }
-
-      /* We use len as indication on used or not used */
-      if(found < 0 && frag_info[i].len == 0) {
-        /* We remember the first free fragment info but must continue
-           the loop to free any other expired fragment buffers. */
-        found = i;
+      if(frag_info[i].len != frag_size) {
+        LOG_WARN("reassembly: fragment size mismatch - tag: %d size: %d, expected %d\n",
+                 tag, frag_size, frag_info[i].len);
+        return -1;
       }
+      return i;
     }
+  }
 
-    if(found < 0) {
-      LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
-      return -1;
-    }
-
-    /* Found a free fragment info to store data in */
-    frag_info[found].len = frag_size;
-    frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
-    /* first fragment can not be stored immediately but is moved into
-       the buffer while uncompressing */
-    return found;
+  if(frag_size == 0 || frag_size > UIP_BUFSIZE) {
+    LOG_WARN("reassembly: invalid packet size - tag: %d size: %d\n", tag, frag_size);
+    return -1;
   }
 
-  /* This is a N-fragment - should find the info */
   for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-    if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
-       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-      /* Tag and Sender match - this must be the correct info to store in */
+    /* clear all fragment info with expired timer to free all fragment buffers */
+    if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
+      clear_fragments(i);
+    }
+
+    /* We use len as indication on used or not used */
+    if(found < 0 && frag_info[i].len == 0) {
+      /* We remember the first free fragment info but must continue
+         the loop to free any other expired fragment buffers. */
       found = i;
-      break;
     }
   }
 
   if(found < 0) {
-    /* no entry found for storing the new fragment */
-    LOG_WARN("reassembly: failed to store N-fragment - could not find session - tag: %d offset: %d\n", tag, offset);
+    LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
     return -1;
   }
 
-  /* i is the index of the reassembly context */
-  len = store_fragment(i, offset);
-  if(len < 0 && timeout_fragments(i) > 0) {
-    len = store_fragment(i, offset);
-  }
-  if(len > 0) {
-    frag_info[i].reassembled_len += len;
-    return i;
-  } else {
-    /* should we also clear all fragments since we failed to store
-       this fragment? */
-    LOG_WARN("reassembly: failed to store fragment - packet reassembly will fail tag:%d l\n", frag_info[i].tag);
+  /* Found a free fragment info to store data in */
+  frag_info[found].len = frag_size;
+  frag_info[found].tag = tag;
+  linkaddr_copy(&frag_info[found].sender,
+                packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+static int
+store_fragment(uint8_t index, uint8_t offset, uint16_t len)
+{
+  int i;
+
+  if(len > SICSLOWPAN_FRAGMENT_SIZE) {
     return -1;
   }
+  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
+    if(frag_buf[i].len == 0) {
+      /* copy over the data from packetbuf into the fragment buffer and store offset and len */
+      frag_buf[i].offset = offset; /* frag offset */
+      frag_buf[i].len = len;
+      frag_buf[i].index = index;
+      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len, len);
+      /* return the length of the stored fragment */
+      return frag_buf[i].len;
+    }
+  }
+  /* failed */
+  return -1;
 }
 /*---------------------------------------------------------------------------*/
 /* Copy all the fragments that are associated with a specific context
@@ -414,6 +519,93 @@ copy_frags2uip(int context)
   /* deallocate all the fragments for this context */
   clear_fragments(context);
 }
+/*---------------------------------------------------------------------------*/
+/* Add the payload of the fragment in packetbuf, at the given offset of
+   the packet, to its reassembly context. For a first fragment, buffer
+   already holds the uncompressed headers. It is uip_buf if the other
+   fragments were found to cover the end of the packet, or first_frag
+   otherwise. For other fragments, buffer is NULL.
+   Duplicate fragments are ignored, and a fragment that overlaps others
+   discards the whole packet (RFC 4944, section 5.3). The fragment that
+   completes the packet is copied straight to uip_buf, the others are
+   stored until then.
+   Returns 1 if the packet is now complete in uip_buf. */
+static int
+add_fragment(int8_t context, uint8_t *buffer, uint16_t offset)
+{
+  struct sicslowpan_frag_info *info = &frag_info[context];
+  uint16_t len = packetbuf_payload_len;
+  uint16_t start, end, received;
+  int complete;
+
+  if(buffer != NULL) {
+    len += uncomp_hdr_len;
+  }
+  if(offset >= info->len || (buffer != NULL && uncomp_hdr_len > info->len)) {
+    LOG_WARN("reassembly: fragment beyond end of packet - tag: %d offset: %d\n",
+             info->tag, offset);
+    return 0;
+  }
+  /* We are OK if there are extraneous bytes at the end of the packet */
+  if(offset + len > info->len) {
+    len = info->len - offset;
+  }
+
+  start = offset >> 3;
+  end = REASS_UNITS(offset + len);
+  received = count_units(info->received, start, end);
+  if(received == end - start) {
+    LOG_INFO("reassembly: duplicate fragment - tag: %d offset: %d\n",
+             info->tag, offset);
+    return 0;
+  }
+  if(received > 0) {
+    LOG_WARN("reassembly: overlapping fragment, discarding packet - tag: %d offset: %d\n",
+             info->tag, offset);
+    clear_fragments(context);
+    return 0;
+  }
+
+  complete = info->received_units + (end - start) == REASS_UNITS(info->len);
+
+  if(buffer != NULL) {
+    if((buffer != uip_buf || !complete) && len > sizeof(info->first_frag)) {
+      LOG_WARN("reassembly: first fragment too large - tag: %d len: %d\n",
+               info->tag, len);
+      return 0;
+    }
+    if(buffer == uip_buf && !complete) {
+      /* The first fragment does not reach the others: keep it aside */
+      memcpy(info->first_frag, buffer, uncomp_hdr_len);
+      buffer = info->first_frag;
+    }
+    memcpy(buffer + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len,
+           len - uncomp_hdr_len);
+    if(buffer != uip_buf) {
+      info->first_frag_len = len;
+    }
+  } else if(!complete) {
+    if(store_fragment(context, start, len) < 0 &&
+       (timeout_fragments(context) == 0 || store_fragment(context, start, len) < 0)) {
+      /* should we also clear all fragments since we failed to store
+         this fragment? */
+      LOG_WARN("reassembly: failed to store fragment - packet reassembly will fail tag:%d l\n", info->tag);
+      return 0;
+    }
+  }
+  mark_units(info, start, end);
+
+  if(!complete) {
+    return 0;
+  }
+
+  /* copy to uip */
+  copy_frags2uip(context);
+  if(buffer == NULL) {
+    memcpy((uint8_t *)UIP_IP_BUF + offset, packetbuf_ptr + packetbuf_hdr_len, len);
+  }
+  return 1;
+}
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 /* -------------------------------------------------------------------------- */
@@ -464,6 +656,52 @@ set_packet_attrs(void)
 /*   } */
 
 }
+/*--------------------------------------------------------------------*/
+/* Network control traffic (RPL, ND and ICMPv6 errors) is tagged so that
+   the MAC layer can send it ahead of data */
+static uint8_t
+packet_priority(void)
+{
+  uint8_t proto;
+  const struct uip_icmp_hdr *icmp;
+
+  icmp = (const struct uip_icmp_hdr *)uipbuf_get_last_header(uip_buf, uip_len, &proto);
+  if(icmp != NULL && proto == UIP_PROTO_ICMP6 &&
+     icmp->type != ICMP6_ECHO_REQUEST && icmp->type != ICMP6_ECHO_REPLY) {
+    return PACKETBUF_ATTR_PRIORITY_CONTROL;
+  }
+  return PACKETBUF_ATTR_PRIORITY_DATA;
+}
+/*--------------------------------------------------------------------*/
+/* Copy the link-layer security attributes of the frame in packetbuf to
+   the packet in uip_buf */
+static void
+set_uipbuf_llsec_attrs(void)
+{
+#if LLSEC802154_USES_AUX_HEADER
+  uipbuf_set_attr(UIPBUF_ATTR_LLSEC_LEVEL,
+    packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL));
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  uipbuf_set_attr(UIPBUF_ATTR_LLSEC_KEY_ID,
+    packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX));
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /*  LLSEC802154_USES_AUX_HEADER */
+}
+/*--------------------------------------------------------------------*/
+/* Copy the link-layer security attributes of the packet in uip_buf to
+   the frame in packetbuf */
+static void
+set_packetbuf_llsec_attrs(void)
+{
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL,
+    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_LEVEL));
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX,
+    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_KEY_ID));
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /*  LLSEC802154_USES_AUX_HEADER */
+}
 
 
 
@@ -519,7 +757,7 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /*--------------------------------------------------------------------*/
 /** \brief find the context corresponding to prefix ipaddr */
 static struct sicslowpan_addr_context*
-addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
+addr_context_lookup_by_prefix(const uip_ipaddr_t *ipaddr)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
@@ -552,7 +790,7 @@ addr_context_lookup_by_number(uint8_t number)
 }
 /*--------------------------------------------------------------------*/
 static uint8_t
-compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
+compress_addr_64(uint8_t bitpos, const uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
 {
   if(uip_is_addr_mac_addr_based(ipaddr, lladdr)) {
     return 3 << bitpos; /* 0-bits */
@@ -643,14 +881,18 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
  * \note The context number 00 is reserved for the link local prefix.
  * For unicast addresses, if we cannot compress the prefix, we neither
  * compress the IID.
+ * \param ip_hdr The IPv6 header to compress, usually UIP_IP_BUF
+ * \param hdr_len Offset in uip_buf of what follows that header
  * \param link_destaddr L2 destination address, needed to compress IP
  * dest
  * \return 1 if success, else 0
  */
 static int
-compress_hdr_iphc(linkaddr_t *link_destaddr)
+compress_hdr_iphc(const struct uip_ip_hdr *ip_hdr, uint16_t hdr_len,
+                  linkaddr_t *link_destaddr)
 {
-  uint8_t tmp, iphc0, iphc1, *next_hdr, *next_nhc;
+  uint8_t tmp, iphc0, iphc1, *next_nhc;
+  const uint8_t *next_hdr;
   int ext_hdr_len;
   struct uip_udp_hdr *udp_buf;
 
@@ -702,8 +944,8 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   /* check if dest context exists (for allocating third byte) */
   /* TODO: fix this so that it remembers the looked up values for
      avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  if(addr_context_lookup_by_prefix(&ip_hdr->destipaddr) != NULL ||
+     addr_context_lookup_by_prefix(&ip_hdr->srcipaddr) != NULL) {
     /* set context flag and increase hc06_ptr */
     LOG_DBG("compression: dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -719,15 +961,15 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
   /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
 
-  tmp = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
+  tmp = (ip_hdr->vtc << 4) | (ip_hdr->tcflow >> 4);
   tmp = ((tmp & 0x03) << 6) | (tmp >> 2);
 
-  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) &&
-     (UIP_IP_BUF->flow == 0)) {
+  if(((ip_hdr->tcflow & 0x0F) == 0) &&
+     (ip_hdr->flow == 0)) {
     /* flow label can be compressed */
     iphc0 |= SICSLOWPAN_IPHC_FL_C;
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    if(((ip_hdr->vtc & 0x0F) == 0) &&
+       ((ip_hdr->tcflow & 0xF0) == 0)) {
       /* compress (elide) all */
       iphc0 |= SICSLOWPAN_IPHC_TC_C;
     } else {
@@ -737,17 +979,17 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Flow label cannot be compressed */
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    if(((ip_hdr->vtc & 0x0F) == 0) &&
+       ((ip_hdr->tcflow & 0xF0) == 0)) {
       /* compress only traffic class */
       iphc0 |= SICSLOWPAN_IPHC_TC_C;
       *hc06_ptr = (tmp & 0xc0) |
-        (UIP_IP_BUF->tcflow & 0x0F);
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
+        (ip_hdr->tcflow & 0x0F);
+      memcpy(hc06_ptr + 1, &ip_hdr->flow, 2);
       hc06_ptr += 3;
     } else {
       /* compress nothing */
-      memcpy(hc06_ptr, &UIP_IP_BUF->vtc, 4);
+      memcpy(hc06_ptr, &ip_hdr->vtc, 4);
       /* but replace the top byte with the new ECN | DSCP format*/
       *hc06_ptr = tmp;
       hc06_ptr += 4;
@@ -757,13 +999,13 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   /* Note that the payload length is always compressed */
 
   /* Next header. We compress it is compressable. */
-  if(IS_COMPRESSABLE_PROTO(UIP_IP_BUF->proto)) {
+  if(IS_COMPRESSABLE_PROTO(ip_hdr->proto)) {
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
   }
 
   /* Add proto header unless it is compressed */
   if((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
-    *hc06_ptr = UIP_IP_BUF->proto;
+    *hc06_ptr = ip_hdr->proto;
     hc06_ptr += 1;
   }
 
@@ -774,7 +1016,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    * if 255: compress, encoding is 11
    * else do not compress
    */
-  switch(UIP_IP_BUF->ttl) {
+  switch(ip_hdr->ttl) {
     case 1:
       iphc0 |= SICSLOWPAN_IPHC_TTL_1;
       break;
@@ -785,17 +1027,17 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
       iphc0 |= SICSLOWPAN_IPHC_TTL_255;
       break;
     default:
-      *hc06_ptr = UIP_IP_BUF->ttl;
+      *hc06_ptr = ip_hdr->ttl;
       hc06_ptr += 1;
       break;
   }
 
   /* source address - cannot be multicast */
-  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+  if(uip_is_addr_unspecified(&ip_hdr->srcipaddr)) {
     LOG_DBG("compression: addr unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
+  } else if((context = addr_context_lookup_by_prefix(&ip_hdr->srcipaddr))
      != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     LOG_DBG("compression: src with context - setting CID & SAC ctx: %d\n",
@@ -805,79 +1047,79 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &ip_hdr->srcipaddr, &uip_lladdr);
     /* No context found for this address */
-  } else if(uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr) &&
-            UIP_IP_BUF->destipaddr.u16[1] == 0 &&
-            UIP_IP_BUF->destipaddr.u16[2] == 0 &&
-            UIP_IP_BUF->destipaddr.u16[3] == 0) {
+  } else if(uip_is_addr_linklocal(&ip_hdr->srcipaddr) &&
+            ip_hdr->destipaddr.u16[1] == 0 &&
+            ip_hdr->destipaddr.u16[2] == 0 &&
+            ip_hdr->destipaddr.u16[3] == 0) {
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &ip_hdr->srcipaddr, &uip_lladdr);
   } else {
     /* send the full address => SAC = 0, SAM = 00 */
     iphc1 |= SICSLOWPAN_IPHC_SAM_00; /* 128-bits */
-    memcpy(hc06_ptr, &UIP_IP_BUF->srcipaddr.u16[0], 16);
+    memcpy(hc06_ptr, &ip_hdr->srcipaddr.u16[0], 16);
     hc06_ptr += 16;
   }
 
   /* dest address*/
-  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+  if(uip_is_addr_mcast(&ip_hdr->destipaddr)) {
     /* Address is multicast, try to compress */
     iphc1 |= SICSLOWPAN_IPHC_M;
-    if(sicslowpan_is_mcast_addr_compressable8(&UIP_IP_BUF->destipaddr)) {
+    if(sicslowpan_is_mcast_addr_compressable8(&ip_hdr->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_11;
       /* use last byte */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[15];
+      *hc06_ptr = ip_hdr->destipaddr.u8[15];
       hc06_ptr += 1;
-    } else if(sicslowpan_is_mcast_addr_compressable32(&UIP_IP_BUF->destipaddr)) {
+    } else if(sicslowpan_is_mcast_addr_compressable32(&ip_hdr->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_10;
       /* second byte + the last three */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[1];
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->destipaddr.u8[13], 3);
+      *hc06_ptr = ip_hdr->destipaddr.u8[1];
+      memcpy(hc06_ptr + 1, &ip_hdr->destipaddr.u8[13], 3);
       hc06_ptr += 4;
-    } else if(sicslowpan_is_mcast_addr_compressable48(&UIP_IP_BUF->destipaddr)) {
+    } else if(sicslowpan_is_mcast_addr_compressable48(&ip_hdr->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_01;
       /* second byte + the last five */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[1];
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->destipaddr.u8[11], 5);
+      *hc06_ptr = ip_hdr->destipaddr.u8[1];
+      memcpy(hc06_ptr + 1, &ip_hdr->destipaddr.u8[11], 5);
       hc06_ptr += 6;
     } else {
       iphc1 |= SICSLOWPAN_IPHC_DAM_00;
       /* full address */
-      memcpy(hc06_ptr, &UIP_IP_BUF->destipaddr.u8[0], 16);
+      memcpy(hc06_ptr, &ip_hdr->destipaddr.u8[0], 16);
       hc06_ptr += 16;
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if((context = addr_context_lookup_by_prefix(&ip_hdr->destipaddr)) != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
       PACKETBUF_IPHC_BUF[2] |= context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-                                &UIP_IP_BUF->destipaddr,
+                                &ip_hdr->destipaddr,
                                 (uip_lladdr_t *)link_destaddr);
       /* No context found for this address */
-    } else if(uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr) &&
-              UIP_IP_BUF->destipaddr.u16[1] == 0 &&
-              UIP_IP_BUF->destipaddr.u16[2] == 0 &&
-              UIP_IP_BUF->destipaddr.u16[3] == 0) {
+    } else if(uip_is_addr_linklocal(&ip_hdr->destipaddr) &&
+              ip_hdr->destipaddr.u16[1] == 0 &&
+              ip_hdr->destipaddr.u16[2] == 0 &&
+              ip_hdr->destipaddr.u16[3] == 0) {
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-               &UIP_IP_BUF->destipaddr, (uip_lladdr_t *)link_destaddr);
+               &ip_hdr->destipaddr, (uip_lladdr_t *)link_destaddr);
     } else {
       /* send the full address */
       iphc1 |= SICSLOWPAN_IPHC_DAM_00; /* 128-bits */
-      memcpy(hc06_ptr, &UIP_IP_BUF->destipaddr.u16[0], 16);
+      memcpy(hc06_ptr, &ip_hdr->destipaddr.u16[0], 16);
       hc06_ptr += 16;
     }
   }
 
-  uncomp_hdr_len = UIP_IPH_LEN;
+  uncomp_hdr_len = hdr_len;
 
   /* Start of ext hdr compression or UDP compression */
   /* pick out the next-header position */
-  next_hdr = &UIP_IP_BUF->proto;
+  next_hdr = &ip_hdr->proto;
   next_nhc = hc06_ptr; /* here we set the next header is compressed. */
   ext_hdr_len = 0;
   /* reserve the write place of this next header position */
@@ -897,7 +1139,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
       /* Handle the header here! */
       {
         struct uip_ext_hdr *ext_hdr =
-          (struct uip_ext_hdr *) UIP_IPPAYLOAD_BUF_POS(ext_hdr_len);
+          (struct uip_ext_hdr *)&uip_buf[hdr_len + ext_hdr_len];
         int len;
         proto = proto == -1 ? SICSLOWPAN_NHC_ETX_HDR_DESTO : proto;
         /* Len is defined to be in octets from the length byte */
@@ -936,7 +1178,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     case UIP_PROTO_UDP:
       /* allocate a byte for the next header posision as UDP has no next */
       hc06_ptr++;
-      udp_buf = UIP_UDP_BUF_POS(ext_hdr_len);
+      udp_buf = (struct uip_udp_hdr *)&uip_buf[hdr_len + ext_hdr_len];
       LOG_DBG("compression: inlined UDP ports on send side: %x, %x\n",
              UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
       /* Mask out the last 4 bits can be used as a mask */
@@ -1337,6 +1579,293 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
 
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
 /*--------------------------------------------------------------------*/
+/** \name 6LoRH compression (RFC 8138)
+ *
+ * The RPL option (RFC 6553), source routing header (RFC 6554) and
+ * IPv6-in-IPv6 encapsulation that lead a routed packet are carried in
+ * RPI-, RH3- and IP-in-IP 6LoRH headers, between the Page 1 dispatch
+ * and IPHC. The receiver rebuilds them as follows, and the sender
+ * brings them into that form before compression so that both agree on
+ * the size of the packet and on fragment offsets:
+ * - a hop-by-hop header holding only the RPL option
+ * - a source routing header holding the hops left to visit, with
+ *   CmprI and CmprE as large as possible
+ * - the tunnelled packet, if any, after these headers
+ *
+ * The hops of the RH3-6LoRHs are those the packet has to visit after
+ * the destination of its IPv6 header, each one compressed against the
+ * previous one. With IP-in-IP, whose outer header is not carried, the
+ * first hop is the outer destination and is compressed against the
+ * encapsulator. Without RH3-6LoRH, the outer destination is the root.
+ * @{
+ */
+/*--------------------------------------------------------------------*/
+/* The RPL headers of the packet being compressed or uncompressed */
+static struct {
+  /** RPL option: flags, RPLInstanceID and SenderRank */
+  uint8_t has_rpi;
+  uint8_t rpi_flags;
+  uint8_t rpi_instance;
+  uint16_t rpi_rank;
+  /** IPv6-in-IPv6: hop limit and source of the outer header */
+  uint8_t has_encap;
+  uint8_t encap_hop_limit;
+  uip_ipaddr_t encapsulator;
+  /** Source route, and the number of bytes carried of each hop */
+  uint8_t hop_count;
+  uint8_t hop_size[SICSLOWPAN_6LORH_MAX_HOPS];
+  uip_ipaddr_t hop[SICSLOWPAN_6LORH_MAX_HOPS];
+  /** Layout of the uncompressed headers */
+  uint8_t cmpri;
+  uint8_t cmpre;
+  uint8_t srh_pad;
+  uint16_t srh_len;
+  uint16_t hdrs_len;
+} lorh;
+/*--------------------------------------------------------------------*/
+static uint8_t
+matching_bytes(const uip_ipaddr_t *a, const uip_ipaddr_t *b)
+{
+  uint8_t i;
+
+  for(i = 0; i < 16 && a->u8[i] == b->u8[i]; i++);
+  return i;
+}
+/*--------------------------------------------------------------------*/
+/* Returns how many trailing bytes of addr are to be carried, at least
+   size, when the others are those of ref */
+static uint8_t
+lorh_addr_size(const uip_ipaddr_t *addr, const uip_ipaddr_t *ref, uint8_t size)
+{
+  uint8_t common = matching_bytes(addr, ref);
+
+  while(16 - size > common) {
+    size = size == 0 ? 1 : size << 1;
+  }
+  return size;
+}
+/*--------------------------------------------------------------------*/
+/* Computes the length of the uncompressed RPL headers, for a packet to
+   dest unless tunnelled */
+static uint16_t
+lorh_layout(const uip_ipaddr_t *dest)
+{
+  const uip_ipaddr_t *route = lorh.hop;
+  uint8_t route_len = lorh.hop_count;
+  uint8_t i;
+
+  lorh.hdrs_len = 0;
+  if(lorh.has_encap) {
+    dest = &lorh.hop[0];
+    route++;
+    route_len--;
+    lorh.hdrs_len += UIP_IPH_LEN;
+  }
+  if(lorh.has_rpi) {
+    lorh.hdrs_len += SICSLOWPAN_RPL_HBH_LEN;
+  }
+
+  lorh.srh_len = 0;
+  if(route_len > 0) {
+    lorh.cmpre = MIN(15, matching_bytes(&route[route_len - 1], dest));
+    lorh.cmpri = route_len > 1 ? 15 : lorh.cmpre;
+    for(i = 0; i + 1 < route_len; i++) {
+      lorh.cmpri = MIN(lorh.cmpri, matching_bytes(&route[i], dest));
+    }
+    lorh.srh_len = SICSLOWPAN_SRH_LEN + (route_len - 1) * (16 - lorh.cmpri)
+      + (16 - lorh.cmpre);
+    lorh.srh_pad = (8 - (lorh.srh_len & 7)) & 7;
+    lorh.srh_len += lorh.srh_pad;
+    lorh.hdrs_len += lorh.srh_len;
+  }
+  return lorh.hdrs_len;
+}
+/*--------------------------------------------------------------------*/
+/* Writes the RPL headers laid out by lorh_layout() into the packet in
+   buf, after its IPv6 header or at its start if tunnelled, in place of
+   the removed bytes there. The len bytes that follow are moved. */
+static void
+lorh_write_hdrs(uint8_t *buf, uint16_t removed, uint16_t len)
+{
+  struct uip_ip_hdr *ip_hdr = (struct uip_ip_hdr *)buf;
+  const uip_ipaddr_t *route;
+  uint8_t route_len;
+  uint8_t *ptr = buf;
+  uint8_t *next;
+  uint8_t last;
+  uint8_t cmpr;
+  uint8_t i;
+
+  if(lorh.has_encap) {
+    memmove(ptr + lorh.hdrs_len, ptr + removed, len);
+    memset(ip_hdr, 0, UIP_IPH_LEN);
+    ip_hdr->vtc = 0x60;
+    ip_hdr->ttl = lorh.encap_hop_limit;
+    uip_ipaddr_copy(&ip_hdr->srcipaddr, &lorh.encapsulator);
+    uip_ipaddr_copy(&ip_hdr->destipaddr, &lorh.hop[0]);
+    last = UIP_PROTO_IPV6;
+    route = &lorh.hop[1];
+    route_len = lorh.hop_count - 1;
+  } else {
+    memmove(ptr + UIP_IPH_LEN + lorh.hdrs_len, ptr + UIP_IPH_LEN + removed, len);
+    last = ip_hdr->proto;
+    route = lorh.hop;
+    route_len = lorh.hop_count;
+  }
+  next = &ip_hdr->proto;
+  ptr += UIP_IPH_LEN;
+
+  if(lorh.has_rpi) {
+    *next = UIP_PROTO_HBHO;
+    next = ptr;
+    ptr[1] = 0;
+    ptr[2] = UIP_EXT_HDR_OPT_RPL;
+    ptr[3] = sizeof(struct uip_ext_hdr_opt_rpl) - 2;
+    ptr[4] = lorh.rpi_flags;
+    ptr[5] = lorh.rpi_instance;
+    ptr[6] = lorh.rpi_rank >> 8;
+    ptr[7] = lorh.rpi_rank & 0xff;
+    ptr += SICSLOWPAN_RPL_HBH_LEN;
+  }
+
+  if(route_len > 0) {
+    *next = UIP_PROTO_ROUTING;
+    next = ptr;
+    ptr[1] = (lorh.srh_len - 8) >> 3;
+    ptr[2] = SICSLOWPAN_RH_TYPE_SRH;
+    ptr[3] = route_len;
+    ptr[4] = (lorh.cmpri << 4) | lorh.cmpre;
+    ptr[5] = lorh.srh_pad << 4;
+    ptr[6] = 0;
+    ptr[7] = 0;
+    ptr += SICSLOWPAN_SRH_LEN;
+    for(i = 0; i < route_len; i++) {
+      cmpr = i + 1 < route_len ? lorh.cmpri : lorh.cmpre;
+      memcpy(ptr, &route[i].u8[cmpr], 16 - cmpr);
+      ptr += 16 - cmpr;
+    }
+    memset(ptr, 0, lorh.srh_pad);
+  }
+  *next = last;
+}
+/*--------------------------------------------------------------------*/
+/* Reads the hops left to visit from the source routing header at hdr,
+   of a packet to dest. Returns 0 if the header is malformed. */
+static int
+lorh_read_srh(const uint8_t *hdr, const uip_ipaddr_t *dest)
+{
+  uint16_t ext_len = (hdr[1] << 3) + 8;
+  uint8_t cmpri = hdr[4] >> 4;
+  uint8_t cmpre = hdr[4] & 0x0f;
+  uint8_t pad = hdr[5] >> 4;
+  uint8_t seg_left = hdr[3];
+  uint8_t path_len;
+  uint8_t cmpr;
+  uint8_t i;
+  uip_ipaddr_t *addr;
+
+  if(ext_len < SICSLOWPAN_SRH_LEN + pad + (16 - cmpre) ||
+     (ext_len - SICSLOWPAN_SRH_LEN - pad - (16 - cmpre)) % (16 - cmpri) != 0) {
+    return 0;
+  }
+  path_len = (ext_len - SICSLOWPAN_SRH_LEN - pad - (16 - cmpre)) / (16 - cmpri) + 1;
+  if(seg_left > path_len ||
+     lorh.hop_count + seg_left > SICSLOWPAN_6LORH_MAX_HOPS) {
+    return 0;
+  }
+
+  for(i = path_len - seg_left; i < path_len; i++) {
+    cmpr = i + 1 < path_len ? cmpri : cmpre;
+    addr = &lorh.hop[lorh.hop_count++];
+    uip_ipaddr_copy(addr, dest);
+    memcpy(&addr->u8[cmpr], hdr + SICSLOWPAN_SRH_LEN + i * (16 - cmpri), 16 - cmpr);
+  }
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/* Writes the 6LoRH headers for the RPL headers in lorh, of a packet to
+   dest unless tunnelled. Returns 0 if they do not fit packetbuf. */
+static int
+lorh_write_6lorh(const uip_ipaddr_t *dest)
+{
+  uint8_t *ptr = PACKETBUF_6LO_PTR;
+  const uip_ipaddr_t *ref = dest;
+  uip_ipaddr_t root;
+  uint8_t has_root;
+  uint8_t first = 0;
+  uint8_t size;
+  uint8_t type;
+  uint8_t tse;
+  uint8_t i, j, n;
+
+  has_root = NETSTACK_ROUTING.get_root_ipaddr(&root);
+  if(lorh.has_encap) {
+    ref = &lorh.encapsulator;
+    if(lorh.hop_count == 1 && has_root && uip_ipaddr_cmp(&lorh.hop[0], &root)) {
+      /* Tunnelled to the root: no RH3-6LoRH */
+      first = 1;
+    }
+  }
+
+  /* One RH3-6LoRH for each run of up to 32 hops of the same size */
+  for(i = first; i < lorh.hop_count; i++) {
+    lorh.hop_size[i] = lorh_addr_size(&lorh.hop[i], ref, 1);
+    ref = &lorh.hop[i];
+  }
+  for(i = first; i < lorh.hop_count; i += n) {
+    size = lorh.hop_size[i];
+    for(n = 1; i + n < lorh.hop_count && n < 32 &&
+          lorh.hop_size[i + n] == size; n++);
+    for(type = 0; (1 << type) < size; type++);
+    if(ptr + 2 + n * size > PACKETBUF_PAYLOAD_END) {
+      return 0;
+    }
+    *ptr++ = SICSLOWPAN_DISPATCH_6LORH | (n - 1);
+    *ptr++ = SICSLOWPAN_6LORH_TYPE_RH3_1 + type;
+    for(j = 0; j < n; j++) {
+      memcpy(ptr, &lorh.hop[i + j].u8[16 - size], size);
+      ptr += size;
+    }
+  }
+
+  if(lorh.has_rpi) {
+    if(ptr + 5 > PACKETBUF_PAYLOAD_END) {
+      return 0;
+    }
+    tse = (lorh.rpi_flags >> 3) & SICSLOWPAN_6LORH_RPI_FLAGS;
+    if(lorh.rpi_instance == 0) {
+      tse |= SICSLOWPAN_6LORH_RPI_I;
+    }
+    if((lorh.rpi_rank & 0xff) == 0) {
+      tse |= SICSLOWPAN_6LORH_RPI_K;
+    }
+    *ptr++ = SICSLOWPAN_DISPATCH_6LORH | tse;
+    *ptr++ = SICSLOWPAN_6LORH_TYPE_RPI;
+    if(!(tse & SICSLOWPAN_6LORH_RPI_I)) {
+      *ptr++ = lorh.rpi_instance;
+    }
+    *ptr++ = lorh.rpi_rank >> 8;
+    if(!(tse & SICSLOWPAN_6LORH_RPI_K)) {
+      *ptr++ = lorh.rpi_rank & 0xff;
+    }
+  }
+
+  if(lorh.has_encap) {
+    size = has_root ? lorh_addr_size(&lorh.encapsulator, &root, 0) : 16;
+    if(ptr + 3 + size > PACKETBUF_PAYLOAD_END) {
+      return 0;
+    }
+    *ptr++ = SICSLOWPAN_DISPATCH_6LORH | SICSLOWPAN_6LORH_ELECTIVE | (1 + size);
+    *ptr++ = SICSLOWPAN_6LORH_TYPE_IP_IN_IP;
+    *ptr++ = lorh.encap_hop_limit;
+    memcpy(ptr, &lorh.encapsulator.u8[16 - size], size);
+    ptr += size;
+  }
+
+  packetbuf_hdr_len = ptr - packetbuf_ptr;
+  return 1;
+}
+/*--------------------------------------------------------------------*/
 /**
  * \brief Adds Paging dispatch byte
  */
@@ -1350,12 +1879,259 @@ add_paging_dispatch(uint8_t page)
 /*--------------------------------------------------------------------*/
 /**
  * \brief Adds 6lorh headers before IPHC
+ *
+ * The RPL headers at the start of the packet in uip_buf are replaced
+ * by 6LoRH headers, after being brought into the form they are rebuilt
+ * in at the receiver.
+ *
+ * \param iphc_hdr Where to copy the IPv6 header to compress with IPHC
+ * \return The offset in uip_buf of what follows that header
  */
-static void
-add_6lorh_hdr(void)
+static uint16_t
+add_6lorh_hdr(struct uip_ip_hdr *iphc_hdr)
+{
+  uint8_t proto = UIP_IP_BUF->proto;
+  uint16_t offset = UIP_IPH_LEN;
+  uint16_t removed;
+  uint16_t hdrs_len;
+  uint8_t dispatch_len = packetbuf_hdr_len;
+  const uint8_t *hdr;
+  const uint8_t *srh = NULL;
+
+  memcpy(iphc_hdr, UIP_IP_BUF, UIP_IPH_LEN);
+  lorh.has_rpi = 0;
+  lorh.has_encap = 0;
+  lorh.hop_count = 0;
+
+  /* Look for the RPL option and source routing header */
+  while(offset + 8 <= uip_len) {
+    hdr = &uip_buf[offset];
+    if(proto == UIP_PROTO_HBHO && !lorh.has_rpi && hdr[1] == 0 &&
+       hdr[2] == UIP_EXT_HDR_OPT_RPL &&
+       hdr[3] == sizeof(struct uip_ext_hdr_opt_rpl) - 2 &&
+       (hdr[4] & ~(SICSLOWPAN_6LORH_RPI_FLAGS << 3)) == 0) {
+      lorh.has_rpi = 1;
+      lorh.rpi_flags = hdr[4];
+      lorh.rpi_instance = hdr[5];
+      lorh.rpi_rank = (hdr[6] << 8) | hdr[7];
+    } else if(proto == UIP_PROTO_ROUTING && srh == NULL &&
+              hdr[2] == SICSLOWPAN_RH_TYPE_SRH) {
+      srh = hdr;
+    } else {
+      break;
+    }
+    proto = hdr[0];
+    offset += (hdr[1] << 3) + 8;
+  }
+  if(offset > uip_len) {
+    return UIP_IPH_LEN;
+  }
+
+  /* The outer header of a tunnel is elided, unless it carries a traffic
+     class or flow label */
+  if(proto == UIP_PROTO_IPV6 && offset + UIP_IPH_LEN <= uip_len &&
+     UIP_IP_BUF->vtc == 0x60 && UIP_IP_BUF->tcflow == 0 &&
+     UIP_IP_BUF->flow == 0) {
+    lorh.has_encap = 1;
+    lorh.encap_hop_limit = UIP_IP_BUF->ttl;
+    uip_ipaddr_copy(&lorh.encapsulator, &UIP_IP_BUF->srcipaddr);
+    uip_ipaddr_copy(&lorh.hop[0], &UIP_IP_BUF->destipaddr);
+    lorh.hop_count = 1;
+  }
+  if(srh != NULL && !lorh_read_srh(srh, &UIP_IP_BUF->destipaddr)) {
+    LOG_WARN("output: cannot compress source routing header\n");
+    return UIP_IPH_LEN;
+  }
+  if(!lorh.has_rpi && !lorh.has_encap && srh == NULL) {
+    return UIP_IPH_LEN;
+  }
+
+  hdrs_len = lorh_layout(&UIP_IP_BUF->destipaddr);
+  removed = lorh.has_encap ? offset : offset - UIP_IPH_LEN;
+  if(uip_len - removed + hdrs_len > UIP_BUFSIZE ||
+     !lorh_write_6lorh(&UIP_IP_BUF->destipaddr)) {
+    packetbuf_hdr_len = dispatch_len;
+    return UIP_IPH_LEN;
+  }
+  LOG_INFO("output: %u bytes of RPL headers in %u bytes of 6LoRH\n",
+           removed, packetbuf_hdr_len - dispatch_len);
+
+  if(!lorh.has_encap) {
+    /* lorh_write_hdrs() chains the headers to this one */
+    UIP_IP_BUF->proto = proto;
+  }
+  lorh_write_hdrs(uip_buf, removed, uip_len - offset);
+  uip_len = uip_len - removed + hdrs_len;
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+
+  if(lorh.has_encap) {
+    memcpy(iphc_hdr, &uip_buf[hdrs_len], UIP_IPH_LEN);
+    return hdrs_len + UIP_IPH_LEN;
+  }
+  iphc_hdr->proto = proto;
+  return UIP_IPH_LEN + hdrs_len;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Digest 6lorh headers before IPHC
+ *
+ * \return 0 if the packet is to be dropped, 1 otherwise
+ */
+static int
+digest_6lorh_hdr(void)
+{
+  const uint8_t *ptr;
+  uint8_t tse;
+  uint8_t type;
+  uint8_t size;
+  uint8_t len;
+  uint8_t i;
+
+  lorh.has_rpi = 0;
+  lorh.has_encap = 0;
+  lorh.hop_count = 0;
+
+  while(packetbuf_hdr_len + 2 <= packetbuf_datalen() &&
+        (PACKETBUF_6LO_PTR[0] & SICSLOWPAN_DISPATCH_6LORH_MASK) == SICSLOWPAN_DISPATCH_6LORH) {
+    ptr = PACKETBUF_6LO_PTR;
+    tse = ptr[0] & SICSLOWPAN_6LORH_TSE_MASK;
+    type = ptr[1];
+
+    if(ptr[0] & SICSLOWPAN_6LORH_ELECTIVE) {
+      /* The TSE is the length of the header, after its type */
+      len = 2 + tse;
+      size = tse - 1;
+      if(packetbuf_hdr_len + len > packetbuf_datalen()) {
+        LOG_WARN("input: truncated elective 6LoRH type %u\n", type);
+        return 0;
+      }
+      if(type == SICSLOWPAN_6LORH_TYPE_IP_IN_IP && tse > 0 &&
+         size <= 16 && (size & (size - 1)) == 0) {
+        if(size < 16 && !NETSTACK_ROUTING.get_root_ipaddr(&lorh.encapsulator)) {
+          LOG_WARN("input: 6LoRH encapsulator relative to unknown root\n");
+          return 0;
+        }
+        lorh.has_encap = 1;
+        lorh.encap_hop_limit = ptr[2];
+        memcpy(&lorh.encapsulator.u8[16 - size], ptr + 3, size);
+      } else {
+        LOG_INFO("input: skipping elective 6LoRH type %u\n", type);
+      }
+    } else if(type <= SICSLOWPAN_6LORH_TYPE_RH3_16) {
+      /* The TSE is the number of hops, minus one */
+      size = 1 << (type - SICSLOWPAN_6LORH_TYPE_RH3_1);
+      len = 2 + (tse + 1) * size;
+      if(lorh.hop_count + tse + 1 > SICSLOWPAN_6LORH_MAX_HOPS) {
+        LOG_WARN("input: too many hops in RH3-6LoRH\n");
+        return 0;
+      }
+      if(packetbuf_hdr_len + len > packetbuf_datalen()) {
+        LOG_WARN("input: truncated RH3-6LoRH\n");
+        return 0;
+      }
+      for(i = 0; i <= tse; i++) {
+        lorh.hop_size[lorh.hop_count] = size;
+        memcpy(&lorh.hop[lorh.hop_count].u8[16 - size], ptr + 2 + i * size, size);
+        lorh.hop_count++;
+      }
+    } else if(type == SICSLOWPAN_6LORH_TYPE_RPI) {
+      len = 2 + ((tse & SICSLOWPAN_6LORH_RPI_I) ? 0 : 1)
+        + ((tse & SICSLOWPAN_6LORH_RPI_K) ? 1 : 2);
+      if(packetbuf_hdr_len + len > packetbuf_datalen()) {
+        LOG_WARN("input: truncated RPI-6LoRH\n");
+        return 0;
+      }
+      ptr += 2;
+      lorh.has_rpi = 1;
+      lorh.rpi_flags = (tse & SICSLOWPAN_6LORH_RPI_FLAGS) << 3;
+      lorh.rpi_instance = (tse & SICSLOWPAN_6LORH_RPI_I) ? 0 : *ptr++;
+      lorh.rpi_rank = *ptr++ << 8;
+      if(!(tse & SICSLOWPAN_6LORH_RPI_K)) {
+        lorh.rpi_rank |= *ptr;
+      }
+    } else {
+      LOG_WARN("input: unsupported critical 6LoRH type %u\n", type);
+      return 0;
+    }
+    packetbuf_hdr_len += len;
+  }
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/* Rebuilds the RPL headers carried in 6LoRH headers, in the packet
+   whose IPHC headers were just uncompressed into buf. ip_len is the
+   size of the packet if fragmented, 0 otherwise. Returns 0 if the
+   packet is to be dropped. */
+static int
+lorh_rebuild(uint8_t *buf, uint16_t ip_len)
 {
-  /* 6LoRH is not implemented yet */
+  struct uip_ip_hdr *ip_hdr = (struct uip_ip_hdr *)buf;
+  const uip_ipaddr_t *ref;
+  uint16_t hdrs_len;
+  uint16_t len;
+  uint16_t offset;
+  uint8_t proto;
+  uint8_t i;
+
+  if(!lorh.has_rpi && !lorh.has_encap && lorh.hop_count == 0) {
+    return 1;
+  }
+
+  ref = &ip_hdr->destipaddr;
+  if(lorh.has_encap) {
+    if(lorh.hop_count == 0) {
+      /* Tunnelled to the root */
+      if(!NETSTACK_ROUTING.get_root_ipaddr(&lorh.hop[0])) {
+        LOG_WARN("input: 6LoRH tunnel to unknown root\n");
+        return 0;
+      }
+      lorh.hop_size[0] = 16;
+      lorh.hop_count = 1;
+    }
+    ref = &lorh.encapsulator;
+  }
+  for(i = 0; i < lorh.hop_count; i++) {
+    memcpy(&lorh.hop[i], ref, 16 - lorh.hop_size[i]);
+    ref = &lorh.hop[i];
+  }
+
+  hdrs_len = lorh_layout(&ip_hdr->destipaddr);
+  if(uncomp_hdr_len + hdrs_len > UIP_BUFSIZE) {
+    LOG_WARN("input: RPL headers from 6LoRH do not fit\n");
+    return 0;
+  }
+
+  if(ip_len != 0) {
+    /* The size of the packet includes the headers to rebuild, which
+       uncompress_hdr_iphc() took for UDP payload */
+    proto = ip_hdr->proto;
+    offset = UIP_IPH_LEN;
+    while(proto != UIP_PROTO_UDP && IS_COMPRESSABLE_PROTO(proto) &&
+          offset + 8 <= uncomp_hdr_len) {
+      proto = buf[offset];
+      offset += (buf[offset + 1] << 3) + 8;
+    }
+    if(proto == UIP_PROTO_UDP && offset + UIP_UDPH_LEN <= uncomp_hdr_len) {
+      len = (buf[offset + 4] << 8) + buf[offset + 5] - hdrs_len;
+      SET16(buf, offset + 4, len);
+    }
+  }
+
+  /* The payload length set by uncompress_hdr_iphc() is that of the
+     whole packet if fragmented, of the IPHC part otherwise */
+  len = uipbuf_get_len_field(ip_hdr);
+  if(ip_len == 0) {
+    len += hdrs_len;
+  }
+  lorh_write_hdrs(buf, 0, uncomp_hdr_len - (lorh.has_encap ? 0 : UIP_IPH_LEN));
+  uncomp_hdr_len += hdrs_len;
+  uipbuf_set_len_field(ip_hdr, len);
+  if(lorh.has_encap) {
+    uipbuf_set_len_field((struct uip_ip_hdr *)&buf[hdrs_len], len - hdrs_len);
+  }
+  return 1;
 }
+/** @} */
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
 
 /*--------------------------------------------------------------------*/
@@ -1373,15 +2149,6 @@ digest_paging_dispatch(void)
   }
 }
 /*--------------------------------------------------------------------*/
-/**
- * \brief Digest 6lorh headers before IPHC
- */
-static void
-digest_6lorh_hdr(void)
-{
-  /* 6LoRH is not implemented yet */
-}
-/*--------------------------------------------------------------------*/
 /** \name IPv6 dispatch "compression" function
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
@@ -1513,6 +2280,330 @@ fragment_copy_payload_and_send(uint16_t uip_offset, linkaddr_t *dest) {
   return 1;
 }
 #endif /* SICSLOWPAN_CONF_FRAG */
+#if SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/** \name Fragment forwarding
+ *
+ * A router forwards the fragments of a packet that is not for itself
+ * without reassembling it, following draft-ietf-6lo-minimal-fragment.
+ * The first fragment goes through the IP layer, which picks the next
+ * hop and updates the headers. A virtual reassembly buffer (VRB) then
+ * maps the sender and tag of the incoming fragments to that next hop
+ * and to a new tag, and the next fragments are relayed as they come.
+ * @{
+ */
+/*--------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_lookup(uint16_t tag)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb[i].in_size > 0 && vrb[i].in_tag == tag &&
+       linkaddr_cmp(&vrb[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      if(timer_expired(&vrb[i].timer)) {
+        vrb[i].in_size = 0;
+        return NULL;
+      }
+      return &vrb[i];
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_alloc(uint16_t tag, uint16_t size)
+{
+  int i;
+  struct sicslowpan_vrb *found = NULL;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb[i].in_size > 0 && timer_expired(&vrb[i].timer)) {
+      vrb[i].in_size = 0;
+    }
+    if(found == NULL && vrb[i].in_size == 0) {
+      found = &vrb[i];
+    }
+  }
+
+  if(found != NULL) {
+    linkaddr_copy(&found->sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    found->in_tag = tag;
+    found->in_size = size;
+    found->out_size = 0;
+    found->remaining = size;
+    memset(found->received, 0, sizeof(found->received));
+    timer_set(&found->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+  }
+  return found;
+}
+/*--------------------------------------------------------------------*/
+/* Send a FRAGN of the packet of a VRB towards its next hop. The
+   payload may lie in packetbuf, past the FRAGN header. */
+static void
+vrb_send_fragment(struct sicslowpan_vrb *v, uint16_t offset,
+                  const uint8_t *payload, uint16_t len)
+{
+  uint8_t *frag;
+
+  offset += v->out_size - v->in_size;
+
+  packetbuf_clear();
+  frag = packetbuf_dataptr();
+  memmove(frag + SICSLOWPAN_FRAGN_HDR_LEN, payload, len);
+  SET16(frag, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAGN << 8) | v->out_size));
+  SET16(frag, PACKETBUF_FRAG_TAG, v->out_tag);
+  frag[PACKETBUF_FRAG_OFFSET] = offset >> 3;
+  packetbuf_set_datalen(SICSLOWPAN_FRAGN_HDR_LEN + len);
+
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, v->priority);
+  set_packetbuf_llsec_attrs();
+
+  LOG_INFO("forward: fragment (tag %d -> %d, payload %d, offset %d) to ",
+           v->in_tag, v->out_tag, len, offset);
+  LOG_INFO_LLADDR(&v->next_hop);
+  LOG_INFO_("\n");
+
+  send_packet(&v->next_hop);
+}
+/*--------------------------------------------------------------------*/
+/* Returns 1 if the len bytes at offset of the packet of a VRB lie
+   within the packet and none of them was relayed yet */
+static int
+vrb_is_new(const struct sicslowpan_vrb *v, uint16_t offset, uint16_t len)
+{
+  return len > 0 && offset + len <= v->in_size &&
+    count_units(v->received, offset >> 3, REASS_UNITS(offset + len)) == 0;
+}
+/*--------------------------------------------------------------------*/
+/* Account for the len bytes at offset of the packet of a VRB, and free
+   the VRB once the whole packet went through */
+static void
+vrb_consume(struct sicslowpan_vrb *v, uint16_t offset, uint16_t len)
+{
+  uint16_t unit;
+
+  for(unit = offset >> 3; unit < REASS_UNITS(offset + len); unit++) {
+    v->received[unit >> 3] |= 1 << (unit & 7);
+  }
+  v->remaining = len < v->remaining ? v->remaining - len : 0;
+  if(v->remaining == 0) {
+    v->in_size = 0;
+  }
+}
+/*--------------------------------------------------------------------*/
+/* Returns 1 if the packet whose first fragment, of len bytes, is
+   uncompressed in uip_buf is to be forwarded, following the checks of
+   uip_process(). Only the headers within the fragment are looked at. */
+static int
+first_fragment_is_transit(uint16_t len)
+{
+  uint8_t *next_header;
+  uint8_t protocol;
+
+  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr) ||
+     uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr) ||
+     uip_is_addr_loopback(&UIP_IP_BUF->destipaddr) ||
+     uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr) ||
+     uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    return 0;
+  }
+  if(!uip_ds6_is_my_addr(&UIP_IP_BUF->destipaddr)) {
+    return 1;
+  }
+
+  /* Addressed to us, but source routed further */
+  for(next_header = uipbuf_get_next_header(uip_buf, len, &protocol, true);
+      next_header != NULL && uip_is_proto_ext_hdr(protocol);
+      next_header = uipbuf_get_next_header(next_header, len - (next_header - uip_buf), &protocol, false)) {
+    if(protocol == UIP_PROTO_ROUTING) {
+      return ((struct uip_routing_hdr *)next_header)->seg_left > 0;
+    }
+  }
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+/* Try to forward the first fragment of a packet, whose headers are
+   uncompressed in uip_buf, without reassembling the packet. Returns 1
+   if the fragment was handled, or 0 if the packet is to be reassembled
+   here. */
+static int
+forward_first_fragment(uint16_t tag, uint16_t size)
+{
+  struct sicslowpan_vrb *v;
+  uint16_t first_len = uncomp_hdr_len + packetbuf_payload_len;
+  int8_t context;
+  int i;
+
+  if(size > UIP_BUFSIZE || first_len >= size || (first_len & 7) != 0 ||
+     !first_fragment_is_transit(first_len) ||
+     NETSTACK_ROUTING.node_is_root()) {
+    /* The root may add a routing header to the packet, which would no
+       longer fit the first fragment */
+    return 0;
+  }
+
+  v = vrb_alloc(tag, size);
+  if(v == NULL) {
+    LOG_WARN("forward: no VRB available, reassembling packet (tag %d)\n", tag);
+    return 0;
+  }
+  vrb_consume(v, 0, first_len);
+
+  /* Hand the first fragment to the IP layer, as if it was the whole
+     packet. It comes back to output() if it is to be forwarded, and
+     the ICMPv6 errors it may cause are not sent, as uip_buf does not
+     hold the rest of the packet. */
+  memcpy((uint8_t *)UIP_IP_BUF + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len,
+         packetbuf_payload_len);
+  uip_len = size;
+  vrb_pending = v;
+  vrb_first_len = first_len;
+  uip_ipaddr_copy(&vrb_src, &UIP_IP_BUF->srcipaddr);
+  set_uipbuf_llsec_attrs();
+  tcpip_input();
+  vrb_pending = NULL;
+
+  if(v->out_size == 0) {
+    /* Dropped by the IP layer: the VRB is kept so that the next
+       fragments are dropped too */
+    LOG_WARN("forward: first fragment not forwarded, dropping packet (tag %d)\n", tag);
+    return 1;
+  }
+
+  /* Relay the fragments that arrived before the first one */
+  for(context = 0; context < SICSLOWPAN_REASS_CONTEXTS; context++) {
+    if(frag_info[context].len > 0 && frag_info[context].tag == tag &&
+       linkaddr_cmp(&frag_info[context].sender, &v->sender)) {
+      for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
+        if(frag_buf[i].len > 0 && frag_buf[i].index == context &&
+           vrb_is_new(v, frag_buf[i].offset << 3, frag_buf[i].len)) {
+          vrb_send_fragment(v, frag_buf[i].offset << 3, frag_buf[i].data, frag_buf[i].len);
+          vrb_consume(v, frag_buf[i].offset << 3, frag_buf[i].len);
+        }
+      }
+      clear_fragments(context);
+      break;
+    }
+  }
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/* Relay a FRAGN if its packet has a VRB. Returns 1 if the fragment was
+   handled, or 0 if it is to be reassembled here. */
+static int
+forward_next_fragment(uint16_t tag, uint16_t size, uint16_t offset)
+{
+  struct sicslowpan_vrb *v = vrb_lookup(tag);
+  uint16_t len;
+
+  if(v == NULL) {
+    return 0;
+  }
+  if(v->in_size != size || offset >= size ||
+     packetbuf_datalen() < packetbuf_hdr_len) {
+    LOG_WARN("forward: invalid fragment (tag %d), dropping\n", tag);
+    return 1;
+  }
+
+  /* Extraneous bytes at the end of the packet are not relayed */
+  len = MIN(packetbuf_datalen() - packetbuf_hdr_len, size - offset);
+  if(!vrb_is_new(v, offset, len)) {
+    LOG_INFO("forward: duplicate or overlapping fragment (tag %d, offset %d), dropping\n",
+             tag, offset);
+    return 1;
+  }
+  if(v->out_size == 0) {
+    LOG_INFO("forward: dropping fragment of dropped packet (tag %d)\n", tag);
+  } else {
+    vrb_send_fragment(v, offset, packetbuf_ptr + packetbuf_hdr_len, len);
+  }
+  vrb_consume(v, offset, len);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/* Returns 1 if the packet in uip_buf is an ICMPv6 error message */
+static int
+is_icmp6_error(void)
+{
+  uint8_t proto;
+  const struct uip_icmp_hdr *icmp;
+
+  icmp = (const struct uip_icmp_hdr *)uipbuf_get_last_header(uip_buf, uip_len, &proto);
+  return icmp != NULL && proto == UIP_PROTO_ICMP6 && icmp->type < 128;
+}
+/*--------------------------------------------------------------------*/
+/* Send the first fragment of a packet being forwarded, in place of the
+   whole packet, once the IP layer has updated its headers. The headers
+   are already compressed in packetbuf. */
+static int
+output_first_fragment(linkaddr_t *dest)
+{
+  struct sicslowpan_vrb *v = vrb_pending;
+  int delta = (int)uip_len - (int)v->in_size;
+  uint16_t first_len = vrb_first_len + delta;
+  uint16_t frag1_len;
+
+  vrb_pending = NULL;
+
+  /* Extension headers grow or shrink by multiples of 8 bytes, so the
+     offsets of the next fragments just shift */
+  if((delta & 7) != 0 || first_len <= uncomp_hdr_len ||
+     linkaddr_cmp(dest, &linkaddr_null)) {
+    LOG_WARN("forward: headers changed, cannot forward first fragment (tag %d)\n",
+             v->in_tag);
+    return 0;
+  }
+
+  /* The compressed headers may have grown, e.g. with a hop limit that
+     can no longer be elided. What does not fit the FRAG1 any more is
+     sent in an extra FRAGN. */
+  frag1_len = MIN(first_len, (uncomp_hdr_len + mac_max_payload -
+                              packetbuf_hdr_len - SICSLOWPAN_FRAG1_HDR_LEN) & 0xfff8);
+  if(frag1_len <= uncomp_hdr_len) {
+    LOG_WARN("forward: headers do not fit first fragment (tag %d)\n", v->in_tag);
+    return 0;
+  }
+
+  /* Move IPHC/IPv6 header to make room for FRAG1 header */
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+  v->out_tag = my_tag++;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, v->out_tag);
+  packetbuf_payload_len = frag1_len - uncomp_hdr_len;
+
+  LOG_INFO("forward: first fragment (tag %d -> %d, payload %d) to ",
+           v->in_tag, v->out_tag, packetbuf_payload_len);
+  LOG_INFO_LLADDR(dest);
+  LOG_INFO_("\n");
+
+  if(fragment_copy_payload_and_send(uncomp_hdr_len, dest) == 0) {
+    return 0;
+  }
+
+  if(frag1_len < first_len) {
+    packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
+    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+          ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
+    PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = frag1_len >> 3;
+    packetbuf_payload_len = first_len - frag1_len;
+    if(fragment_copy_payload_and_send(frag1_len, dest) == 0) {
+      return 0;
+    }
+  }
+
+  linkaddr_copy(&v->next_hop, dest);
+  v->out_size = uip_len;
+  v->priority = packetbuf_attr(PACKETBUF_ATTR_PRIORITY);
+  return 1;
+}
+/** @} */
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 /*--------------------------------------------------------------------*/
 /** \brief Take an IP packet and format it to be sent on an 802.15.4
  *  network using 6lowpan.
@@ -1531,6 +2622,16 @@ output(const linkaddr_t *localdest)
   /* The MAC address of the destination of the packet */
   linkaddr_t dest;
 
+#if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC
+  /* The IPv6 header to compress with IPHC, and the offset in uip_buf of
+     what follows it */
+  const struct uip_ip_hdr *iphc_hdr = UIP_IP_BUF;
+  uint16_t iphc_hdr_len = UIP_IPH_LEN;
+#endif /* SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+  struct uip_ip_hdr lorh_iphc_hdr;
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
+
   /* init */
   uncomp_hdr_len = 0;
   packetbuf_hdr_len = 0;
@@ -1561,18 +2662,11 @@ output(const linkaddr_t *localdest)
   /* copy over the retransmission count from uipbuf attributes */
   packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
                      uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, packet_priority());
 
 /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_MAC */
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
-#if LLSEC802154_USES_AUX_HEADER
-  /* copy LLSEC level */
-  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL,
-    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_LEVEL));
-#if LLSEC802154_USES_EXPLICIT_KEYS
-  packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX,
-    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_KEY_ID));
-#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
-#endif /*  LLSEC802154_USES_AUX_HEADER */
+  set_packetbuf_llsec_attrs();
 
   mac_max_payload = NETSTACK_MAC.max_payload();
 
@@ -1591,11 +2685,12 @@ output(const linkaddr_t *localdest)
   (non link-local). */
   if(!uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr)) {
     add_paging_dispatch(1);
-    add_6lorh_hdr();
+    iphc_hdr_len = add_6lorh_hdr(&lorh_iphc_hdr);
+    iphc_hdr = &lorh_iphc_hdr;
   }
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
 #if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC
-  if(compress_hdr_iphc(&dest) == 0) {
+  if(compress_hdr_iphc(iphc_hdr, iphc_hdr_len, &dest) == 0) {
     /* Warning should already be issued by function above */
     return 0;
   }
@@ -1607,6 +2702,22 @@ output(const linkaddr_t *localdest)
 
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(vrb_pending != NULL) {
+    if(uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &vrb_src)) {
+      /* uip_buf only holds the first fragment of a packet being forwarded */
+      return output_first_fragment(&dest);
+    }
+    if(is_icmp6_error()) {
+      /* An error about that fragment would quote the rest of uip_buf,
+         which does not belong to the packet */
+      LOG_WARN("forward: not sending ICMPv6 error about fragment (tag %d)\n",
+               vrb_pending->in_tag);
+      return 0;
+    }
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   frag_needed = (int)uip_len - (int)uncomp_hdr_len + (int)packetbuf_hdr_len > mac_max_payload;
   LOG_INFO("output: header len %d -> %d, total len %d -> %d, MAC max payload %d, frag_needed %d\n",
             uncomp_hdr_len, packetbuf_hdr_len,
@@ -1751,8 +2862,8 @@ output(const linkaddr_t *localdest)
  *  copied in siclowpan_buf. If the IP packet is complete it is copied
  *  to uip_buf and the IP layer is called.
  *
- * \note We do not check for overlapping sicslowpan fragments
- * (it is a SHALL in the RFC 4944 and should never happen)
+ * Fragments may arrive in any order. Duplicate fragments are ignored,
+ * and overlapping ones discard the packet being reassembled.
  */
 static void
 input(void)
@@ -1769,7 +2880,7 @@ input(void)
 
   /* tag of the fragment */
   uint16_t frag_tag = 0;
-  uint8_t first_fragment = 0, last_fragment = 0;
+  uint8_t first_fragment = 0;
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
   /* Update link statistics */
@@ -1815,15 +2926,37 @@ input(void)
       LOG_INFO("input: received first element of a fragmented packet (tag %d, len %d)\n",
              frag_tag, frag_size);
 
-      /* Add the fragment to the fragmentation context */
-      frag_context = add_fragment(frag_tag, frag_size, frag_offset);
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(vrb_lookup(frag_tag) != NULL) {
+        LOG_INFO("input: duplicate first fragment (tag %d)\n", frag_tag);
+        return;
+      }
+      /* Uncompress into uip_buf to find out whether the packet is to be
+         forwarded. The reassembly context is only allocated if not. */
+      frag_context = -1;
+      buffer = (uint8_t *)UIP_IP_BUF;
+      break;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
+      /* Find or allocate the fragmentation context */
+      frag_context = get_fragment_context(frag_tag, frag_size);
 
       if(frag_context == -1) {
         LOG_ERR("input: failed to allocate new reassembly context\n");
         return;
       }
 
-      buffer = frag_info[frag_context].first_frag;
+      if(frag_info[frag_context].received[0] & 1) {
+        LOG_INFO("input: duplicate first fragment (tag %d)\n", frag_tag);
+        return;
+      }
+
+      /* If all other fragments are in, uncompress straight into uip_buf */
+      if(only_first_fragment_missing(frag_context)) {
+        buffer = (uint8_t *)UIP_IP_BUF;
+      } else {
+        buffer = frag_info[frag_context].first_frag;
+      }
       break;
     case SICSLOWPAN_DISPATCH_FRAGN:
       /*
@@ -1835,22 +2968,29 @@ input(void)
       frag_size = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0x07ff;
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
 
-      /* Add the fragment to the fragmentation context (this will also
-         copy the payload) */
-      frag_context = add_fragment(frag_tag, frag_size, frag_offset);
+      if(frag_offset == 0) {
+        LOG_ERR("input: FRAGN with zero offset (tag %d)\n", frag_tag);
+        return;
+      }
 
-      if(frag_context == -1) {
-        LOG_ERR("input: reassembly context not found (tag %d)\n", frag_tag);
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(forward_next_fragment(frag_tag, frag_size, (uint16_t)frag_offset << 3)) {
         return;
       }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
-      /* Ok - add_fragment will store the fragment automatically - so
-         we should not store more */
-      buffer = NULL;
+      /* Find or allocate the fragmentation context: fragments may
+         arrive before the first one */
+      frag_context = get_fragment_context(frag_tag, frag_size);
 
-      if(frag_info[frag_context].reassembled_len >= frag_size) {
-        last_fragment = 1;
+      if(frag_context == -1) {
+        LOG_ERR("input: failed to allocate reassembly context (tag %d)\n", frag_tag);
+        return;
       }
+
+      /* Ok - add_fragment will store the fragment - so we should not
+         store more */
+      buffer = NULL;
       is_fragment = 1;
       break;
     default:
@@ -1868,7 +3008,18 @@ input(void)
   digest_paging_dispatch();
   if(curr_page == 1) {
     LOG_INFO("input: page 1, 6LoRH\n");
-    digest_6lorh_hdr();
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+    if(!digest_6lorh_hdr()) {
+      return;
+    }
+#if SICSLOWPAN_CONF_FRAG
+    if(first_fragment) {
+      /* The headers rebuilt from 6LoRH may not fit first_frag, leave it
+         to add_fragment() to check */
+      buffer = (uint8_t *)UIP_IP_BUF;
+    }
+#endif /* SICSLOWPAN_CONF_FRAG */
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
   } else if (curr_page > 1) {
     LOG_ERR("input: page %u not supported\n", curr_page);
     return;
@@ -1878,6 +3029,11 @@ input(void)
   if((PACKETBUF_6LO_PTR[PACKETBUF_6LO_DISPATCH] & SICSLOWPAN_DISPATCH_IPHC_MASK) == SICSLOWPAN_DISPATCH_IPHC) {
     LOG_DBG("uncompression: IPHC dispatch\n");
     uncompress_hdr_iphc(buffer, frag_size);
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+    if(curr_page == 1 && !lorh_rebuild(buffer, frag_size)) {
+      return;
+    }
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
   } else if(PACKETBUF_6LO_PTR[PACKETBUF_6LO_DISPATCH] == SICSLOWPAN_DISPATCH_IPV6) {
     LOG_DBG("uncompression: IPV6 dispatch\n");
     packetbuf_hdr_len += SICSLOWPAN_IPV6_HDR_LEN;
@@ -1930,80 +3086,68 @@ input(void)
     }
   }
 
-  /* copy the payload if buffer is non-null - which is only the case with first fragment
-     or packets that are non fragmented */
-  if(buffer != NULL) {
-    memcpy((uint8_t *)buffer + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len, packetbuf_payload_len);
-  }
-
-  /* update processed_ip_in_len if fragment, sicslowpan_len otherwise */
-
 #if SICSLOWPAN_CONF_FRAG
-  if(frag_size > 0) {
-    /* Add the size of the header only for the first fragment. */
-    if(first_fragment != 0) {
-      frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
-      frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+  if(is_fragment) {
+#if SICSLOWPAN_FRAG_FORWARDING
+    if(frag_context < 0) {
+      if(forward_first_fragment(frag_tag, frag_size)) {
+        return;
+      }
+      /* The packet is for us: reassemble it */
+      frag_context = get_fragment_context(frag_tag, frag_size);
+      if(frag_context == -1) {
+        LOG_ERR("input: failed to allocate new reassembly context\n");
+        return;
+      }
+      if(frag_info[frag_context].received[0] & 1) {
+        LOG_INFO("input: duplicate first fragment (tag %d)\n", frag_tag);
+        return;
+      }
     }
-    /* For the last fragment, we are OK if there is extrenous bytes at
-       the end of the packet. */
-    if(last_fragment != 0) {
-      frag_info[frag_context].reassembled_len = frag_size;
-      /* copy to uip */
-      copy_frags2uip(frag_context);
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+    /* Add the fragment to its context, and wait for the others unless
+       the packet is now complete in uip_buf */
+    if(!add_fragment(frag_context, buffer, (uint16_t)frag_offset << 3)) {
+      return;
     }
+    uip_len = frag_size;
+  } else
+#endif /* SICSLOWPAN_CONF_FRAG */
+  {
+    /* Not fragmented: copy the payload after the uncompressed headers */
+    memcpy((uint8_t *)buffer + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len, packetbuf_payload_len);
+    uip_len = packetbuf_payload_len + uncomp_hdr_len;
   }
 
   /*
-   * If we have a full IP packet in sicslowpan_buf, deliver it to
-   * the IP stack
+   * We have a full IP packet in uip_buf, deliver it to the IP stack
    */
-  if(!is_fragment || last_fragment) {
-    /* packet is in uip already - just set length */
-    if(is_fragment != 0 && last_fragment != 0) {
-      uip_len = frag_size;
-    } else {
-      uip_len = packetbuf_payload_len + uncomp_hdr_len;
-    }
-#else
-    uip_len = packetbuf_payload_len + uncomp_hdr_len;
-#endif /* SICSLOWPAN_CONF_FRAG */
-    LOG_INFO("input: received IPv6 packet with len %d\n",
-             uip_len);
-
-    if(LOG_DBG_ENABLED) {
-      uint16_t ndx;
-      LOG_DBG("uncompression: after (%u):", UIP_IP_BUF->len[1]);
-      for (ndx = 0; ndx < UIP_IP_BUF->len[1] + 40; ndx++) {
-        uint8_t data = ((uint8_t *) (UIP_IP_BUF))[ndx];
-        LOG_DBG_("%02x", data);
-      }
-      LOG_DBG_("\n");
-    }
+  LOG_INFO("input: received IPv6 packet with len %d\n",
+           uip_len);
 
-    /* if callback is set then set attributes and call */
-    if(callback) {
-      set_packet_attrs();
-      callback->input_callback();
+  if(LOG_DBG_ENABLED) {
+    uint16_t ndx;
+    LOG_DBG("uncompression: after (%u):", UIP_IP_BUF->len[1]);
+    for (ndx = 0; ndx < UIP_IP_BUF->len[1] + 40; ndx++) {
+      uint8_t data = ((uint8_t *) (UIP_IP_BUF))[ndx];
+      LOG_DBG_("%02x", data);
     }
+    LOG_DBG_("\n");
+  }
 
-#if LLSEC802154_USES_AUX_HEADER
-    /*
-     * Assuming that the last packet in packetbuf is containing
-     *  the LLSEC state so that it can be copied to uipbuf.
-     */
-    uipbuf_set_attr(UIPBUF_ATTR_LLSEC_LEVEL,
-      packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL));
-#if LLSEC802154_USES_EXPLICIT_KEYS
-    uipbuf_set_attr(UIPBUF_ATTR_LLSEC_KEY_ID,
-      packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX));
-#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
-#endif /*  LLSEC802154_USES_AUX_HEADER */
-
-    tcpip_input();
-#if SICSLOWPAN_CONF_FRAG
+  /* if callback is set then set attributes and call */
+  if(callback) {
+    set_packet_attrs();
+    callback->input_callback();
   }
-#endif /* SICSLOWPAN_CONF_FRAG */
+
+  /*
+   * Assuming that the last packet in packetbuf is containing
+   *  the LLSEC state so that it can be copied to uipbuf.
+   */
+  set_uipbuf_llsec_attrs();
+
+  tcpip_input();
 }
 /** @} */
 
@@ -2014,7 +3158,7 @@ void
 sicslowpan_init(void)
 {
 
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPHC
+#if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC
 /* Preinitialize any address contexts for better header compression
  * (Saves up to 13 bytes per 6lowpan packet)
  * The platform contiki-conf.h file can override this using e.g.
@@ -2056,7 +3200,7 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPHC */
+#endif /* SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC */
 }
 /*--------------------------------------------------------------------*/
 int
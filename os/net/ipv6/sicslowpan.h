@@ -71,8 +71,8 @@
 #define SICSLOWPAN_COMPRESSION_IPV6        0 /* No compression */
 #define SICSLOWPAN_COMPRESSION_IPHC        1 /* RFC 6282 */
 #define SICSLOWPAN_COMPRESSION_6LORH       2 /* RFC 8025 for paging dispatch,
-              * draft-ietf-6lo-routin-dispatch-05 for 6LoRH. 6LoRH is not
-              * implemented yet -- only support for paging dispatch. */
+              * RFC 8138 for 6LoRH: RPL option, source routing header and
+              * IPv6-in-IPv6 encapsulation, on top of IPHC. */
 /** @} */
 
 /**
@@ -88,6 +88,27 @@
 #define SICSLOWPAN_DISPATCH_FRAG_MASK               0xf8
 #define SICSLOWPAN_DISPATCH_PAGING                  0xf0 /* 1111xxxx */
 #define SICSLOWPAN_DISPATCH_PAGING_MASK             0xf0
+#define SICSLOWPAN_DISPATCH_6LORH                   0x80 /* 10xxxxxx, page 1 */
+#define SICSLOWPAN_DISPATCH_6LORH_MASK              0xc0
+/** @} */
+
+/**
+ * \name 6LoRH encoding (RFC 8138)
+ * @{
+ */
+#define SICSLOWPAN_6LORH_ELECTIVE                   0x20 /* 101xxxxx */
+#define SICSLOWPAN_6LORH_TSE_MASK                   0x1f
+/* Critical 6LoRH types: RH3 with 1, 2, 4, 8 or 16 bytes per hop, RPI */
+#define SICSLOWPAN_6LORH_TYPE_RH3_1                 0
+#define SICSLOWPAN_6LORH_TYPE_RH3_16                4
+#define SICSLOWPAN_6LORH_TYPE_RPI                   5
+/* Elective 6LoRH types */
+#define SICSLOWPAN_6LORH_TYPE_IP_IN_IP              6
+/* RPI-6LoRH TSE: O, R, F flags of the RPL option, elided RPLInstanceID,
+   and SenderRank with its low-order byte elided */
+#define SICSLOWPAN_6LORH_RPI_FLAGS                  0x1c
+#define SICSLOWPAN_6LORH_RPI_I                      0x02
+#define SICSLOWPAN_6LORH_RPI_K                      0x01
 /** @} */
 
 /** \name HC1 encoding
@@ -809,6 +809,10 @@ PROCESS_THREAD(tcpip_process, ev, data)
 {
   PROCESS_BEGIN();
 
+  /* Keep timers and connection polls of the stack ahead of application
+     events when the event queue is prioritized */
+  process_set_priority(PROCESS_CURRENT(), PROCESS_PRIORITY_HIGH);
+
 #if UIP_TCP
   memset(s.listenports, 0, UIP_LISTENPORTS*sizeof(*(s.listenports)));
   s.p = PROCESS_CURRENT();
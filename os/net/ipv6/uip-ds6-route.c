@@ -91,6 +91,24 @@ MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 static int num_routes = 0;
 static void rm_routelist_callback(nbr_table_item_t *ptr);
 
+#if UIP_DS6_ROUTE_TRIE
+/* Routes are additionally indexed by a path-compressed binary trie
+   keyed on the route prefix. Nodes that carry no route only exist to
+   join two subtrees, so at most 2 * UIP_DS6_ROUTE_NB - 1 nodes are
+   needed. Keys are truncated to whole bytes to match the semantics of
+   uip_ipaddr_prefixcmp() used by the list-based lookup. */
+struct route_trie_node {
+  struct route_trie_node *child[2];
+  uip_ds6_route_t *route;
+  uip_ipaddr_t prefix;
+  uint8_t length;
+};
+MEMB(routetriememb, struct route_trie_node, 2 * UIP_DS6_ROUTE_NB);
+static struct route_trie_node *route_trie_root;
+
+#define ROUTE_TRIE_KEY_LEN(length) ((length) & ~0x07)
+#endif /* UIP_DS6_ROUTE_TRIE */
+
 #endif /* (UIP_MAX_ROUTES != 0) */
 
 /* Default routes are held on the defaultrouterlist and their
@@ -174,6 +192,10 @@ uip_ds6_route_init(void)
 #if (UIP_MAX_ROUTES != 0)
   memb_init(&routememb);
   list_init(routelist);
+#if UIP_DS6_ROUTE_TRIE
+  memb_init(&routetriememb);
+  route_trie_root = NULL;
+#endif /* UIP_DS6_ROUTE_TRIE */
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 #endif /* (UIP_MAX_ROUTES != 0) */
@@ -186,6 +208,174 @@ uip_ds6_route_init(void)
 #endif
 }
 #if (UIP_MAX_ROUTES != 0)
+#if UIP_DS6_ROUTE_TRIE
+/*---------------------------------------------------------------------------*/
+static uint8_t
+route_trie_bit(const uip_ipaddr_t *addr, uint8_t pos)
+{
+  return (addr->u8[pos >> 3] >> (7 - (pos & 0x07))) & 0x01;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the number of leading bits a and b have in common, up to max */
+static uint8_t
+route_trie_common_len(const uip_ipaddr_t *a, const uip_ipaddr_t *b,
+                      uint8_t max)
+{
+  uint8_t len;
+  uint8_t diff;
+
+  for(len = 0; len < max; len += 8) {
+    diff = a->u8[len >> 3] ^ b->u8[len >> 3];
+    if(diff != 0) {
+      while((diff & 0x80) == 0) {
+        diff <<= 1;
+        len++;
+      }
+      break;
+    }
+  }
+  return MIN(len, max);
+}
+/*---------------------------------------------------------------------------*/
+static struct route_trie_node *
+route_trie_node_alloc(const uip_ipaddr_t *prefix, uint8_t length,
+                      uip_ds6_route_t *route)
+{
+  struct route_trie_node *n;
+
+  n = memb_alloc(&routetriememb);
+  if(n != NULL) {
+    n->child[0] = n->child[1] = NULL;
+    n->route = route;
+    uip_ipaddr_copy(&n->prefix, prefix);
+    n->length = length;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_trie_lookup(const uip_ipaddr_t *addr)
+{
+  struct route_trie_node *n;
+  uip_ds6_route_t *found_route;
+
+  found_route = NULL;
+  n = route_trie_root;
+  while(n != NULL &&
+        route_trie_common_len(addr, &n->prefix, n->length) == n->length) {
+    if(n->route != NULL) {
+      found_route = n->route;
+    }
+    if(n->length == 128) {
+      break;
+    }
+    n = n->child[route_trie_bit(addr, n->length)];
+  }
+  return found_route;
+}
+/*---------------------------------------------------------------------------*/
+static int
+route_trie_insert(uip_ds6_route_t *r)
+{
+  struct route_trie_node **link;
+  struct route_trie_node *n;
+  struct route_trie_node *new_node;
+  struct route_trie_node *glue;
+  uint8_t len;
+  uint8_t common;
+
+  len = ROUTE_TRIE_KEY_LEN(r->length);
+  for(link = &route_trie_root; (n = *link) != NULL;
+      link = &n->child[route_trie_bit(&r->ipaddr, n->length)]) {
+    common = route_trie_common_len(&r->ipaddr, &n->prefix,
+                                   MIN(len, n->length));
+    if(common == n->length) {
+      if(n->length == len) {
+        /* Same prefix: the most recently added route wins */
+        n->route = r;
+        return 1;
+      }
+      /* n covers our prefix, descend */
+      continue;
+    }
+
+    /* Our prefix diverges from n, or ends, before n does */
+    new_node = route_trie_node_alloc(&r->ipaddr, len, r);
+    if(new_node == NULL) {
+      return 0;
+    }
+    if(common == len) {
+      new_node->child[route_trie_bit(&n->prefix, len)] = n;
+    } else {
+      glue = route_trie_node_alloc(&r->ipaddr, common, NULL);
+      if(glue == NULL) {
+        memb_free(&routetriememb, new_node);
+        return 0;
+      }
+      glue->child[route_trie_bit(&r->ipaddr, common)] = new_node;
+      glue->child[route_trie_bit(&n->prefix, common)] = n;
+      new_node = glue;
+    }
+    *link = new_node;
+    return 1;
+  }
+
+  *link = route_trie_node_alloc(&r->ipaddr, len, r);
+  return *link != NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Must be called after r has been removed from the routelist */
+static void
+route_trie_remove(uip_ds6_route_t *r)
+{
+  struct route_trie_node **link;
+  struct route_trie_node **parent_link;
+  struct route_trie_node *n;
+  struct route_trie_node *parent;
+  uip_ds6_route_t *other;
+  uint8_t len;
+
+  len = ROUTE_TRIE_KEY_LEN(r->length);
+  parent_link = NULL;
+  for(link = &route_trie_root;
+      (n = *link) != NULL && n->length < len;
+      link = &n->child[route_trie_bit(&r->ipaddr, n->length)]) {
+    parent_link = link;
+  }
+  if(n == NULL || n->route != r) {
+    return;
+  }
+
+  /* Another route with the same key may have been shadowed by r */
+  for(other = list_head(routelist);
+      other != NULL;
+      other = list_item_next(other)) {
+    if(ROUTE_TRIE_KEY_LEN(other->length) == len &&
+       route_trie_common_len(&other->ipaddr, &n->prefix, len) == len) {
+      n->route = other;
+      return;
+    }
+  }
+
+  n->route = NULL;
+  if(n->child[0] != NULL && n->child[1] != NULL) {
+    /* Still needed to join its two subtrees */
+    return;
+  }
+  *link = n->child[0] != NULL ? n->child[0] : n->child[1];
+  memb_free(&routetriememb, n);
+
+  /* A route-less parent left with a single child is no longer needed */
+  if(*link == NULL && parent_link != NULL) {
+    parent = *parent_link;
+    if(parent->route == NULL) {
+      *parent_link = parent->child[0] != NULL ?
+        parent->child[0] : parent->child[1];
+      memb_free(&routetriememb, parent);
+    }
+  }
+}
+#endif /* UIP_DS6_ROUTE_TRIE */
 /*---------------------------------------------------------------------------*/
 static uip_lladdr_t *
 uip_ds6_route_nexthop_lladdr(uip_ds6_route_t *route)
@@ -266,9 +456,11 @@ uip_ds6_route_t *
 uip_ds6_route_lookup(const uip_ipaddr_t *addr)
 {
 #if (UIP_MAX_ROUTES != 0)
-  uip_ds6_route_t *r;
   uip_ds6_route_t *found_route;
+#if !UIP_DS6_ROUTE_TRIE
+  uip_ds6_route_t *r;
   uint8_t longestmatch;
+#endif /* !UIP_DS6_ROUTE_TRIE */
 
   LOG_INFO("Looking up route for ");
   LOG_INFO_6ADDR(addr);
@@ -278,6 +470,9 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     return NULL;
   }
 
+#if UIP_DS6_ROUTE_TRIE
+  found_route = route_trie_lookup(addr);
+#else /* UIP_DS6_ROUTE_TRIE */
   found_route = NULL;
   longestmatch = 0;
   for(r = uip_ds6_route_head();
@@ -293,6 +488,7 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
       }
     }
   }
+#endif /* UIP_DS6_ROUTE_TRIE */
 
   if(found_route != NULL) {
     LOG_INFO("Found route: ");
@@ -304,6 +500,9 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     LOG_WARN("No route found\n");
   }
 
+#if !UIP_DS6_ROUTE_TRIE || UIP_DS6_ROUTE_REMOVE_LEAST_RECENTLY_USED
+  /* With the trie index the list order does not speed up lookups, so
+     only maintain it when needed for least recently used eviction. */
   if(found_route != NULL && found_route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
@@ -313,6 +512,7 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     list_remove(routelist, found_route);
     list_push(routelist, found_route);
   }
+#endif /* !UIP_DS6_ROUTE_TRIE || UIP_DS6_ROUTE_REMOVE_LEAST_RECENTLY_USED */
 
   return found_route;
 #else /* (UIP_MAX_ROUTES != 0) */
@@ -456,6 +656,15 @@ uip_ds6_route_add(const uip_ipaddr_t *ipaddr, uint8_t length,
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
 
+#if UIP_DS6_ROUTE_TRIE
+  if(!route_trie_insert(r)) {
+    /* This should not happen, as the trie is sized for a full table */
+    LOG_ERR("Add: could not index route\n");
+    uip_ds6_route_rm(r);
+    return NULL;
+  }
+#endif /* UIP_DS6_ROUTE_TRIE */
+
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
 #endif
@@ -500,6 +709,9 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 
     /* Remove the route from the route list */
     list_remove(routelist, route);
+#if UIP_DS6_ROUTE_TRIE
+    route_trie_remove(route);
+#endif /* UIP_DS6_ROUTE_TRIE */
 
     /* Find the corresponding neighbor_route and remove it. */
     for(neighbor_route = list_head(route->neighbor_routes->route_list);
@@ -111,6 +111,16 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define UIP_DS6_ROUTE_NB 4
 #endif /* UIP_MAX_ROUTES */
 
+/** \brief Set non-zero (1) to index the routing table with a
+ * path-compressed binary (patricia) trie. Lookups then cost
+ * O(prefix length) instead of a scan of the whole route list, at the
+ * price of up to 2 * UIP_DS6_ROUTE_NB trie nodes of RAM. */
+#ifdef UIP_DS6_ROUTE_CONF_TRIE
+#define UIP_DS6_ROUTE_TRIE UIP_DS6_ROUTE_CONF_TRIE
+#else
+#define UIP_DS6_ROUTE_TRIE 0
+#endif /* UIP_DS6_ROUTE_CONF_TRIE */
+
 /** \brief define some additional RPL related route state and
  *  neighbor callback for RPL - if not a DS6_ROUTE_STATE is already set */
 #ifndef UIP_DS6_ROUTE_STATE_TYPE
@@ -119,6 +129,8 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define RPL_ROUTE_ENTRY_NOPATH_RECEIVED   0x01
 #define RPL_ROUTE_ENTRY_DAO_PENDING       0x02
 #define RPL_ROUTE_ENTRY_DAO_NACK          0x04
+#define RPL_ROUTE_ENTRY_DAO_DELTA         0x08
+#define RPL_ROUTE_ENTRY_DAO_UNACKED       0x10
 
 #define RPL_ROUTE_IS_NOPATH_RECEIVED(route)                             \
   (((route)->state.state_flags & RPL_ROUTE_ENTRY_NOPATH_RECEIVED) != 0)
@@ -147,6 +159,26 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
     (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_NACK;            \
   } while(0)
 
+/* The route changed since it was last advertised to our parent */
+#define RPL_ROUTE_IS_DAO_DELTA(route)                                   \
+  (((route)->state.state_flags & RPL_ROUTE_ENTRY_DAO_DELTA) != 0)
+#define RPL_ROUTE_SET_DAO_DELTA(route) do {                             \
+    (route)->state.state_flags |= RPL_ROUTE_ENTRY_DAO_DELTA;            \
+  } while(0)
+#define RPL_ROUTE_CLEAR_DAO_DELTA(route) do {                           \
+    (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_DELTA;           \
+  } while(0)
+
+/* The change was sent to our parent, which did not acknowledge it yet */
+#define RPL_ROUTE_IS_DAO_UNACKED(route)                                 \
+  (((route)->state.state_flags & RPL_ROUTE_ENTRY_DAO_UNACKED) != 0)
+#define RPL_ROUTE_SET_DAO_UNACKED(route) do {                           \
+    (route)->state.state_flags |= RPL_ROUTE_ENTRY_DAO_UNACKED;          \
+  } while(0)
+#define RPL_ROUTE_CLEAR_DAO_UNACKED(route) do {                         \
+    (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_UNACKED;         \
+  } while(0)
+
 #define RPL_ROUTE_CLEAR_DAO(route) do {                                 \
     (route)->state.state_flags &= ~(RPL_ROUTE_ENTRY_DAO_NACK|RPL_ROUTE_ENTRY_DAO_PENDING); \
   } while(0)
@@ -58,6 +58,20 @@ static int num_nodes;
 LIST(nodelist);
 MEMB(nodememb, uip_sr_node_t, UIP_SR_LINK_NUM);
 
+#if UIP_SR_HASH_SIZE
+/* Every known node, indexed by link identifier */
+static uip_sr_node_t *hash_table[UIP_SR_HASH_SIZE];
+#endif /* UIP_SR_HASH_SIZE */
+
+#if UIP_SR_PATH_CACHE
+#define PATH_LEN_UNREACHABLE 0xffff
+/* Version of the graph, incremented on every link change. A cached path
+ * length is valid only if it was computed for the current version. */
+static uint16_t path_version;
+/* The root the cached path lengths lead to */
+static uip_sr_node_t *path_root;
+#endif /* UIP_SR_PATH_CACHE */
+
 /*---------------------------------------------------------------------------*/
 int
 uip_sr_num_nodes(void)
@@ -65,11 +79,136 @@ uip_sr_num_nodes(void)
   return num_nodes;
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_SR_HASH_SIZE
+static unsigned
+hash_link_identifier(const unsigned char *link_identifier)
+{
+  unsigned hash = 0;
+  int i;
+  for(i = 0; i < 8; i++) {
+    hash = hash * 31 + link_identifier[i];
+  }
+  return hash % UIP_SR_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_add(uip_sr_node_t *node)
+{
+  uip_sr_node_t **l;
+  /* Append, so that lookups find the same node as a scan of nodelist */
+  l = &hash_table[hash_link_identifier(node->link_identifier)];
+  while(*l != NULL) {
+    l = &(*l)->hash_next;
+  }
+  node->hash_next = NULL;
+  *l = node;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(uip_sr_node_t *node)
+{
+  uip_sr_node_t **l;
+  for(l = &hash_table[hash_link_identifier(node->link_identifier)];
+      *l != NULL; l = &(*l)->hash_next) {
+    if(*l == node) {
+      *l = node->hash_next;
+      return;
+    }
+  }
+}
+#endif /* UIP_SR_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
+static void
+invalidate_paths(void)
+{
+#if UIP_SR_PATH_CACHE
+  if(++path_version == 0) {
+    /* The version wrapped around, make sure that no block of the pool
+       still holds a path length cached for the new version */
+    uip_sr_node_t *nodes = (uip_sr_node_t *)nodememb.mem;
+    int i;
+    for(i = 0; i < nodememb.num; i++) {
+      nodes[i].path_version = 0;
+    }
+    path_version = 1;
+  }
+#endif /* UIP_SR_PATH_CACHE */
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_SR_PATH_CACHE
+static uint16_t
+get_path_len(uip_sr_node_t *node, uip_sr_node_t *root_node)
+{
+  int max_depth = UIP_SR_LINK_NUM;
+  uint16_t len;
+  uint16_t path_len;
+  uip_sr_node_t *l;
+
+  if(root_node != path_root) {
+    path_root = root_node;
+    invalidate_paths();
+  }
+
+  /* Walk up to the root, or to the first node with a valid cached path */
+  len = 0;
+  for(l = node; l != NULL && l != root_node && l->path_version != path_version
+        && max_depth > 0; l = l->parent) {
+    len++;
+    max_depth--;
+  }
+
+  if(l != NULL && l == root_node) {
+    path_len = len;
+  } else if(l != NULL && l->path_version == path_version
+            && l->path_len != PATH_LEN_UNREACHABLE) {
+    path_len = l->path_len + len;
+  } else {
+    path_len = PATH_LEN_UNREACHABLE;
+  }
+
+  /* All nodes on the way share the same path, cache it for them too */
+  len = path_len;
+  for(; node != l; node = node->parent) {
+    node->path_len = len;
+    node->path_version = path_version;
+    if(len != PATH_LEN_UNREACHABLE) {
+      len--;
+    }
+  }
+
+  return path_len;
+}
+#endif /* UIP_SR_PATH_CACHE */
+/*---------------------------------------------------------------------------*/
+static void
+set_parent(uip_sr_node_t *node, uip_sr_node_t *parent)
+{
+  if(node->parent != parent) {
+    node->parent = parent;
+    invalidate_paths();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_node(uip_sr_node_t *node)
+{
+#if UIP_SR_HASH_SIZE
+  hash_remove(node);
+#endif /* UIP_SR_HASH_SIZE */
+  list_remove(nodelist, node);
+  memb_free(&nodememb, node);
+  num_nodes--;
+  invalidate_paths();
+}
+/*---------------------------------------------------------------------------*/
 static int
 node_matches_address(void *graph, const uip_sr_node_t *node, const uip_ipaddr_t *addr)
 {
   if(node == NULL || addr == NULL || graph != node->graph) {
     return 0;
+  } else if(memcmp(node->link_identifier, ((const unsigned char *)addr) + 8, 8)) {
+    /* Different link identifier, no need to build the full address */
+    return 0;
   } else {
     uip_ipaddr_t node_ipaddr;
     NETSTACK_ROUTING.get_sr_node_ipaddr(&node_ipaddr, node);
@@ -81,7 +220,15 @@ uip_sr_node_t *
 uip_sr_get_node(void *graph, const uip_ipaddr_t *addr)
 {
   uip_sr_node_t *l;
+#if UIP_SR_HASH_SIZE
+  if(addr == NULL) {
+    return NULL;
+  }
+  for(l = hash_table[hash_link_identifier(((const unsigned char *)addr) + 8)];
+      l != NULL; l = l->hash_next) {
+#else /* UIP_SR_HASH_SIZE */
   for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
+#endif /* UIP_SR_HASH_SIZE */
     /* Compare prefix and node identifier */
     if(node_matches_address(graph, l, addr)) {
       return l;
@@ -93,7 +240,9 @@ uip_sr_get_node(void *graph, const uip_ipaddr_t *addr)
 int
 uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr)
 {
+#if !UIP_SR_PATH_CACHE
   int max_depth = UIP_SR_LINK_NUM;
+#endif /* !UIP_SR_PATH_CACHE */
   uip_ipaddr_t root_ipaddr;
   uip_sr_node_t *node;
   uip_sr_node_t *root_node;
@@ -102,11 +251,16 @@ uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr)
   node = uip_sr_get_node(graph, addr);
   root_node = uip_sr_get_node(graph, &root_ipaddr);
 
+#if UIP_SR_PATH_CACHE
+  return node != NULL && root_node != NULL
+    && get_path_len(node, root_node) != PATH_LEN_UNREACHABLE;
+#else /* UIP_SR_PATH_CACHE */
   while(node != NULL && node != root_node && max_depth > 0) {
     node = node->parent;
     max_depth--;
   }
   return node != NULL && node == root_node;
+#endif /* UIP_SR_PATH_CACHE */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -119,23 +273,33 @@ uip_sr_expire_parent(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t
   }
 }
 /*---------------------------------------------------------------------------*/
-uip_sr_node_t *
-uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *parent, uint32_t lifetime)
+/* Returns the node of a parent, adding one with infinite lifetime if
+   needed. Sets *parent_node to NULL for a NULL parent. Returns 0 if
+   there is no space left. */
+static int
+get_parent_node(void *graph, const uip_ipaddr_t *parent, uip_sr_node_t **parent_node)
 {
-  uip_sr_node_t *child_node = uip_sr_get_node(graph, child);
-  uip_sr_node_t *parent_node = uip_sr_get_node(graph, parent);
-  uip_sr_node_t *old_parent_node;
+  *parent_node = uip_sr_get_node(graph, parent);
 
   if(parent != NULL) {
     /* No node for the parent, add one with infinite lifetime */
-    if(parent_node == NULL) {
-      parent_node = uip_sr_update_node(graph, parent, NULL, UIP_SR_INFINITE_LIFETIME);
-      if(parent_node == NULL) {
+    if(*parent_node == NULL) {
+      *parent_node = uip_sr_update_node(graph, parent, NULL, UIP_SR_INFINITE_LIFETIME);
+      if(*parent_node == NULL) {
         LOG_ERR("NS: no space left for root node!\n");
-        return NULL;
+        return 0;
       }
     }
   }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static uip_sr_node_t *
+update_child(void *graph, const uip_ipaddr_t *child, uip_sr_node_t *parent_node,
+             const uip_ipaddr_t *parent, uint32_t lifetime)
+{
+  uip_sr_node_t *child_node = uip_sr_get_node(graph, child);
+  uip_sr_node_t *old_parent_node;
 
   /* No node for this child, add one */
   if(child_node == NULL) {
@@ -148,29 +312,38 @@ uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *p
       return NULL;
     }
     child_node->parent = NULL;
+#if UIP_SR_PATH_CACHE
+    child_node->path_version = 0;
+#endif /* UIP_SR_PATH_CACHE */
+    memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
+#if UIP_SR_HASH_SIZE
+    hash_add(child_node);
+#endif /* UIP_SR_HASH_SIZE */
     list_add(nodelist, child_node);
     num_nodes++;
+    /* The block may be referred to as parent by children of the node that
+       used it before */
+    invalidate_paths();
   }
 
   /* Initialize node */
   child_node->graph = graph;
   child_node->lifetime = lifetime;
-  memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
 
   /* Is the node reachable before the update? */
   if(uip_sr_is_addr_reachable(graph, child)) {
     old_parent_node = child_node->parent;
     /* Update node */
-    child_node->parent = parent_node;
+    set_parent(child_node, parent_node);
     /* Has the node become unreachable? May happen if we create a loop. */
     if(!uip_sr_is_addr_reachable(graph, child)) {
       /* The new parent makes the node unreachable, restore old parent.
        * We will take the update next time, with chances we know more of
        * the topology and the loop is gone. */
-      child_node->parent = old_parent_node;
+      set_parent(child_node, old_parent_node);
     }
   } else {
-    child_node->parent = parent_node;
+    set_parent(child_node, parent_node);
   }
 
   LOG_INFO("NS: updating link, child ");
@@ -182,12 +355,48 @@ uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *p
   return child_node;
 }
 /*---------------------------------------------------------------------------*/
+uip_sr_node_t *
+uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *parent, uint32_t lifetime)
+{
+  uip_sr_node_t *parent_node;
+
+  if(!get_parent_node(graph, parent, &parent_node)) {
+    return NULL;
+  }
+  return update_child(graph, child, parent_node, parent, lifetime);
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_sr_update_nodes(void *graph, const uip_ipaddr_t *children, int count,
+                    const uip_ipaddr_t *parent, uint32_t lifetime)
+{
+  uip_sr_node_t *parent_node;
+  int updated;
+
+  if(!get_parent_node(graph, parent, &parent_node)) {
+    return 0;
+  }
+  for(updated = 0; updated < count; updated++) {
+    if(update_child(graph, &children[updated], parent_node, parent, lifetime) == NULL) {
+      break;
+    }
+  }
+  return updated;
+}
+/*---------------------------------------------------------------------------*/
 void
 uip_sr_init(void)
 {
   num_nodes = 0;
   memb_init(&nodememb);
   list_init(nodelist);
+#if UIP_SR_HASH_SIZE
+  memset(hash_table, 0, sizeof(hash_table));
+#endif /* UIP_SR_HASH_SIZE */
+#if UIP_SR_PATH_CACHE
+  path_version = 1;
+  path_root = NULL;
+#endif /* UIP_SR_PATH_CACHE */
 }
 /*---------------------------------------------------------------------------*/
 uip_sr_node_t *
@@ -226,9 +435,7 @@ uip_sr_periodic(unsigned seconds)
         LOG_INFO_("\n");
       }
       /* No child found, deallocate node */
-      list_remove(nodelist, l);
-      memb_free(&nodememb, l);
-      num_nodes--;
+      remove_node(l);
     } else if(l->lifetime != UIP_SR_INFINITE_LIFETIME) {
       l->lifetime = l->lifetime > seconds ? l->lifetime - seconds : 0;
     }
@@ -242,9 +449,7 @@ uip_sr_free_all(void)
   uip_sr_node_t *next;
   for(l = list_head(nodelist); l != NULL; l = next) {
     next = list_item_next(l);
-    list_remove(nodelist, l);
-    memb_free(&nodememb, l);
-    num_nodes--;
+    remove_node(l);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -85,6 +85,24 @@
 
 #define UIP_SR_INFINITE_LIFETIME           0xFFFFFFFF
 
+/* The number of buckets of the hash table that indexes the nodes by
+ * link identifier. With 0, nodes are looked up by scanning the whole
+ * node list, which gets expensive for large networks. */
+#ifdef UIP_SR_CONF_HASH_SIZE
+#define UIP_SR_HASH_SIZE              UIP_SR_CONF_HASH_SIZE
+#else /* UIP_SR_CONF_HASH_SIZE */
+#define UIP_SR_HASH_SIZE              0
+#endif /* UIP_SR_CONF_HASH_SIZE */
+
+/* Set to 1 to cache, per node, the length of its path to the root.
+ * The cache is invalidated whenever a link of the graph changes, so that
+ * reachability checks do not walk the path for every packet. */
+#ifdef UIP_SR_CONF_PATH_CACHE
+#define UIP_SR_PATH_CACHE             UIP_SR_CONF_PATH_CACHE
+#else /* UIP_SR_CONF_PATH_CACHE */
+#define UIP_SR_PATH_CACHE             0
+#endif /* UIP_SR_CONF_PATH_CACHE */
+
 /********** Data Structures  **********/
 
 /** \brief A node in a source routing graph, stored at the root and representing
@@ -98,6 +116,15 @@ typedef struct uip_sr_node {
   us with the prefix */
   unsigned char link_identifier[8];
   struct uip_sr_node *parent;
+#if UIP_SR_HASH_SIZE
+  /* Next node in the same hash bucket */
+  struct uip_sr_node *hash_next;
+#endif /* UIP_SR_HASH_SIZE */
+#if UIP_SR_PATH_CACHE
+  /* Number of links up to the root, valid if path_version is current */
+  uint16_t path_len;
+  uint16_t path_version;
+#endif /* UIP_SR_PATH_CACHE */
 } uip_sr_node_t;
 
 /********** Public functions **********/
@@ -128,6 +155,21 @@ void uip_sr_expire_parent(void *graph, const uip_ipaddr_t *child, const uip_ipad
 */
 uip_sr_node_t *uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *parent, uint32_t lifetime);
 
+/**
+ * Updates the links of several children to the same parent, looking
+ * up or adding the parent only once
+ *
+ * \param graph The graph the links belong to
+ * \param children The IPv6 addresses of the children
+ * \param count The number of children
+ * \param parent The IPv6 address of the parent
+ * \param lifetime The link lifetime in seconds
+ * \return The number of children updated, less than count if there
+ * was no space left
+*/
+int uip_sr_update_nodes(void *graph, const uip_ipaddr_t *children, int count,
+                        const uip_ipaddr_t *parent, uint32_t lifetime);
+
 /**
  * Returns the head of the non-storing node list
  *
@@ -1756,6 +1756,7 @@ struct uip_udp_hdr {
 #define UIP_PROTO_ICMP  1
 #define UIP_PROTO_TCP   6
 #define UIP_PROTO_UDP   17
+#define UIP_PROTO_IPV6  41
 #define UIP_PROTO_ICMP6 58
 
 
@@ -2099,6 +2100,71 @@ extern uip_lladdr_t uip_lladdr;
  */
 uint16_t uip_chksum(uint16_t *data, uint16_t len);
 
+/**
+ * Add a buffer to a one's complement sum.
+ *
+ * This is the kernel that all Internet checksums in uIP are computed
+ * with. The buffer is summed as a sequence of 16-bit words in network
+ * byte order, with an odd trailing byte padded with a zero byte.
+ *
+ * \param sum The sum to add to, in host byte order.
+ * \param data A pointer to the buffer. It does not need to be aligned.
+ * \param len The length of the buffer.
+ *
+ * \return The one's complement sum in host byte order. It is zero
+ * only if sum and all of the data were zero.
+ */
+uint16_t uip_chksum_add(uint16_t sum, const void *data, uint16_t len);
+
+/**
+ * Subtract a buffer from a one's complement sum.
+ *
+ * \param sum The sum to subtract from, in host byte order.
+ * \param data A pointer to the buffer.
+ * \param len The length of the buffer.
+ *
+ * \return The one's complement sum in host byte order.
+ */
+uint16_t uip_chksum_sub(uint16_t sum, const void *data, uint16_t len);
+
+/**
+ * Update an Internet checksum for a changed 16-bit word.
+ *
+ * This applies equation 3 of RFC 1624, HC' = ~(~HC + ~m + m'), so that
+ * a checksum field can be kept valid without summing the data it
+ * covers again. The checksum and the words are given as they are
+ * stored in the packet; no byte order conversion is needed.
+ *
+ * \param chksum The current value of the checksum field.
+ * \param old_word The old value of the word.
+ * \param new_word The new value of the word.
+ *
+ * \return The new value of the checksum field.
+ */
+uint16_t uip_chksum_update16(uint16_t chksum, uint16_t old_word,
+                             uint16_t new_word);
+
+/**
+ * Update an Internet checksum for changed data.
+ *
+ * Like uip_chksum_update16(), but the data that is removed from and
+ * added to the checksummed data are buffers. They do not need to be
+ * of the same length, which allows e.g. an IPv6 pseudo-header to be
+ * replaced by an IPv4 one. Either buffer may be empty. Both must
+ * start at an even offset in the checksummed data.
+ *
+ * \param chksum The current value of the checksum field.
+ * \param old_data A pointer to the data that is removed.
+ * \param old_len The length of the data that is removed.
+ * \param new_data A pointer to the data that is added.
+ * \param new_len The length of the data that is added.
+ *
+ * \return The new value of the checksum field.
+ */
+uint16_t uip_chksum_update(uint16_t chksum,
+                           const void *old_data, uint16_t old_len,
+                           const void *new_data, uint16_t new_len);
+
 /**
  * Calculate the IP header checksum of the packet header in uip_buf.
  *
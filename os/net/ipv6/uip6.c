@@ -276,17 +276,73 @@ uip_add32(uint8_t *op32, uint16_t op16)
 }
 #endif /* UIP_TCP */
 
-#if ! UIP_ARCH_CHKSUM
+#ifndef UIP_ARCH_CHKSUM_ADD
 /*---------------------------------------------------------------------------*/
-static uint16_t
-chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+#if UIP_CHKSUM_WIDE
+uint16_t
+uip_chksum_add(uint16_t sum, const void *data, uint16_t len)
+{
+  const uint8_t *dataptr;
+  uint64_t acc;
+  uint32_t w0, w1;
+  uint16_t t;
+
+  /*
+   * The one's complement sum does not depend on byte order (RFC 1071),
+   * so the words are added as they are laid out in memory and only
+   * the result is converted back to host byte order.
+   */
+  dataptr = data;
+  acc = uip_htons(sum);
+
+  while(len >= 8) {
+    memcpy(&w0, dataptr, 4);
+    memcpy(&w1, dataptr + 4, 4);
+    acc += w0;
+    acc += w1;
+    dataptr += 8;
+    len -= 8;
+  }
+
+  if(len >= 4) {
+    memcpy(&w0, dataptr, 4);
+    acc += w0;
+    dataptr += 4;
+    len -= 4;
+  }
+
+  if(len >= 2) {
+    memcpy(&t, dataptr, 2);
+    acc += t;
+    dataptr += 2;
+    len -= 2;
+  }
+
+  if(len) {
+    t = 0;
+    memcpy(&t, dataptr, 1);
+    acc += t;
+  }
+
+  /* Fold the carries back in. */
+  acc = (acc >> 32) + (acc & 0xffffffff);
+  while(acc >> 16) {
+    acc = (acc >> 16) + (acc & 0xffff);
+  }
+
+  /* Return sum in host byte order. */
+  return uip_ntohs((uint16_t)acc);
+}
+#else /* UIP_CHKSUM_WIDE */
+uint16_t
+uip_chksum_add(uint16_t sum, const void *data, uint16_t len)
 {
   uint16_t t;
   const uint8_t *dataptr;
   const uint8_t *last_byte;
 
   dataptr = data;
-  last_byte = data + len - 1;
+  last_byte = dataptr + len - 1;
 
   while(dataptr < last_byte) {   /* At least two more bytes */
     t = (dataptr[0] << 8) + dataptr[1];
@@ -308,11 +364,56 @@ chksum(uint16_t sum, const uint8_t *data, uint16_t len)
   /* Return sum in host byte order. */
   return sum;
 }
+#endif /* UIP_CHKSUM_WIDE */
+#endif /* UIP_ARCH_CHKSUM_ADD */
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_sub(uint16_t sum, const void *data, uint16_t len)
+{
+  uint16_t t;
+
+  /* Adding the one's complement of the sum of the data subtracts it. */
+  t = ~uip_chksum_add(0, data, len);
+  sum += t;
+  if(sum < t) {
+    sum++;      /* carry */
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_update16(uint16_t chksum, uint16_t old_word, uint16_t new_word)
+{
+  uint32_t sum;
+
+  /* RFC 1624, equation 3: HC' = ~(~HC + ~m + m') */
+  sum = (uint16_t)~chksum;
+  sum += (uint16_t)~old_word;
+  sum += new_word;
+  sum = (sum >> 16) + (sum & 0xffff);
+  sum += sum >> 16;
+  return (uint16_t)~sum;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_update(uint16_t chksum,
+                  const void *old_data, uint16_t old_len,
+                  const void *new_data, uint16_t new_len)
+{
+  uint16_t sum;
+
+  sum = ~uip_ntohs(chksum);
+  sum = uip_chksum_sub(sum, old_data, old_len);
+  sum = uip_chksum_add(sum, new_data, new_len);
+  return uip_htons((uint16_t)~sum);
+}
+/*---------------------------------------------------------------------------*/
+#if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
 uint16_t
 uip_chksum(uint16_t *data, uint16_t len)
 {
-  return uip_htons(chksum(0, (uint8_t *)data, len));
+  return uip_htons(uip_chksum_add(0, data, len));
 }
 /*---------------------------------------------------------------------------*/
 #ifndef UIP_ARCH_IPCHKSUM
@@ -321,7 +422,7 @@ uip_ipchksum(void)
 {
   uint16_t sum;
 
-  sum = chksum(0, uip_buf, UIP_IPH_LEN);
+  sum = uip_chksum_add(0, uip_buf, UIP_IPH_LEN);
   LOG_DBG("uip_ipchksum: sum 0x%04x\n", sum);
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
@@ -351,10 +452,10 @@ upper_layer_chksum(uint8_t proto)
   /* IP protocol and length fields. This addition cannot carry. */
   sum = upper_layer_len + proto;
   /* Sum IP source and destination addresses. */
-  sum = chksum(sum, (uint8_t *)&UIP_IP_BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
+  sum = uip_chksum_add(sum, &UIP_IP_BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
 
   /* Sum upper-layer header and data. */
-  sum = chksum(sum, UIP_IP_PAYLOAD(uip_ext_len), upper_layer_len);
+  sum = uip_chksum_add(sum, UIP_IP_PAYLOAD(uip_ext_len), upper_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
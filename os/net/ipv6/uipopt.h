@@ -587,6 +587,27 @@ void uip_log(char *msg);
 #define UIP_BYTE_ORDER     (UIP_LITTLE_ENDIAN)
 #endif /* UIP_CONF_BYTE_ORDER */
 
+/**
+ * Selects the generic Internet checksum kernel used by
+ * uip_chksum_add(). When set, the data is summed 32 bits at a time
+ * into a 64-bit accumulator that is folded to 16 bits once at the
+ * end. When not set, it is summed 16 bits at a time with an
+ * end-around carry after each addition, which suits 8 and 16-bit
+ * CPUs better. The default depends on the width of an int.
+ *
+ * A platform that has a faster kernel of its own defines
+ * UIP_ARCH_CHKSUM_ADD and provides uip_chksum_add() instead.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_CHKSUM_WIDE
+#define UIP_CHKSUM_WIDE    (UIP_CONF_CHKSUM_WIDE)
+#elif defined(__SIZEOF_INT__) && __SIZEOF_INT__ >= 4
+#define UIP_CHKSUM_WIDE    1
+#else
+#define UIP_CHKSUM_WIDE    0
+#endif /* UIP_CONF_CHKSUM_WIDE */
+
 /** @} */
 /*------------------------------------------------------------------------------*/
 
@@ -40,6 +40,7 @@
  */
 
 #include "net/mac/csma/csma.h"
+#include "net/mac/csma/csma-output.h"
 #include "net/mac/csma/csma-security.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
@@ -101,6 +102,10 @@ struct neighbor_queue {
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions;
+#if CSMA_WITH_PRIORITY
+  /* Bytes of data frames the neighbor may still send in its turn */
+  int16_t deficit;
+#endif /* CSMA_WITH_PRIORITY */
   LIST_STRUCT(packet_queue);
 };
 
@@ -120,11 +125,18 @@ struct neighbor_queue {
 
 #define MAX_QUEUED_PACKETS QUEUEBUF_NUM
 
+#if CSMA_WITH_PRIORITY && CSMA_CONTROL_RESERVE >= CSMA_MAX_PACKET_PER_NEIGHBOR
+#error CSMA_CONF_CONTROL_RESERVE leaves no room for data frames
+#endif
+
 /* Neighbor packet queue */
 struct packet_queue {
   struct packet_queue *next;
   struct queuebuf *buf;
   void *ptr;
+#if CSMA_WITH_PRIORITY
+  uint8_t priority;
+#endif /* CSMA_WITH_PRIORITY */
 };
 
 MEMB(neighbor_memb, struct neighbor_queue, CSMA_MAX_NEIGHBOR_QUEUES);
@@ -132,6 +144,20 @@ MEMB(packet_memb, struct packet_queue, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
 LIST(neighbor_list);
 
+#if CSMA_BURST
+static struct csma_burst_stats burst_stats;
+#endif /* CSMA_BURST */
+
+#if CSMA_WITH_PRIORITY
+/* With priority queueing, the neighbor queues are served one at a
+   time: the active neighbor keeps the radio until its head packet is
+   done, then the scheduler picks the next one. */
+static struct neighbor_queue *active;
+/* The neighbor whose round-robin turn it is for data frames */
+static struct neighbor_queue *drr_current;
+static struct csma_priority_stats priority_stats;
+#endif /* CSMA_WITH_PRIORITY */
+
 static void packet_sent(struct neighbor_queue *n,
     struct packet_queue *q,
     int status,
@@ -253,6 +279,96 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
   return last_sent_ok;
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_BURST
+#if CSMA_WITH_PRIORITY
+/* Tells whether the scheduler will give the next turn to n again once
+   its head packet is sent, with next as its new head packet. Errs on
+   the side of no, as the frame pending bit must not be set in vain. */
+static int
+keeps_turn(struct neighbor_queue *n, struct packet_queue *next)
+{
+  struct neighbor_queue *m;
+  struct packet_queue *head;
+
+  /* Control packets go first, in neighbor list order */
+  for(m = list_head(neighbor_list); m != NULL; m = list_item_next(m)) {
+    head = m == n ? next : list_head(m->packet_queue);
+    if(head->priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+      return m == n;
+    }
+  }
+  /* Then data packets, while the deficit of n lasts */
+  return n == drr_current && queuebuf_datalen(next->buf) <= n->deficit;
+}
+#endif /* CSMA_WITH_PRIORITY */
+/*---------------------------------------------------------------------------*/
+/* Sends the packet at the head of the queue of n, which must already
+   be in packetbuf, followed by as many of the next packets in the queue
+   as possible. The backoff is only done before the first one: as long
+   as frames are acknowledged, the next one is sent right away, with the
+   frame pending bit telling the receiver that more is coming. */
+static void
+transmit_burst(struct neighbor_queue *n, struct packet_queue *q)
+{
+  uint8_t len = 0;
+  int more;
+
+  while(1) {
+    len++;
+    /* All frames of a queue go to the same neighbor. Broadcasts are
+       not acknowledged, so they are never sent in bursts. */
+    more = list_item_next(q) != NULL && len < CSMA_BURST_MAX_LEN
+      && !linkaddr_cmp(&n->addr, &linkaddr_null);
+#if CSMA_WITH_PRIORITY
+    /* Nor past the turn of n: the frame would tell the receiver to
+       wait for a frame that does not come */
+    more = more && keeps_turn(n, list_item_next(q));
+#endif /* CSMA_WITH_PRIORITY */
+    packetbuf_set_attr(PACKETBUF_ATTR_PENDING, more);
+
+    if(!send_one_packet(n, q) || !more) {
+      /* On failure, the packet was rescheduled with a backoff */
+      break;
+    }
+#if CSMA_WITH_PRIORITY
+    if(active != n) {
+      /* The scheduler gave the next turn to another neighbor */
+      break;
+    }
+#endif /* CSMA_WITH_PRIORITY */
+
+    /* The queue still holds the next packet, so n was not freed. Cancel
+       the backoff that was scheduled for it and send it now instead. */
+    q = list_head(n->packet_queue);
+    if(!ctimer_expired(&n->transmit_timer)) {
+      burst_stats.backoff_saved +=
+        etimer_expiration_time(&n->transmit_timer.etimer) - clock_time();
+    }
+    ctimer_stop(&n->transmit_timer);
+
+    LOG_DBG("burst to ");
+    LOG_DBG_LLADDR(&n->addr);
+    LOG_DBG_(", frame %u, seqno %u\n", len + 1,
+             queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO));
+    queuebuf_to_packetbuf(q->buf);
+  }
+
+  if(len > 1) {
+    burst_stats.bursts++;
+    burst_stats.frames += len;
+    if(len > burst_stats.max_len) {
+      burst_stats.max_len = len;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct csma_burst_stats *
+csma_output_burst_stats(void)
+{
+  return &burst_stats;
+}
+#endif /* CSMA_BURST */
+/*---------------------------------------------------------------------------*/
 static void
 transmit_from_queue(void *ptr)
 {
@@ -267,7 +383,11 @@ transmit_from_queue(void *ptr)
         n->transmissions, list_length(n->packet_queue));
       /* Send first packet in the neighbor queue */
       queuebuf_to_packetbuf(q->buf);
+#if CSMA_BURST
+      transmit_burst(n, q);
+#else /* CSMA_BURST */
       send_one_packet(n, q);
+#endif /* CSMA_BURST */
     }
   }
 }
@@ -292,6 +412,120 @@ schedule_transmission(struct neighbor_queue *n)
   ctimer_set(&n->transmit_timer, delay, transmit_from_queue, n);
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_WITH_PRIORITY
+static struct packet_queue *
+head_packet(struct neighbor_queue *n)
+{
+  return list_head(n->packet_queue);
+}
+/*---------------------------------------------------------------------------*/
+/* Picks the neighbor queue to serve next, and schedules its head
+   packet. Control packets go first, in neighbor list order. Data
+   packets are then sent with deficit round-robin between neighbors, so
+   that each one gets a fair share of the airtime whatever the size and
+   number of packets it has queued. */
+static void
+schedule_next(void)
+{
+  struct neighbor_queue *n;
+  int len;
+
+  active = NULL;
+
+  for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+    if(head_packet(n)->priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+      break;
+    }
+  }
+
+  if(n == NULL) {
+    n = drr_current;
+    if(n == NULL) {
+      n = list_head(neighbor_list);
+      if(n == NULL) {
+        /* Nothing left to send */
+        return;
+      }
+      n->deficit += CSMA_DRR_QUANTUM;
+    }
+    /* A quantum is at least one byte, so this ends within a few rounds */
+    while((len = queuebuf_datalen(head_packet(n)->buf)) > n->deficit) {
+      n = list_item_next(n);
+      if(n == NULL) {
+        n = list_head(neighbor_list);
+      }
+      n->deficit += CSMA_DRR_QUANTUM;
+    }
+    n->deficit -= len;
+    drr_current = n;
+  }
+
+  active = n;
+  schedule_transmission(n);
+}
+/*---------------------------------------------------------------------------*/
+/* Called when the active neighbor n is about to send, or send again, its
+   head packet. If that is a data packet and another neighbor has a
+   control packet at the head of its queue, the control packet takes the
+   radio instead, so that it does not wait behind the retransmissions of
+   a failing link. Returns 1 if n lost the radio. */
+static int
+preempt_for_control(struct neighbor_queue *n)
+{
+  struct neighbor_queue *m;
+  struct packet_queue *head = head_packet(n);
+
+  if(head->priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    return 0;
+  }
+  for(m = list_head(neighbor_list); m != NULL; m = list_item_next(m)) {
+    if(m != n && head_packet(m)->priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+      break;
+    }
+  }
+  if(m == NULL) {
+    return 0;
+  }
+
+  ctimer_stop(&n->transmit_timer);
+  if(n->transmissions == 0 && n->collisions == 0) {
+    /* Not sent yet: give back what its turn was charged. Attempts
+       already made count against the share of n. */
+    n->deficit += queuebuf_datalen(head->buf);
+  }
+  LOG_DBG("control packet for ");
+  LOG_DBG_LLADDR(&m->addr);
+  LOG_DBG_(" preempts ");
+  LOG_DBG_LLADDR(&n->addr);
+  LOG_DBG_("\n");
+
+  active = m;
+  schedule_transmission(m);
+  return 1;
+}
+#endif /* CSMA_WITH_PRIORITY */
+/*---------------------------------------------------------------------------*/
+static void
+free_neighbor(struct neighbor_queue *n)
+{
+#if CSMA_WITH_PRIORITY
+  if(n == drr_current) {
+    /* The turn goes to the next neighbor, if any, else back to the
+       head of the list */
+    drr_current = list_item_next(n);
+    if(drr_current != NULL) {
+      drr_current->deficit += CSMA_DRR_QUANTUM;
+    }
+  }
+  if(n == active) {
+    active = NULL;
+  }
+#endif /* CSMA_WITH_PRIORITY */
+  ctimer_stop(&n->transmit_timer);
+  list_remove(neighbor_list, n);
+  memb_free(&neighbor_memb, n);
+}
+/*---------------------------------------------------------------------------*/
 static void
 free_packet(struct neighbor_queue *n, struct packet_queue *p, int status)
 {
@@ -308,14 +542,18 @@ free_packet(struct neighbor_queue *n, struct packet_queue *p, int status)
       /* There is a next packet. We reset current tx information */
       n->transmissions = 0;
       n->collisions = 0;
+#if !CSMA_WITH_PRIORITY
       /* Schedule next transmissions */
       schedule_transmission(n);
+#endif /* !CSMA_WITH_PRIORITY */
     } else {
       /* This was the last packet in the queue, we free the neighbor */
-      ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
+      free_neighbor(n);
     }
+#if CSMA_WITH_PRIORITY
+    /* The next packet may be for any neighbor */
+    schedule_next();
+#endif /* CSMA_WITH_PRIORITY */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -345,10 +583,17 @@ tx_done(int status, struct packet_queue *q, struct neighbor_queue *n)
 static void
 rexmit(struct packet_queue *q, struct neighbor_queue *n)
 {
-  schedule_transmission(n);
   /* This is needed to correctly attribute energy that we spent
      transmitting this packet. */
   queuebuf_update_attr_from_packetbuf(q->buf);
+#if CSMA_WITH_PRIORITY
+  /* Let pending control packets go before the next attempt. n resumes
+     its retransmissions when the scheduler gives it the radio back. */
+  if(preempt_for_control(n)) {
+    return;
+  }
+#endif /* CSMA_WITH_PRIORITY */
+  schedule_transmission(n);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -437,6 +682,56 @@ packet_sent(struct neighbor_queue *n,
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Tells whether the packet in packetbuf may be added to a neighbor queue */
+static int
+queue_has_room(struct neighbor_queue *n)
+{
+#if CSMA_WITH_PRIORITY
+  if(packetbuf_attr(PACKETBUF_ATTR_PRIORITY) != PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    /* Data frames leave some room in the queues for control frames */
+    return list_length(n->packet_queue) < CSMA_MAX_PACKET_PER_NEIGHBOR - CSMA_CONTROL_RESERVE
+      && memb_numfree(&packet_memb) > CSMA_CONTROL_RESERVE;
+  }
+#endif /* CSMA_WITH_PRIORITY */
+  return list_length(n->packet_queue) < CSMA_MAX_PACKET_PER_NEIGHBOR;
+}
+/*---------------------------------------------------------------------------*/
+#if CSMA_WITH_PRIORITY
+/* Adds a packet to a neighbor queue, behind the control packets but
+   ahead of the data packets if it is a control packet. The head packet
+   of the active neighbor is never overtaken, nor one that was already
+   sent and lost the radio to a control packet, as its retransmissions
+   are not done. */
+static void
+enqueue(struct neighbor_queue *n, struct packet_queue *q)
+{
+  struct packet_queue *prev = NULL;
+  struct packet_queue *p;
+
+  if(q->priority != PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    list_add(n->packet_queue, q);
+    return;
+  }
+
+  p = list_head(n->packet_queue);
+  if(p != NULL && (n == active || n->transmissions > 0 || n->collisions > 0)) {
+    prev = p;
+    p = list_item_next(p);
+  }
+  while(p != NULL && p->priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    prev = p;
+    p = list_item_next(p);
+  }
+  list_insert(n->packet_queue, prev, q);
+}
+/*---------------------------------------------------------------------------*/
+const struct csma_priority_stats *
+csma_output_priority_stats(void)
+{
+  return &priority_stats;
+}
+#endif /* CSMA_WITH_PRIORITY */
+/*---------------------------------------------------------------------------*/
 void
 csma_output_packet(mac_callback_t sent, void *ptr)
 {
@@ -445,6 +740,9 @@ csma_output_packet(mac_callback_t sent, void *ptr)
   static uint8_t initialized = 0;
   static uint8_t seqno;
   const linkaddr_t *addr = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+#if CSMA_WITH_PRIORITY
+  uint8_t priority = packetbuf_attr(PACKETBUF_ATTR_PRIORITY);
+#endif /* CSMA_WITH_PRIORITY */
 
   if(!initialized) {
     initialized = 1;
@@ -470,6 +768,9 @@ csma_output_packet(mac_callback_t sent, void *ptr)
       linkaddr_copy(&n->addr, addr);
       n->transmissions = 0;
       n->collisions = 0;
+#if CSMA_WITH_PRIORITY
+      n->deficit = 0;
+#endif /* CSMA_WITH_PRIORITY */
       /* Init packet queue for this neighbor */
       LIST_STRUCT_INIT(n, packet_queue);
       /* Add neighbor to the neighbor list */
@@ -479,7 +780,7 @@ csma_output_packet(mac_callback_t sent, void *ptr)
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
-    if(list_length(n->packet_queue) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    if(queue_has_room(n)) {
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -495,7 +796,12 @@ csma_output_packet(mac_callback_t sent, void *ptr)
             }
             metadata->sent = sent;
             metadata->cptr = ptr;
+#if CSMA_WITH_PRIORITY
+            q->priority = priority;
+            enqueue(n, q);
+#else /* CSMA_WITH_PRIORITY */
             list_add(n->packet_queue, q);
+#endif /* CSMA_WITH_PRIORITY */
 
             LOG_INFO("sending to ");
             LOG_INFO_LLADDR(addr);
@@ -503,10 +809,18 @@ csma_output_packet(mac_callback_t sent, void *ptr)
                     packetbuf_datalen(),
                     packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO),
                     list_length(n->packet_queue), memb_numfree(&packet_memb));
+#if CSMA_WITH_PRIORITY
+            if(active == NULL) {
+              schedule_next();
+            } else if(priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+              preempt_for_control(active);
+            }
+#else /* CSMA_WITH_PRIORITY */
             /* If q is the first packet in the neighbor's queue, send asap */
             if(list_head(n->packet_queue) == q) {
               schedule_transmission(n);
             }
+#endif /* CSMA_WITH_PRIORITY */
             return;
           }
           memb_free(&metadata_memb, q->ptr);
@@ -515,21 +829,34 @@ csma_output_packet(mac_callback_t sent, void *ptr)
         memb_free(&packet_memb, q);
         LOG_WARN("could not allocate queuebuf, dropping packet\n");
       }
-      /* The packet allocation failed. Remove and free neighbor entry if empty. */
-      if(list_length(n->packet_queue) == 0) {
-        list_remove(neighbor_list, n);
-        memb_free(&neighbor_memb, n);
-      }
     } else {
       LOG_WARN("Neighbor queue full\n");
     }
+    /* The packet was not queued. Remove and free neighbor entry if empty. */
+    if(list_length(n->packet_queue) == 0) {
+      free_neighbor(n);
+    }
     LOG_WARN("could not allocate packet, dropping packet\n");
   } else {
     LOG_WARN("could not allocate neighbor, dropping packet\n");
   }
+#if CSMA_WITH_PRIORITY
+  if(priority == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    priority_stats.control_drops++;
+  } else {
+    priority_stats.data_drops++;
+  }
+#endif /* CSMA_WITH_PRIORITY */
   mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
 }
 /*---------------------------------------------------------------------------*/
+uint8_t
+csma_output_queue_occupancy(void)
+{
+  return (MAX_QUEUED_PACKETS - memb_numfree(&packet_memb)) * 100
+    / MAX_QUEUED_PACKETS;
+}
+/*---------------------------------------------------------------------------*/
 void
 csma_output_init(void)
 {
@@ -45,6 +45,41 @@
 #include "contiki.h"
 #include "net/mac/mac.h"
 
+#include "net/mac/csma/csma.h"
+
+#if CSMA_BURST
+/* Burst mode statistics */
+struct csma_burst_stats {
+  /* Number of bursts, i.e. of transmissions that were followed by at
+     least one more frame without a backoff */
+  uint32_t bursts;
+  /* Number of frames sent as part of a burst, first frame included */
+  uint32_t frames;
+  /* Number of clock ticks of backoff that were skipped */
+  uint32_t backoff_saved;
+  /* Longest burst sent */
+  uint8_t max_len;
+};
+
+const struct csma_burst_stats *csma_output_burst_stats(void);
+#endif /* CSMA_BURST */
+
+#if CSMA_WITH_PRIORITY
+/* Priority queueing statistics */
+struct csma_priority_stats {
+  /* Control frames dropped because the queues were full */
+  uint32_t control_drops;
+  /* Data frames dropped because the queues were full, counting the
+     entries kept for control frames as full */
+  uint32_t data_drops;
+};
+
+const struct csma_priority_stats *csma_output_priority_stats(void);
+#endif /* CSMA_WITH_PRIORITY */
+
+/* Share of the packet queue in use, in percent */
+uint8_t csma_output_queue_occupancy(void);
+
 void csma_output_packet(mac_callback_t sent, void *ptr);
 void csma_output_init(void);
 
@@ -65,6 +65,46 @@
 
 #define CSMA_ACK_LEN 3
 
+/* Burst mode: when several unicast frames are queued for the same
+   neighbor, send them back-to-back after a single backoff, with the
+   frame pending bit set on all but the last one */
+#ifdef CSMA_CONF_BURST
+#define CSMA_BURST CSMA_CONF_BURST
+#else /* CSMA_CONF_BURST */
+#define CSMA_BURST 0
+#endif /* CSMA_CONF_BURST */
+
+/* The maximum number of frames sent in one burst */
+#ifdef CSMA_CONF_BURST_MAX_LEN
+#define CSMA_BURST_MAX_LEN CSMA_CONF_BURST_MAX_LEN
+#else /* CSMA_CONF_BURST_MAX_LEN */
+#define CSMA_BURST_MAX_LEN 8
+#endif /* CSMA_CONF_BURST_MAX_LEN */
+
+/* Priority queueing: frames tagged PACKETBUF_ATTR_PRIORITY_CONTROL
+   are sent before any data frame, and the neighbors take turns for
+   data frames, with deficit round-robin */
+#ifdef CSMA_CONF_WITH_PRIORITY
+#define CSMA_WITH_PRIORITY CSMA_CONF_WITH_PRIORITY
+#else /* CSMA_CONF_WITH_PRIORITY */
+#define CSMA_WITH_PRIORITY 0
+#endif /* CSMA_CONF_WITH_PRIORITY */
+
+/* Number of queue entries that data frames may not use, so that
+   control frames can still be queued under congestion */
+#ifdef CSMA_CONF_CONTROL_RESERVE
+#define CSMA_CONTROL_RESERVE CSMA_CONF_CONTROL_RESERVE
+#else /* CSMA_CONF_CONTROL_RESERVE */
+#define CSMA_CONTROL_RESERVE 2
+#endif /* CSMA_CONF_CONTROL_RESERVE */
+
+/* Bytes of data frames a neighbor may send per round-robin turn */
+#ifdef CSMA_CONF_DRR_QUANTUM
+#define CSMA_DRR_QUANTUM CSMA_CONF_DRR_QUANTUM
+#else /* CSMA_CONF_DRR_QUANTUM */
+#define CSMA_DRR_QUANTUM 128
+#endif /* CSMA_CONF_DRR_QUANTUM */
+
 /* Default MAC len for 802.15.4 classic */
 #ifdef  CSMA_MAC_CONF_LEN
 #define CSMA_MAC_LEN CSMA_MAC_CONF_LEN
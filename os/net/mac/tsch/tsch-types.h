@@ -89,8 +89,13 @@ struct tsch_slotframe {
   /* Number of timeslots in the slotframe.
    * Stored as struct asn_divisor_t because we often need ASN%size */
   struct tsch_asn_divisor_t size;
-  /* List of links belonging to this slotframe */
+  /* List of links belonging to this slotframe, sorted by timeslot */
   LIST_STRUCT(links_list);
+  /* Lookup cursor: first link with a timeslot strictly after
+   * cursor_timeslot (NULL if none). Only valid if cursor_valid is set */
+  struct tsch_link *cursor;
+  uint16_t cursor_timeslot;
+  uint8_t cursor_valid;
 };
 
 /** \brief TSCH packet information */
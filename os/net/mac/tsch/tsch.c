@@ -808,6 +808,8 @@ PROCESS_THREAD(tsch_process, ev, data)
 
   PROCESS_BEGIN();
 
+  process_set_priority(PROCESS_CURRENT(), PROCESS_PRIORITY_HIGH);
+
   while(1) {
 
     while(!tsch_is_associated) {
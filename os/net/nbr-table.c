@@ -83,6 +83,42 @@ static unsigned num_tables;
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
 
+#if NBR_TABLE_WITH_HASH
+/* Hash index over nbr_table_keys. Each slot holds a neighbor index + 1,
+ * 0 meaning empty. The table is at least twice as large as the number of
+ * neighbors, so probing always terminates on an empty slot. */
+#ifdef NBR_TABLE_CONF_HASH_BITS
+#define NBR_TABLE_HASH_BITS NBR_TABLE_CONF_HASH_BITS
+#elif NBR_TABLE_MAX_NEIGHBORS <= 8
+#define NBR_TABLE_HASH_BITS 4
+#elif NBR_TABLE_MAX_NEIGHBORS <= 16
+#define NBR_TABLE_HASH_BITS 5
+#elif NBR_TABLE_MAX_NEIGHBORS <= 32
+#define NBR_TABLE_HASH_BITS 6
+#elif NBR_TABLE_MAX_NEIGHBORS <= 64
+#define NBR_TABLE_HASH_BITS 7
+#elif NBR_TABLE_MAX_NEIGHBORS <= 128
+#define NBR_TABLE_HASH_BITS 8
+#elif NBR_TABLE_MAX_NEIGHBORS <= 256
+#define NBR_TABLE_HASH_BITS 9
+#else
+#define NBR_TABLE_HASH_BITS 10
+#endif
+#define NBR_TABLE_HASH_SIZE (1 << NBR_TABLE_HASH_BITS)
+
+#if NBR_TABLE_HASH_SIZE < NBR_TABLE_MAX_NEIGHBORS + 1
+#error "NBR_TABLE_HASH_BITS too small for NBR_TABLE_MAX_NEIGHBORS"
+#endif
+
+#if NBR_TABLE_MAX_NEIGHBORS < 255
+typedef uint8_t nbr_table_hash_slot_t;
+#else
+typedef uint16_t nbr_table_hash_slot_t;
+#endif
+
+static nbr_table_hash_slot_t hash_slots[NBR_TABLE_HASH_SIZE];
+#endif /* NBR_TABLE_WITH_HASH */
+
 /*---------------------------------------------------------------------------*/
 /* Get a key from a neighbor index */
 static nbr_table_key_t *
@@ -125,6 +161,64 @@ key_from_item(nbr_table_t *table, const nbr_table_item_t *item)
 {
   return key_from_index(index_from_item(table, item));
 }
+#if NBR_TABLE_WITH_HASH
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_from_lladdr(const linkaddr_t *lladdr)
+{
+  uint32_t hash = 0;
+  int i;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    hash = hash * 31 + lladdr->u8[i];
+  }
+  /* Fibonacci hashing spreads consecutive addresses over the table */
+  hash *= 2654435761UL;
+  return hash >> (32 - NBR_TABLE_HASH_BITS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_insert(nbr_table_key_t *key)
+{
+  unsigned i = hash_from_lladdr(&key->lladdr);
+  while(hash_slots[i] != 0) {
+    i = (i + 1) & (NBR_TABLE_HASH_SIZE - 1);
+  }
+  hash_slots[i] = index_from_key(key) + 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(nbr_table_key_t *key)
+{
+  unsigned i, j, home;
+  nbr_table_hash_slot_t slot = index_from_key(key) + 1;
+
+  i = hash_from_lladdr(&key->lladdr);
+  while(hash_slots[i] != slot) {
+    if(hash_slots[i] == 0) {
+      /* Not indexed */
+      return;
+    }
+    i = (i + 1) & (NBR_TABLE_HASH_SIZE - 1);
+  }
+
+  /* Backward-shift deletion: move up any later entry of the probe
+   * sequence that would no longer be reachable through the hole at i */
+  j = i;
+  while(1) {
+    j = (j + 1) & (NBR_TABLE_HASH_SIZE - 1);
+    if(hash_slots[j] == 0) {
+      break;
+    }
+    home = hash_from_lladdr(&key_from_index(hash_slots[j] - 1)->lladdr);
+    if((j > i && (home <= i || home > j)) ||
+       (j < i && (home <= i && home > j))) {
+      hash_slots[i] = hash_slots[j];
+      i = j;
+    }
+  }
+  hash_slots[i] = 0;
+}
+#endif /* NBR_TABLE_WITH_HASH */
 /*---------------------------------------------------------------------------*/
 /* Get the index of a neighbor from its link-layer address */
 static int
@@ -136,6 +230,19 @@ index_from_lladdr(const linkaddr_t *lladdr)
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
+#if NBR_TABLE_WITH_HASH
+  {
+    unsigned i = hash_from_lladdr(lladdr);
+    while(hash_slots[i] != 0) {
+      key = key_from_index(hash_slots[i] - 1);
+      if(linkaddr_cmp(lladdr, &key->lladdr)) {
+        return hash_slots[i] - 1;
+      }
+      i = (i + 1) & (NBR_TABLE_HASH_SIZE - 1);
+    }
+  }
+  return -1;
+#else /* NBR_TABLE_WITH_HASH */
   key = list_head(nbr_table_keys);
   while(key != NULL) {
     if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
@@ -144,6 +251,7 @@ index_from_lladdr(const linkaddr_t *lladdr)
     key = list_item_next(key);
   }
   return -1;
+#endif /* NBR_TABLE_WITH_HASH */
 }
 /*---------------------------------------------------------------------------*/
 /* Get bit from "used" or "locked" bitmap */
@@ -195,6 +303,9 @@ remove_key(nbr_table_key_t *least_used_key)
   used_map[index_from_key(least_used_key)] = 0;
   /* Remove neighbor from list */
   list_remove(nbr_table_keys, least_used_key);
+#if NBR_TABLE_WITH_HASH
+  hash_remove(least_used_key);
+#endif /* NBR_TABLE_WITH_HASH */
 }
 /*---------------------------------------------------------------------------*/
 static nbr_table_key_t *
@@ -377,6 +488,9 @@ nbr_table_add_lladdr(nbr_table_t *table, const linkaddr_t *lladdr, nbr_table_rea
 
     /* Set link-layer address */
     linkaddr_copy(&key->lladdr, lladdr);
+#if NBR_TABLE_WITH_HASH
+    hash_insert(key);
+#endif /* NBR_TABLE_WITH_HASH */
   }
 
   /* Get item in the current table */
@@ -46,6 +46,15 @@
 #define NBR_TABLE_MAX_NEIGHBORS 8
 #endif /* NBR_TABLE_CONF_MAX_NEIGHBORS */
 
+/* Set non-zero (1) to index neighbor keys with an open-addressing hash
+ * table, making nbr_table_get_from_lladdr() O(1) on average instead of
+ * a walk through all neighbors */
+#ifdef NBR_TABLE_CONF_WITH_HASH
+#define NBR_TABLE_WITH_HASH NBR_TABLE_CONF_WITH_HASH
+#else /* NBR_TABLE_CONF_WITH_HASH */
+#define NBR_TABLE_WITH_HASH 0
+#endif /* NBR_TABLE_CONF_WITH_HASH */
+
 /* An item in a neighbor table */
 typedef void nbr_table_item_t;
 
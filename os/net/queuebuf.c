@@ -71,6 +71,61 @@ struct queuebuf {
 #endif
 };
 
+#if QUEUEBUF_ARENA_SIZE
+
+/* In variable-size mode, the queuebuf data is a header followed by the
+   values and the types of the nattrs non-zero attributes, and then by
+   the len bytes of the frame */
+struct queuebuf_data {
+  uint16_t len;
+  uint8_t nattrs;
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+
+#define QBUF_ATTR_VALS(d) ((packetbuf_attr_t *)((d) + 1))
+#define QBUF_ATTR_TYPES(d) ((uint8_t *)(QBUF_ATTR_VALS(d) + (d)->nattrs))
+#define QBUF_DATA(d) (QBUF_ATTR_TYPES(d) + (d)->nattrs)
+#define QBUF_SIZE(nattrs, len) (sizeof(struct queuebuf_data) + \
+                                (nattrs) * (sizeof(packetbuf_attr_t) + 1) + (len))
+
+/* The arena is made of ARENA_BLOCKS smallest blocks. A block of order k
+   spans 2^k smallest blocks and is aligned on its size, so that its
+   buddy is found by flipping bit k of its index. */
+#define ARENA_BLOCKS (QUEUEBUF_ARENA_SIZE / QUEUEBUF_ARENA_BLOCK_SIZE)
+#define ARENA_ORDERS 8
+#define ARENA_NONE 0xffff
+#define ARENA_FREE 0x80
+
+#if QUEUEBUF_ARENA_BLOCK_SIZE < 4 || QUEUEBUF_ARENA_BLOCK_SIZE % 4
+#error "QUEUEBUF_CONF_ARENA_BLOCK_SIZE must be a non-zero multiple of 4"
+#endif
+#if ARENA_BLOCKS == 0 || ARENA_BLOCKS >= ARENA_NONE
+#error "QUEUEBUF_CONF_ARENA_SIZE must hold between 1 and 65534 blocks"
+#endif
+#if (QUEUEBUF_ARENA_BLOCK_SIZE << (ARENA_ORDERS - 1)) < PACKETBUF_SIZE
+#error "QUEUEBUF_CONF_ARENA_BLOCK_SIZE is too small for PACKETBUF_SIZE"
+#endif
+
+/* Free blocks are kept in one doubly-linked list per order. The links
+   are block indices stored at the start of the free block itself. */
+struct arena_free_block {
+  uint16_t next;
+  uint16_t prev;
+};
+
+static uint32_t arena_aligned[(QUEUEBUF_ARENA_SIZE + 3) / 4];
+#define arena ((uint8_t *)arena_aligned)
+#define ARENA_BLOCK(i) ((struct arena_free_block *) \
+                        (arena + (i) * QUEUEBUF_ARENA_BLOCK_SIZE))
+#define ARENA_INDEX(p) (((uint8_t *)(p) - arena) / QUEUEBUF_ARENA_BLOCK_SIZE)
+
+/* For the first smallest block of every block: its order, with
+   ARENA_FREE set if the block is free. Other entries are zero. */
+static uint8_t arena_order[ARENA_BLOCKS];
+static uint16_t arena_free_list[ARENA_ORDERS];
+
+#else /* QUEUEBUF_ARENA_SIZE */
+
 /* The actual queuebuf data */
 struct queuebuf_data {
   uint8_t data[PACKETBUF_SIZE];
@@ -79,9 +134,12 @@ struct queuebuf_data {
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
 };
 
-MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
 MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
 
+#endif /* QUEUEBUF_ARENA_SIZE */
+
+MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
+
 #if WITH_SWAP
 
 /* Swapping allows to store up to QUEUEBUF_NUM - QUEUEBUFRAM_NUM
@@ -133,8 +191,205 @@ LIST(queuebuf_list);
 
 #if QUEUEBUF_STATS
 uint8_t queuebuf_len, queuebuf_max_len;
+#if QUEUEBUF_ARENA_SIZE
+/* Bytes of the arena in allocated blocks */
+uint16_t queuebuf_arena_used, queuebuf_arena_max_used;
+#endif /* QUEUEBUF_ARENA_SIZE */
 #endif /* QUEUEBUF_STATS */
 
+#if QUEUEBUF_ARENA_SIZE
+/*---------------------------------------------------------------------------*/
+static void
+arena_push(uint16_t index, uint8_t order)
+{
+  struct arena_free_block *block = ARENA_BLOCK(index);
+
+  block->prev = ARENA_NONE;
+  block->next = arena_free_list[order];
+  if(block->next != ARENA_NONE) {
+    ARENA_BLOCK(block->next)->prev = index;
+  }
+  arena_free_list[order] = index;
+  arena_order[index] = order | ARENA_FREE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+arena_unlink(uint16_t index, uint8_t order)
+{
+  struct arena_free_block *block = ARENA_BLOCK(index);
+
+  if(block->prev != ARENA_NONE) {
+    ARENA_BLOCK(block->prev)->next = block->next;
+  } else {
+    arena_free_list[order] = block->next;
+  }
+  if(block->next != ARENA_NONE) {
+    ARENA_BLOCK(block->next)->prev = block->prev;
+  }
+  arena_order[index] = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+arena_init(void)
+{
+  uint16_t index;
+  uint8_t order;
+
+  memset(arena_order, 0, sizeof(arena_order));
+  for(order = 0; order < ARENA_ORDERS; order++) {
+    arena_free_list[order] = ARENA_NONE;
+  }
+
+  /* Cut the arena into the largest aligned blocks that fit */
+  for(index = 0; index < ARENA_BLOCKS; index += 1 << order) {
+    order = ARENA_ORDERS - 1;
+    while((index & ((1 << order) - 1)) != 0 ||
+          index + (1 << order) > ARENA_BLOCKS) {
+      order--;
+    }
+    arena_push(index, order);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the order of the smallest block holding size bytes, or -1 */
+static int
+arena_order_for(uint16_t size)
+{
+  int order = 0;
+
+  while(((uint16_t)QUEUEBUF_ARENA_BLOCK_SIZE << order) < size) {
+    if(++order == ARENA_ORDERS) {
+      return -1;
+    }
+  }
+  return order;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+arena_alloc(uint8_t order)
+{
+  uint16_t index;
+  uint8_t k;
+
+  for(k = order; k < ARENA_ORDERS && arena_free_list[k] == ARENA_NONE; k++);
+  if(k == ARENA_ORDERS) {
+    return NULL;
+  }
+
+  index = arena_free_list[k];
+  arena_unlink(index, k);
+  /* Split the block, freeing the upper halves */
+  while(k > order) {
+    k--;
+    arena_push(index + (1 << k), k);
+  }
+  arena_order[index] = order;
+
+#if QUEUEBUF_STATS
+  queuebuf_arena_used += QUEUEBUF_ARENA_BLOCK_SIZE << order;
+  if(queuebuf_arena_used > queuebuf_arena_max_used) {
+    queuebuf_arena_max_used = queuebuf_arena_used;
+  }
+#endif /* QUEUEBUF_STATS */
+
+  return ARENA_BLOCK(index);
+}
+/*---------------------------------------------------------------------------*/
+static void
+arena_free(void *ptr)
+{
+  uint16_t index = ARENA_INDEX(ptr);
+  uint16_t buddy;
+  uint8_t order = arena_order[index];
+
+#if QUEUEBUF_STATS
+  queuebuf_arena_used -= QUEUEBUF_ARENA_BLOCK_SIZE << order;
+#endif /* QUEUEBUF_STATS */
+
+  /* Merge with the buddy as long as it is free and whole */
+  while(order < ARENA_ORDERS - 1) {
+    buddy = index ^ (1 << order);
+    if(buddy >= ARENA_BLOCKS || arena_order[buddy] != (order | ARENA_FREE)) {
+      break;
+    }
+    arena_unlink(buddy, order);
+    arena_order[index] = 0;
+    index &= buddy;
+    order++;
+  }
+  arena_push(index, order);
+}
+/*---------------------------------------------------------------------------*/
+/* Stores the attributes of the packetbuf and a frame of len bytes in a
+   block of the arena. The frame is taken from data, or from the
+   packetbuf if data is NULL. The block of old is reused if it has the
+   right size, otherwise it is freed once the new block is filled.
+   Returns NULL, and leaves old untouched, if no block could be found. */
+static struct queuebuf_data *
+arena_store(struct queuebuf_data *old, const uint8_t *data, uint16_t len)
+{
+  struct queuebuf_data *d;
+  packetbuf_attr_t *vals;
+  uint8_t *types;
+  uint8_t nattrs;
+  uint8_t type;
+  int order;
+  int i;
+
+  if(len > PACKETBUF_SIZE) {
+    return NULL;
+  }
+
+  nattrs = 0;
+  for(type = PACKETBUF_ATTR_NONE + 1; type < PACKETBUF_NUM_ATTRS; type++) {
+    if(packetbuf_attr(type) != 0) {
+      nattrs++;
+    }
+  }
+
+  order = arena_order_for(QBUF_SIZE(nattrs, len));
+  if(order < 0) {
+    return NULL;
+  }
+
+  if(old != NULL && arena_order[ARENA_INDEX(old)] == order) {
+    d = old;
+  } else {
+    d = arena_alloc(order);
+    if(d == NULL) {
+      return NULL;
+    }
+  }
+
+  /* Place the frame first: when updating in place, it may overlap its
+     new position and the attributes about to be written */
+  d->nattrs = nattrs;
+  if(data != NULL) {
+    memmove(QBUF_DATA(d), data, len);
+  } else {
+    packetbuf_copyto(QBUF_DATA(d));
+  }
+  d->len = len;
+
+  vals = QBUF_ATTR_VALS(d);
+  types = QBUF_ATTR_TYPES(d);
+  for(type = PACKETBUF_ATTR_NONE + 1; type < PACKETBUF_NUM_ATTRS; type++) {
+    if(packetbuf_attr(type) != 0) {
+      *vals++ = packetbuf_attr(type);
+      *types++ = type;
+    }
+  }
+  for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+    linkaddr_copy(&d->addrs[i].addr, packetbuf_addr(PACKETBUF_ADDR_FIRST + i));
+  }
+
+  if(old != NULL && d != old) {
+    arena_free(old);
+  }
+  return d;
+}
+#endif /* QUEUEBUF_ARENA_SIZE */
+
 #if WITH_SWAP
 /*---------------------------------------------------------------------------*/
 static void
@@ -287,10 +542,17 @@ queuebuf_init(void)
     qbuf_renew_file(i);
   }
 #endif
+#if QUEUEBUF_ARENA_SIZE
+  arena_init();
+#else /* QUEUEBUF_ARENA_SIZE */
   memb_init(&buframmem);
+#endif /* QUEUEBUF_ARENA_SIZE */
   memb_init(&bufmem);
 #if QUEUEBUF_STATS
   queuebuf_max_len = 0;
+#if QUEUEBUF_ARENA_SIZE
+  queuebuf_arena_used = queuebuf_arena_max_used = 0;
+#endif /* QUEUEBUF_ARENA_SIZE */
 #endif /* QUEUEBUF_STATS */
 }
 /*---------------------------------------------------------------------------*/
@@ -310,7 +572,9 @@ queuebuf_new_from_packetbuf(void)
 {
   struct queuebuf *buf;
 
+#if !QUEUEBUF_ARENA_SIZE
   struct queuebuf_data *buframptr;
+#endif /* !QUEUEBUF_ARENA_SIZE */
   buf = memb_alloc(&bufmem);
   if(buf != NULL) {
 #if QUEUEBUF_DEBUG
@@ -319,6 +583,17 @@ queuebuf_new_from_packetbuf(void)
     buf->line = line;
     buf->time = clock_time();
 #endif /* QUEUEBUF_DEBUG */
+#if QUEUEBUF_ARENA_SIZE
+    buf->ram_ptr = arena_store(NULL, NULL, packetbuf_totlen());
+    if(buf->ram_ptr == NULL) {
+      PRINTF("queuebuf_new_from_packetbuf: could not queuebuf data\n");
+#if QUEUEBUF_DEBUG
+      list_remove(queuebuf_list, buf);
+#endif /* QUEUEBUF_DEBUG */
+      memb_free(&bufmem, buf);
+      return NULL;
+    }
+#else /* QUEUEBUF_ARENA_SIZE */
     buf->ram_ptr = memb_alloc(&buframmem);
 #if WITH_SWAP
     /* If the allocation failed, store the qbuf in swap files */
@@ -352,6 +627,7 @@ queuebuf_new_from_packetbuf(void)
       }
     }
 #endif
+#endif /* QUEUEBUF_ARENA_SIZE */
 
 #if QUEUEBUF_STATS
     ++queuebuf_len;
@@ -370,6 +646,15 @@ queuebuf_new_from_packetbuf(void)
 void
 queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 {
+#if QUEUEBUF_ARENA_SIZE
+  struct queuebuf_data *d = arena_store(buf->ram_ptr, QBUF_DATA(buf->ram_ptr),
+                                        buf->ram_ptr->len);
+  if(d != NULL) {
+    buf->ram_ptr = d;
+  } else {
+    PRINTF("queuebuf_update_attr_from_packetbuf: could not queuebuf data\n");
+  }
+#else /* QUEUEBUF_ARENA_SIZE */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 #if WITH_SWAP
@@ -377,11 +662,20 @@ queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* QUEUEBUF_ARENA_SIZE */
 }
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
+#if QUEUEBUF_ARENA_SIZE
+  struct queuebuf_data *d = arena_store(buf->ram_ptr, NULL, packetbuf_totlen());
+  if(d != NULL) {
+    buf->ram_ptr = d;
+  } else {
+    PRINTF("queuebuf_update_from_packetbuf: could not queuebuf data\n");
+  }
+#else /* QUEUEBUF_ARENA_SIZE */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
   buframptr->len = packetbuf_copyto(buframptr->data);
@@ -390,13 +684,16 @@ queuebuf_update_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* QUEUEBUF_ARENA_SIZE */
 }
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_free(struct queuebuf *buf)
 {
   if(memb_inmemb(&bufmem, buf)) {
-#if WITH_SWAP
+#if QUEUEBUF_ARENA_SIZE
+    arena_free(buf->ram_ptr);
+#elif WITH_SWAP
     if(buf->location == IN_RAM) {
       memb_free(&buframmem, buf->ram_ptr);
     } else {
@@ -421,8 +718,21 @@ queuebuf_to_packetbuf(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_ARENA_SIZE
+    int i;
+    /* packetbuf_copyfrom() clears the attributes: only set the others */
+    packetbuf_copyfrom(QBUF_DATA(buframptr), buframptr->len);
+    for(i = 0; i < buframptr->nattrs; i++) {
+      packetbuf_set_attr(QBUF_ATTR_TYPES(buframptr)[i],
+                         QBUF_ATTR_VALS(buframptr)[i]);
+    }
+    for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+      packetbuf_set_addr(PACKETBUF_ADDR_FIRST + i, &buframptr->addrs[i].addr);
+    }
+#else /* QUEUEBUF_ARENA_SIZE */
     packetbuf_copyfrom(buframptr->data, buframptr->len);
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+#endif /* QUEUEBUF_ARENA_SIZE */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -431,7 +741,11 @@ queuebuf_dataptr(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_ARENA_SIZE
+    return QBUF_DATA(buframptr);
+#else /* QUEUEBUF_ARENA_SIZE */
     return buframptr->data;
+#endif /* QUEUEBUF_ARENA_SIZE */
   }
   return NULL;
 }
@@ -454,7 +768,17 @@ packetbuf_attr_t
 queuebuf_attr(struct queuebuf *b, uint8_t type)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
+#if QUEUEBUF_ARENA_SIZE
+  int i;
+  for(i = 0; i < buframptr->nattrs; i++) {
+    if(QBUF_ATTR_TYPES(buframptr)[i] == type) {
+      return QBUF_ATTR_VALS(buframptr)[i];
+    }
+  }
+  return 0;
+#else /* QUEUEBUF_ARENA_SIZE */
   return buframptr->attrs[type].val;
+#endif /* QUEUEBUF_ARENA_SIZE */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -85,6 +85,31 @@
   #define WITH_SWAP 0
 #endif /* QUEUEBUFRAM_CONF_NUM */
 
+/* QUEUEBUF_ARENA_SIZE, when non-zero, enables the variable-size mode:
+   instead of a fixed-size buffer per queuebuf, only the frame and its
+   non-zero attributes are stored, in blocks of a buddy allocator taken
+   from an arena of QUEUEBUF_ARENA_SIZE bytes. Short frames then take a
+   fraction of the RAM, so that QUEUEBUF_NUM can be raised accordingly.
+   Blocks are never moved, so pointers returned by queuebuf_dataptr()
+   and queuebuf_addr() remain valid until the queuebuf is freed or
+   updated. Swapping is not supported in this mode. */
+#ifdef QUEUEBUF_CONF_ARENA_SIZE
+#define QUEUEBUF_ARENA_SIZE QUEUEBUF_CONF_ARENA_SIZE
+#else /* QUEUEBUF_CONF_ARENA_SIZE */
+#define QUEUEBUF_ARENA_SIZE 0
+#endif /* QUEUEBUF_CONF_ARENA_SIZE */
+
+/* The size of the smallest block of the arena, in bytes */
+#ifdef QUEUEBUF_CONF_ARENA_BLOCK_SIZE
+#define QUEUEBUF_ARENA_BLOCK_SIZE QUEUEBUF_CONF_ARENA_BLOCK_SIZE
+#else /* QUEUEBUF_CONF_ARENA_BLOCK_SIZE */
+#define QUEUEBUF_ARENA_BLOCK_SIZE 32
+#endif /* QUEUEBUF_CONF_ARENA_BLOCK_SIZE */
+
+#if QUEUEBUF_ARENA_SIZE && WITH_SWAP
+#error "QUEUEBUF_CONF_ARENA_SIZE cannot be used together with swapping"
+#endif
+
 #ifdef QUEUEBUF_CONF_DEBUG
 #define QUEUEBUF_DEBUG QUEUEBUF_CONF_DEBUG
 #else /* QUEUEBUF_CONF_DEBUG */
@@ -105,9 +105,9 @@
 /*
  * The objective function (OF) used by a RPL root is configurable through
  * the RPL_CONF_OF_OCP parameter. This is defined as the objective code
- * point (OCP) of the OF, RPL_OCP_OF0 or RPL_OCP_MRHOF. This flag is of
- * no relevance to non-root nodes, which run the OF advertised in the
- * instance they join.
+ * point (OCP) of the OF, RPL_OCP_OF0, RPL_OCP_MRHOF or RPL_OCP_LOADOF.
+ * This flag is of no relevance to non-root nodes, which run the OF
+ * advertised in the instance they join.
  * Make sure the selected of is inRPL_SUPPORTED_OFS.
  */
 #ifdef RPL_CONF_OF_OCP
@@ -119,7 +119,8 @@
 /*
  * The set of objective functions supported at runtime. Nodes are only
  * able to join instances that advertise an OF in this set. To include
- * both OF0 and MRHOF, use {&rpl_of0, &rpl_mrhof}.
+ * both OF0 and MRHOF, use {&rpl_of0, &rpl_mrhof}. The load-aware OF,
+ * rpl_loadof, requires RPL_CONF_WITH_MC.
  */
 #ifdef RPL_CONF_SUPPORTED_OFS
 #define RPL_SUPPORTED_OFS RPL_CONF_SUPPORTED_OFS
@@ -302,6 +303,36 @@
 #define RPL_WITH_DAO_ACK 0
 #endif /* RPL_CONF_WITH_DAO_ACK */
 
+/*
+ * RPL DAO coalescing, for storing mode. When enabled, a node does not
+ * forward the DAOs of its children one by one. It acknowledges them
+ * itself, and sends the routes they added or removed in one DAO with
+ * several targets, RPL_DAO_COALESCE_WINDOW after the first one. Its
+ * own DAO timer sends all its routes in the same way, to refresh them.
+ * Coalesced DAOs request a DAO-ACK, and are sent again, up to
+ * RPL_DAO_MAX_RETRANSMISSIONS times, until one comes.
+ * All nodes of the DAG must enable it, as others only consider the
+ * last target of a DAO.
+ * */
+#ifdef RPL_CONF_WITH_DAO_COALESCING
+#define RPL_WITH_DAO_COALESCING RPL_CONF_WITH_DAO_COALESCING
+#else
+#define RPL_WITH_DAO_COALESCING 0
+#endif /* RPL_CONF_WITH_DAO_COALESCING */
+
+#ifdef RPL_CONF_DAO_COALESCE_WINDOW
+#define RPL_DAO_COALESCE_WINDOW RPL_CONF_DAO_COALESCE_WINDOW
+#else
+#define RPL_DAO_COALESCE_WINDOW (CLOCK_SECOND * 2)
+#endif /* RPL_CONF_DAO_COALESCE_WINDOW */
+
+/* The maximum number of targets in a coalesced DAO, sent or received */
+#ifdef RPL_CONF_DAO_COALESCE_MAX_TARGETS
+#define RPL_DAO_COALESCE_MAX_TARGETS RPL_CONF_DAO_COALESCE_MAX_TARGETS
+#else
+#define RPL_DAO_COALESCE_MAX_TARGETS 8
+#endif /* RPL_CONF_DAO_COALESCE_MAX_TARGETS */
+
 /*
  * RPL REPAIR ON DAO NACK. When enabled, DAO NACK will trigger a local
  * repair in order to quickly find a new parent to send DAO's to.
@@ -78,6 +78,9 @@ static void dao_ack_input(void);
 
 static void dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
                                   uint8_t lifetime, uint8_t seq_no);
+#if RPL_WITH_STORING && RPL_WITH_DAO_COALESCING
+static void handle_dao_coalesce_timer(void *ptr);
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_COALESCING */
 
 /* some debug callbacks useful when debugging RPL networks */
 #ifdef RPL_DEBUG_DIO_INPUT
@@ -389,6 +392,9 @@ dio_input(void)
         } else if(dio.mc.type == RPL_DAG_MC_ENERGY) {
           dio.mc.obj.energy.flags = buffer[i + 6];
           dio.mc.obj.energy.energy_est = buffer[i + 7];
+        } else if(dio.mc.type == RPL_DAG_MC_LOAD) {
+          dio.mc.obj.load.queue = buffer[i + 6];
+          dio.mc.obj.load.tx = buffer[i + 7];
         } else {
           LOG_WARN("Unhandled DAG MC type: %u\n", (unsigned)dio.mc.type);
           goto discard;
@@ -550,6 +556,10 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
       buffer[pos++] = 2;
       buffer[pos++] = instance->mc.obj.energy.flags;
       buffer[pos++] = instance->mc.obj.energy.energy_est;
+    } else if(instance->mc.type == RPL_DAG_MC_LOAD) {
+      buffer[pos++] = 2;
+      buffer[pos++] = instance->mc.obj.load.queue;
+      buffer[pos++] = instance->mc.obj.load.tx;
     } else {
       LOG_ERR("Unable to send DIO because of unhandled DAG MC type %u\n",
              (unsigned)instance->mc.type);
@@ -628,6 +638,180 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 #endif /* RPL_LEAF_ONLY */
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_STORING && RPL_WITH_DAO_COALESCING
+/* Adds, refreshes or removes the route to a target of a DAO from a
+   child, and marks it for the next coalesced DAO if our routes changed.
+   Returns 0 if the route could not be added. */
+static int
+dao_coalesce_target(rpl_dag_t *dag, uip_ipaddr_t *prefix, uint8_t prefixlen,
+                    uint8_t lifetime, uip_ipaddr_t *from)
+{
+  uip_ds6_route_t *rep;
+  const uip_ipaddr_t *nexthop;
+  int changed;
+
+  rep = uip_ds6_route_lookup(prefix);
+  nexthop = rep != NULL ? uip_ds6_route_nexthop(rep) : NULL;
+
+  if(lifetime == RPL_ZERO_LIFETIME) {
+    if(rep != NULL &&
+       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
+       rep->length == prefixlen &&
+       nexthop != NULL && uip_ipaddr_cmp(nexthop, from)) {
+      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
+      RPL_ROUTE_SET_DAO_DELTA(rep);
+      RPL_ROUTE_CLEAR_DAO_UNACKED(rep);
+      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
+    }
+    return 1;
+  }
+
+  changed = rep == NULL || RPL_ROUTE_IS_NOPATH_RECEIVED(rep) ||
+    rep->length != prefixlen || nexthop == NULL || !uip_ipaddr_cmp(nexthop, from);
+  rep = rpl_add_route(dag, prefix, prefixlen, from);
+  if(rep == NULL) {
+    RPL_STAT(rpl_stats.mem_overflows++);
+    return 0;
+  }
+  rep->state.lifetime = RPL_LIFETIME(dag->instance, lifetime);
+  if(changed) {
+    /* A DAO-ACK for the last coalesced DAO would not cover the change */
+    RPL_ROUTE_SET_DAO_DELTA(rep);
+    RPL_ROUTE_CLEAR_DAO_UNACKED(rep);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Applies the lifetime of a transit option to the targets before it.
+   Returns 0 if a route could not be added. */
+static int
+dao_coalesce_transit(rpl_dag_t *dag, uip_ipaddr_t *targets, uint8_t *prefixlens,
+                     uint8_t count, uint8_t lifetime, uip_ipaddr_t *from)
+{
+  int ok = 1;
+  uint8_t i;
+
+  for(i = 0; i < count; i++) {
+    LOG_INFO("DAO lifetime: %u, prefix length: %u prefix: ",
+             (unsigned)lifetime, (unsigned)prefixlens[i]);
+    LOG_INFO_6ADDR(&targets[i]);
+    LOG_INFO_("\n");
+    if(!dao_coalesce_target(dag, &targets[i], prefixlens[i], lifetime, from)) {
+      LOG_ERR("Could not add a route after receiving a DAO\n");
+      ok = 0;
+    }
+  }
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the options of a DAO, which start at buffer, all fit in
+   it and hold what is read from them */
+static int
+dao_coalesce_options_valid(const unsigned char *buffer, int buffer_length)
+{
+  int len;
+  int i;
+
+  for(i = 0; i < buffer_length; i += len) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    if(i + 2 > buffer_length) {
+      return 0;
+    }
+    len = 2 + buffer[i + 1];
+    if(i + len > buffer_length) {
+      return 0;
+    }
+    if(buffer[i] == RPL_OPTION_TARGET &&
+       (len < 4 || buffer[i + 3] > 128 ||
+        4 + (buffer[i + 3] + 7) / CHAR_BIT > len)) {
+      return 0;
+    }
+    if(buffer[i] == RPL_OPTION_TRANSIT && len < 6) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Handles a unicast DAO from a child, whose options start at buffer */
+static void
+dao_input_coalesce(rpl_dag_t *dag, uip_ipaddr_t *from, unsigned char *buffer,
+                   int buffer_length, uint8_t flags, uint8_t sequence)
+{
+  rpl_instance_t *instance = dag->instance;
+  uip_ipaddr_t targets[RPL_DAO_COALESCE_MAX_TARGETS];
+  uint8_t prefixlens[RPL_DAO_COALESCE_MAX_TARGETS];
+  uint8_t count = 0;
+  int is_root = dag->rank == ROOT_RANK(instance);
+  int ok = 1;
+  int len;
+  int i;
+
+  if(!dao_coalesce_options_valid(buffer, buffer_length)) {
+    LOG_WARN("Malformed options in DAO from ");
+    LOG_WARN_6ADDR(from);
+    LOG_WARN_(", dropping it\n");
+    ok = 0;
+    goto ack;
+  }
+
+  if(rpl_icmp6_update_nbr_table(from, NBR_TABLE_REASON_RPL_DAO, instance) == NULL) {
+    LOG_ERR("Out of Memory, dropping DAO from ");
+    LOG_ERR_6ADDR(from);
+    LOG_ERR_("\n");
+    ok = 0;
+    goto ack;
+  }
+
+  for(i = 0; i < buffer_length; i += len) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    len = 2 + buffer[i + 1];
+    if(buffer[i] == RPL_OPTION_TARGET) {
+      if(count >= RPL_DAO_COALESCE_MAX_TARGETS) {
+        LOG_WARN("Too many targets in DAO, ignoring some\n");
+        continue;
+      }
+      prefixlens[count] = buffer[i + 3];
+      memset(&targets[count], 0, sizeof(targets[count]));
+      memcpy(&targets[count], buffer + i + 4, (prefixlens[count] + 7) / CHAR_BIT);
+      count++;
+    } else if(buffer[i] == RPL_OPTION_TRANSIT) {
+      ok &= dao_coalesce_transit(dag, targets, prefixlens, count, buffer[i + 5], from);
+      count = 0;
+    }
+  }
+  /* Targets with no transit option after them get the default lifetime */
+  ok &= dao_coalesce_transit(dag, targets, prefixlens, count,
+                             instance->default_lifetime, from);
+
+  /* Our parent gets the changes in the next coalesced DAO, instead of
+     this DAO */
+  if(!is_root && dag->preferred_parent != NULL) {
+    RPL_STAT(rpl_stats.dao_tx_saved++);
+    RPL_STAT(rpl_stats.dao_bytes_saved += uip_len);
+    if(ctimer_expired(&instance->dao_coalesce_timer)) {
+      ctimer_set(&instance->dao_coalesce_timer, RPL_DAO_COALESCE_WINDOW,
+                 handle_dao_coalesce_timer, instance);
+    }
+  }
+
+ack:
+  if(flags & RPL_DAO_K_FLAG) {
+    uipbuf_clear();
+    dao_ack_output(instance, from, sequence,
+                   ok ? RPL_DAO_ACK_UNCONDITIONAL_ACCEPT :
+                   is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+                   RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+  }
+}
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_COALESCING */
+/*---------------------------------------------------------------------------*/
 static void
 dao_input_storing(void)
 {
@@ -722,6 +906,15 @@ dao_input_storing(void)
     }
   }
 
+#if RPL_WITH_DAO_COALESCING
+  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO &&
+     instance->mop != RPL_MOP_STORING_MULTICAST) {
+    dao_input_coalesce(dag, &dao_sender_addr, buffer + pos,
+                       buffer_length - pos, flags, sequence);
+    return;
+  }
+#endif /* RPL_WITH_DAO_COALESCING */
+
   /* Check if there are any RPL options present. */
   for(i = pos; i < buffer_length; i += len) {
     subopt_type = buffer[i];
@@ -1262,10 +1455,214 @@ dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
     uip_icmp6_send(dest_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
   }
 }
+#if RPL_WITH_STORING && RPL_WITH_DAO_COALESCING
+/*---------------------------------------------------------------------------*/
+/* Stops waiting for a DAO-ACK for the last coalesced DAO. The routes it
+   carried are up to date at our parent if it was acknowledged, and are
+   to be sent again otherwise. */
+static void
+dao_coalesce_end_wait(rpl_instance_t *instance, int acked)
+{
+  uip_ds6_route_t *rep;
+
+  ctimer_stop(&instance->dao_coalesce_timer);
+  for(rep = uip_ds6_route_head(); rep != NULL; rep = uip_ds6_route_next(rep)) {
+    if(rep->state.dag != NULL && rep->state.dag->instance == instance &&
+       RPL_ROUTE_IS_DAO_UNACKED(rep)) {
+      RPL_ROUTE_CLEAR_DAO_UNACKED(rep);
+      if(acked) {
+        RPL_ROUTE_CLEAR_DAO_DELTA(rep);
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Writes a target suboption for each route of a DAG that was added, or
+   removed, since it was last acknowledged by our parent, up to
+   RPL_DAO_COALESCE_MAX_TARGETS of them. Returns their number. */
+static uint8_t
+dao_coalesce_write_targets(rpl_dag_t *dag, unsigned char *buffer, int *pos,
+                           int removed)
+{
+  uip_ds6_route_t *rep;
+  uint8_t count = 0;
+
+  for(rep = uip_ds6_route_head();
+      rep != NULL && count < RPL_DAO_COALESCE_MAX_TARGETS;
+      rep = uip_ds6_route_next(rep)) {
+    if(rep->state.dag != dag || !RPL_ROUTE_IS_DAO_DELTA(rep) ||
+       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) != !removed) {
+      continue;
+    }
+    RPL_ROUTE_SET_DAO_UNACKED(rep);
+    buffer[(*pos)++] = RPL_OPTION_TARGET;
+    buffer[(*pos)++] = 2 + ((rep->length + 7) / CHAR_BIT);
+    buffer[(*pos)++] = 0; /* reserved */
+    buffer[(*pos)++] = rep->length;
+    memcpy(buffer + *pos, &rep->ipaddr, (rep->length + 7) / CHAR_BIT);
+    *pos += ((rep->length + 7) / CHAR_BIT);
+    count++;
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_dao_coalesce_timer(void *ptr)
+{
+  rpl_instance_t *instance = ptr;
+
+  if(instance->dao_coalesce_transmissions > 0) {
+    /* No DAO-ACK for the last coalesced DAO */
+    dao_coalesce_end_wait(instance, 0);
+    if(instance->dao_coalesce_transmissions >= RPL_DAO_MAX_RETRANSMISSIONS) {
+      LOG_WARN("No DAO-ACK for coalesced DAO, keeping the changes for later\n");
+      instance->dao_coalesce_transmissions = 0;
+      return;
+    }
+  }
+  dao_output_coalesced(instance, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Handles a DAO-ACK for the last coalesced DAO. Returns 0 if the DAO-ACK
+   is for another DAO. */
+static int
+dao_ack_input_coalesced(void)
+{
+  uint8_t *buffer;
+  rpl_instance_t *instance;
+  uint8_t status;
+
+  buffer = UIP_ICMP_PAYLOAD;
+  instance = rpl_get_instance(buffer[0]);
+  if(instance == NULL || instance->dao_coalesce_transmissions == 0 ||
+     buffer[2] != instance->dao_coalesce_seqno) {
+    return 0;
+  }
+  status = buffer[3];
+
+  LOG_INFO("Received a DAO %s for the coalesced DAO with sequence number %u, status %u\n",
+           status < RPL_DAO_ACK_UNABLE_TO_ACCEPT ? "ACK" : "NACK",
+           instance->dao_coalesce_seqno, status);
+
+  dao_coalesce_end_wait(instance, status < RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+  instance->dao_coalesce_transmissions = 0;
+  if(status < RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
+    /* Send what did not fit in that DAO, or changed since */
+    dao_output_coalesced(instance, 0);
+  }
+  return 1;
+}
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_COALESCING */
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_COALESCING
+void
+dao_output_coalesced(rpl_instance_t *instance, int all_routes)
+{
+#if RPL_WITH_STORING
+  rpl_dag_t *dag = instance->current_dag;
+  uip_ipaddr_t *parent_ipaddr;
+  uip_ds6_route_t *rep;
+  unsigned char *buffer;
+  uint8_t removed;
+  uint8_t count;
+  int pos;
+
+  if(dag == NULL || dag->preferred_parent == NULL ||
+     !RPL_IS_STORING(instance) || rpl_get_mode() == RPL_MODE_FEATHER) {
+    return;
+  }
+  parent_ipaddr = rpl_parent_get_ipaddr(dag->preferred_parent);
+  if(parent_ipaddr == NULL) {
+    /* Keep the changes for later */
+    return;
+  }
+
+  if(all_routes) {
+    for(rep = uip_ds6_route_head(); rep != NULL; rep = uip_ds6_route_next(rep)) {
+      if(rep->state.dag == dag && !RPL_ROUTE_IS_NOPATH_RECEIVED(rep)) {
+        RPL_ROUTE_SET_DAO_DELTA(rep);
+      }
+    }
+  }
+
+  if(instance->dao_coalesce_transmissions > 0 &&
+     !ctimer_expired(&instance->dao_coalesce_timer)) {
+    /* The changes go out once the last coalesced DAO is acknowledged */
+    return;
+  }
+  /* Whatever it carried is sent again if still to be advertised */
+  dao_coalesce_end_wait(instance, 0);
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  buffer[pos++] = instance->instance_id;
+  /* The changes are only cleared once our parent acknowledges them */
+  buffer[pos] = RPL_DAO_K_FLAG;
+#if RPL_DAO_SPECIFY_DAG
+  buffer[pos] |= RPL_DAO_D_FLAG;
+#endif /* RPL_DAO_SPECIFY_DAG */
+  ++pos;
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = 0; /* sequence number, set when sending */
+#if RPL_DAO_SPECIFY_DAG
+  memcpy(buffer + pos, &dag->dag_id, sizeof(dag->dag_id));
+  pos += sizeof(dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+
+  /* The added routes, then the removed ones, one DAO at a time */
+  removed = 0;
+  count = dao_coalesce_write_targets(dag, buffer, &pos, removed);
+  if(count == 0) {
+    removed = 1;
+    count = dao_coalesce_write_targets(dag, buffer, &pos, removed);
+  }
+  if(count == 0) {
+    instance->dao_coalesce_transmissions = 0;
+    return;
+  }
+
+  /* One transit information suboption for all of them */
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 4;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = removed ? RPL_ZERO_LIFETIME : instance->default_lifetime;
+
+  RPL_LOLLIPOP_INCREMENT(dao_sequence);
+  buffer[3] = dao_sequence;
+  instance->dao_coalesce_seqno = dao_sequence;
+  instance->dao_coalesce_transmissions++;
+  ctimer_set(&instance->dao_coalesce_timer, RPL_DAO_RETRANSMISSION_TIMEOUT,
+             handle_dao_coalesce_timer, instance);
+
+  LOG_INFO("Sending a coalesced %sDAO with sequence number %u, %u targets, to ",
+           removed ? "No-Path " : "", dao_sequence, count);
+  LOG_INFO_6ADDR(parent_ipaddr);
+  LOG_INFO_(" (transmission %u)\n", instance->dao_coalesce_transmissions);
+
+  RPL_STAT(rpl_stats.dao_tx_saved--);
+  RPL_STAT(rpl_stats.dao_bytes_saved -= UIP_IPH_LEN + UIP_ICMPH_LEN + pos);
+  uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
+#if RPL_CONF_STATS
+  LOG_INFO("DAO coalescing saved %ld transmissions, %ld bytes\n",
+           (long)rpl_stats.dao_tx_saved, (long)rpl_stats.dao_bytes_saved);
+#endif /* RPL_CONF_STATS */
+#endif /* RPL_WITH_STORING */
+}
+#endif /* RPL_WITH_DAO_COALESCING */
 /*---------------------------------------------------------------------------*/
 static void
 dao_ack_input(void)
 {
+#if RPL_WITH_STORING && RPL_WITH_DAO_COALESCING
+  if(dao_ack_input_coalesced()) {
+    uipbuf_clear();
+    return;
+  }
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_COALESCING */
+
 #if RPL_WITH_DAO_ACK
 
   uint8_t *buffer;
@@ -1367,7 +1764,8 @@ void
 dao_ack_output(rpl_instance_t *instance, uip_ipaddr_t *dest, uint8_t sequence,
                uint8_t status)
 {
-#if RPL_WITH_DAO_ACK
+  /* Coalesced DAOs are always acknowledged */
+#if RPL_WITH_DAO_ACK || RPL_WITH_DAO_COALESCING
   unsigned char *buffer;
 
   LOG_INFO("Sending a DAO %s with sequence number %d to ", status < 128 ? "ACK" : "NACK", sequence);
@@ -1382,7 +1780,7 @@ dao_ack_output(rpl_instance_t *instance, uip_ipaddr_t *dest, uint8_t sequence,
   buffer[3] = status;
 
   uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
-#endif /* RPL_WITH_DAO_ACK */
+#endif /* RPL_WITH_DAO_ACK || RPL_WITH_DAO_COALESCING */
 }
 /*---------------------------------------------------------------------------*/
 void
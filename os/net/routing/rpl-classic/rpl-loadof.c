@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A load-aware objective function.
+ *
+ *         The rank is computed from the ETX, as with MRHOF. Parents are
+ *         however selected on a path cost that also accounts for the load
+ *         of the most loaded node on the path: the occupancy of its MAC
+ *         queue and the share of time it spends transmitting. Each node
+ *         advertises the load of its path in a DAG metric container,
+ *         aggregated as a maximum. Keeping the load out of the rank
+ *         avoids propagating its fluctuations down the DODAG.
+ *
+ *         Requires RPL_CONF_WITH_MC. The TX duty cycle is measured with
+ *         energest, and taken as zero unless ENERGEST_CONF_ON is set.
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+#include "net/routing/rpl-classic/rpl.h"
+#include "net/routing/rpl-classic/rpl-private.h"
+#include "net/nbr-table.h"
+#include "net/link-stats.h"
+#include "net/queuebuf.h"
+#include "sys/energest.h"
+#if MAC_CONF_WITH_TSCH
+#include "net/mac/tsch/tsch.h"
+#elif MAC_CONF_WITH_CSMA
+#include "net/mac/csma/csma-output.h"
+#endif /* MAC_CONF_WITH_TSCH */
+
+#include <string.h>
+
+#include "sys/log.h"
+
+#define LOG_MODULE "RPL"
+#define LOG_LEVEL LOG_LEVEL_RPL
+
+#if RPL_WITH_MC
+
+/* Reject parents that have a higher link metric than the following. */
+#ifdef RPL_LOADOF_CONF_MAX_LINK_METRIC
+#define MAX_LINK_METRIC     RPL_LOADOF_CONF_MAX_LINK_METRIC
+#else /* RPL_LOADOF_CONF_MAX_LINK_METRIC */
+#define MAX_LINK_METRIC     1024 /* Eq ETX of 8 */
+#endif /* RPL_LOADOF_CONF_MAX_LINK_METRIC */
+
+/* Reject parents that have a higher path cost than the following. */
+#define MAX_PATH_COST      32768   /* Eq path ETX of 256 */
+
+/* The path cost added for a fully loaded path. With 512, a path through
+ * a node with a full queue costs as much as four more perfect hops. */
+#ifdef RPL_LOADOF_CONF_LOAD_WEIGHT
+#define LOAD_WEIGHT         RPL_LOADOF_CONF_LOAD_WEIGHT
+#else /* RPL_LOADOF_CONF_LOAD_WEIGHT */
+#define LOAD_WEIGHT         512 /* Eq ETX of 4 */
+#endif /* RPL_LOADOF_CONF_LOAD_WEIGHT */
+
+/* Hysteresis: the path cost must differ more than PARENT_SWITCH_THRESHOLD
+ * in order to switch preferred parent. This is the default of RFC6719
+ * rather than the more aggressive setting of our MRHOF, as the load
+ * varies faster than the ETX. */
+#ifdef RPL_LOADOF_CONF_PARENT_SWITCH_THRESHOLD
+#define PARENT_SWITCH_THRESHOLD RPL_LOADOF_CONF_PARENT_SWITCH_THRESHOLD
+#else /* RPL_LOADOF_CONF_PARENT_SWITCH_THRESHOLD */
+#define PARENT_SWITCH_THRESHOLD 192 /* Eq ETX of 1.5 */
+#endif /* RPL_LOADOF_CONF_PARENT_SWITCH_THRESHOLD */
+
+/* How often our own load is measured. Each measurement is smoothed with
+ * an EWMA of weight 1/4, so that a short burst of traffic does not
+ * change the parent of the nodes below us. */
+#ifdef RPL_LOADOF_CONF_SAMPLE_INTERVAL
+#define SAMPLE_INTERVAL     RPL_LOADOF_CONF_SAMPLE_INTERVAL
+#else /* RPL_LOADOF_CONF_SAMPLE_INTERVAL */
+#define SAMPLE_INTERVAL     (10 * CLOCK_SECOND)
+#endif /* RPL_LOADOF_CONF_SAMPLE_INTERVAL */
+
+static struct rpl_metric_object_load own_load;
+static struct timer sample_timer;
+static uint64_t last_tx_time;
+static uint64_t last_total_time;
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+queue_occupancy(void)
+{
+#if MAC_CONF_WITH_TSCH
+  return MIN(tsch_queue_global_packet_count() * 100 / QUEUEBUF_NUM, 100);
+#elif MAC_CONF_WITH_CSMA
+  return csma_output_queue_occupancy();
+#else /* MAC_CONF_WITH_TSCH */
+  return 0;
+#endif /* MAC_CONF_WITH_TSCH */
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_own_load(void)
+{
+  uint64_t tx_time;
+  uint64_t total_time;
+  uint8_t tx = 0;
+
+  if(!timer_expired(&sample_timer)) {
+    return;
+  }
+  timer_set(&sample_timer, SAMPLE_INTERVAL);
+
+  energest_flush();
+  tx_time = energest_type_time(ENERGEST_TYPE_TRANSMIT);
+  total_time = ENERGEST_GET_TOTAL_TIME();
+  if(total_time > last_total_time) {
+    tx = MIN((tx_time - last_tx_time) * 100 / (total_time - last_total_time), 100);
+  }
+  last_tx_time = tx_time;
+  last_total_time = total_time;
+
+  own_load.queue = ((uint16_t)own_load.queue * 3 + queue_occupancy()) / 4;
+  own_load.tx = ((uint16_t)own_load.tx * 3 + tx) / 4;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(rpl_dag_t *dag)
+{
+  LOG_INFO("Reset LoadOF\n");
+  memset(&own_load, 0, sizeof(own_load));
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_ACK
+static void
+dao_ack_callback(rpl_parent_t *p, int status)
+{
+  if(status == RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT) {
+    return;
+  }
+  LOG_DBG("LoadOF - DAO ACK received with status: %d\n", status);
+  if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT || status == RPL_DAO_ACK_TIMEOUT) {
+    /* punish the ETX as if this was 10 packets lost, as in MRHOF */
+    link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+  }
+}
+#endif /* RPL_WITH_DAO_ACK */
+/*---------------------------------------------------------------------------*/
+static uint16_t
+parent_link_metric(rpl_parent_t *p)
+{
+  const struct link_stats *stats = rpl_get_parent_link_stats(p);
+  return stats != NULL ? stats->etx : 0xffff;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+parent_etx_cost(rpl_parent_t *p)
+{
+  /* path cost upper bound: 0xffff */
+  return MIN((uint32_t)p->rank + parent_link_metric(p), 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+parent_path_cost(rpl_parent_t *p)
+{
+  uint8_t load = 0;
+
+  if(p == NULL || p->dag == NULL || p->dag->instance == NULL) {
+    return 0xffff;
+  }
+
+  if(p->dag->instance->mc.type == RPL_DAG_MC_LOAD) {
+    load = MAX(p->mc.obj.load.queue, p->mc.obj.load.tx);
+  }
+
+  return MIN((uint32_t)parent_etx_cost(p) + (uint32_t)LOAD_WEIGHT * load / 100, 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_rank_t
+rank_via_parent(rpl_parent_t *p)
+{
+  uint16_t min_hoprankinc;
+
+  if(p == NULL || p->dag == NULL || p->dag->instance == NULL) {
+    return RPL_INFINITE_RANK;
+  }
+
+  min_hoprankinc = p->dag->instance->min_hoprankinc;
+
+  /* Rank lower-bound: parent rank + min_hoprankinc */
+  return MAX(MIN((uint32_t)p->rank + min_hoprankinc, 0xffff), parent_etx_cost(p));
+}
+/*---------------------------------------------------------------------------*/
+static int
+parent_is_acceptable(rpl_parent_t *p)
+{
+  uint16_t link_metric = parent_link_metric(p);
+  uint16_t path_cost = parent_path_cost(p);
+  /* Exclude links with too high link metrics or path cost */
+  return link_metric <= MAX_LINK_METRIC && path_cost <= MAX_PATH_COST;
+}
+/*---------------------------------------------------------------------------*/
+static int
+parent_has_usable_link(rpl_parent_t *p)
+{
+  uint16_t link_metric = parent_link_metric(p);
+  /* Exclude links with too high link metrics  */
+  return link_metric <= MAX_LINK_METRIC;
+}
+/*---------------------------------------------------------------------------*/
+static rpl_parent_t *
+best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
+{
+  rpl_dag_t *dag;
+  uint16_t p1_cost;
+  uint16_t p2_cost;
+  int p1_is_acceptable;
+  int p2_is_acceptable;
+
+  p1_is_acceptable = p1 != NULL && parent_is_acceptable(p1);
+  p2_is_acceptable = p2 != NULL && parent_is_acceptable(p2);
+
+  if(!p1_is_acceptable) {
+    return p2_is_acceptable ? p2 : NULL;
+  }
+  if(!p2_is_acceptable) {
+    return p1_is_acceptable ? p1 : NULL;
+  }
+
+  dag = p1->dag; /* Both parents are in the same DAG. */
+  p1_cost = parent_path_cost(p1);
+  p2_cost = parent_path_cost(p2);
+
+  /* Maintain stability of the preferred parent in case of similar costs. */
+  if(p1 == dag->preferred_parent || p2 == dag->preferred_parent) {
+    if(p1_cost < p2_cost + PARENT_SWITCH_THRESHOLD &&
+       p1_cost > p2_cost - PARENT_SWITCH_THRESHOLD) {
+      return dag->preferred_parent;
+    }
+  }
+
+  return p1_cost < p2_cost ? p1 : p2;
+}
+/*---------------------------------------------------------------------------*/
+static rpl_dag_t *
+best_dag(rpl_dag_t *d1, rpl_dag_t *d2)
+{
+  if(d1->grounded != d2->grounded) {
+    return d1->grounded ? d1 : d2;
+  }
+
+  if(d1->preference != d2->preference) {
+    return d1->preference > d2->preference ? d1 : d2;
+  }
+
+  return d1->rank < d2->rank ? d1 : d2;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_metric_container(rpl_instance_t *instance)
+{
+  rpl_dag_t *dag;
+  struct rpl_metric_object_load load;
+
+  dag = instance->current_dag;
+  if(dag == NULL || !dag->joined) {
+    LOG_WARN("Cannot update the metric container when not joined\n");
+    return;
+  }
+
+  update_own_load();
+  load = own_load;
+
+  if(dag->rank == ROOT_RANK(instance)) {
+    /* Configure MC at root only, other nodes are auto-configured when joining */
+    instance->mc.type = RPL_DAG_MC_LOAD;
+    instance->mc.flags = 0;
+    instance->mc.aggr = RPL_DAG_MC_AGGR_MAXIMUM;
+    instance->mc.prec = 0;
+  } else if(instance->mc.type == RPL_DAG_MC_LOAD) {
+    /* The load of the path is that of its most loaded node */
+    if(dag->preferred_parent != NULL) {
+      load.queue = MAX(load.queue, dag->preferred_parent->mc.obj.load.queue);
+      load.tx = MAX(load.tx, dag->preferred_parent->mc.obj.load.tx);
+    }
+  } else {
+    LOG_WARN("LoadOF, non-supported MC %u\n", instance->mc.type);
+    return;
+  }
+
+  instance->mc.length = sizeof(instance->mc.obj.load);
+  instance->mc.obj.load = load;
+}
+/*---------------------------------------------------------------------------*/
+rpl_of_t rpl_loadof = {
+  reset,
+#if RPL_WITH_DAO_ACK
+  dao_ack_callback,
+#endif
+  parent_link_metric,
+  parent_has_usable_link,
+  parent_path_cost,
+  rank_via_parent,
+  best_parent,
+  best_dag,
+  update_metric_container,
+  RPL_OCP_LOADOF
+};
+
+#endif /* RPL_WITH_MC */
+
+/** @}*/
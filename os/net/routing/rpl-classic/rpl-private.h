@@ -162,11 +162,11 @@
  * use 128 for RPL_MIN_HOPRANKINC, resulting in a rank equal to the
  * ETX path cost. Larger values may also be desirable, as discussed
  * in section 6.1 of RFC6719. */
-#if RPL_OF_OCP == RPL_OCP_MRHOF
+#if RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF
 #define RPL_MIN_HOPRANKINC          128
-#else /* RPL_OF_OCP == RPL_OCP_MRHOF */
+#else /* RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF */
 #define RPL_MIN_HOPRANKINC          256
-#endif /* RPL_OF_OCP == RPL_OCP_MRHOF */
+#endif /* RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF */
 #else /* RPL_CONF_MIN_HOPRANKINC */
 #define RPL_MIN_HOPRANKINC          RPL_CONF_MIN_HOPRANKINC
 #endif /* RPL_CONF_MIN_HOPRANKINC */
@@ -257,6 +257,13 @@ struct rpl_stats {
   uint16_t loop_errors;
   uint16_t loop_warnings;
   uint16_t root_repairs;
+#if RPL_WITH_DAO_COALESCING
+  /* DAO transmissions and bytes (IPv6 packets) saved by coalescing:
+     those of the child DAOs not forwarded, minus those of the coalesced
+     DAOs sent. May be negative in small or idle networks. */
+  int32_t dao_tx_saved;
+  int32_t dao_bytes_saved;
+#endif /* RPL_WITH_DAO_COALESCING */
 };
 typedef struct rpl_stats rpl_stats_t;
 
@@ -295,6 +302,9 @@ void dis_output(uip_ipaddr_t *addr);
 void dio_output(rpl_instance_t *, uip_ipaddr_t *uc_addr);
 void dao_output(rpl_parent_t *, uint8_t lifetime);
 void dao_output_target(rpl_parent_t *, uip_ipaddr_t *, uint8_t lifetime);
+#if RPL_WITH_DAO_COALESCING
+void dao_output_coalesced(rpl_instance_t *instance, int all_routes);
+#endif /* RPL_WITH_DAO_COALESCING */
 void dao_ack_output(rpl_instance_t *, uip_ipaddr_t *, uint8_t, uint8_t);
 void rpl_icmp6_register_handlers(void);
 uip_ds6_nbr_t *rpl_icmp6_update_nbr_table(uip_ipaddr_t *from,
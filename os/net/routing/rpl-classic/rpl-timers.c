@@ -275,6 +275,12 @@ handle_dao_timer(void *ptr)
     LOG_INFO("handle_dao_timer - sending DAO\n");
     /* Set the route lifetime to the default value. */
     dao_output(instance->current_dag->preferred_parent, instance->default_lifetime);
+#if RPL_WITH_DAO_COALESCING
+    /* Refresh all routes learned from the sub-DODAG in bulk */
+    if(RPL_IS_STORING(instance)) {
+      dao_output_coalesced(instance, 1);
+    }
+#endif /* RPL_WITH_DAO_COALESCING */
 
 #if RPL_WITH_MULTICAST
     /* Send DAOs for multicast prefixes only if the instance is in MOP 3 */
@@ -357,6 +363,10 @@ rpl_cancel_dao(rpl_instance_t *instance)
 {
   ctimer_stop(&instance->dao_timer);
   ctimer_stop(&instance->dao_lifetime_timer);
+#if RPL_WITH_DAO_COALESCING
+  ctimer_stop(&instance->dao_coalesce_timer);
+  instance->dao_coalesce_transmissions = 0;
+#endif /* RPL_WITH_DAO_COALESCING */
 }
 /*---------------------------------------------------------------------------*/
 static void
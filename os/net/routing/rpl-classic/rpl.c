@@ -126,6 +126,15 @@ rpl_purge_routes(void)
   r = uip_ds6_route_head();
 
   while(r != NULL) {
+#if RPL_WITH_DAO_COALESCING
+    if(r->state.lifetime == 1 && RPL_ROUTE_IS_NOPATH_RECEIVED(r) &&
+       RPL_ROUTE_IS_DAO_DELTA(r)) {
+      /* Kept until our parent acknowledges the No-Path for it, so that
+         the coalesced DAO carrying it can be sent again */
+      r = uip_ds6_route_next(r);
+      continue;
+    }
+#endif /* RPL_WITH_DAO_COALESCING */
     if(r->state.lifetime >= 1 && r->state.lifetime != RPL_ROUTE_INFINITE_LIFETIME) {
       /*
        * If a route is at lifetime == 1, set it to 0, scheduling it for
@@ -59,6 +59,8 @@ typedef uint16_t rpl_ocp_t;
 #define RPL_DAG_MC_LQL                  6 /* Link Quality Level */
 #define RPL_DAG_MC_ETX                  7 /* Expected Transmission Count */
 #define RPL_DAG_MC_LC                   8 /* Link Color */
+/* Not assigned by IANA: queue occupancy and TX duty cycle, see rpl-loadof.c */
+#define RPL_DAG_MC_LOAD                 129
 
 /* IANA Routing Metric/Constraint Common Header Flag field as defined in RFC6551 (bit indexes) */
 #define RPL_DAG_MC_FLAG_P               5
@@ -85,12 +87,20 @@ typedef uint16_t rpl_ocp_t;
 /* IANA Objective Code Point as defined in RFC6550 */
 #define RPL_OCP_OF0     0
 #define RPL_OCP_MRHOF   1
+/* Not assigned by IANA: load-aware OF, see rpl-loadof.c */
+#define RPL_OCP_LOADOF  0x80
 
 struct rpl_metric_object_energy {
   uint8_t flags;
   uint8_t energy_est;
 };
 
+/* Load of the most loaded node on the path, in percent */
+struct rpl_metric_object_load {
+  uint8_t queue; /* MAC queue occupancy */
+  uint8_t tx; /* Share of time spent transmitting */
+};
+
 /* Logical representation of a DAG Metric Container. */
 struct rpl_metric_container {
   uint8_t type;
@@ -101,6 +111,7 @@ struct rpl_metric_container {
   union metric_object {
     struct rpl_metric_object_energy energy;
     uint16_t etx;
+    struct rpl_metric_object_load load;
   } obj;
 };
 typedef struct rpl_metric_container rpl_metric_container_t;
@@ -262,6 +273,13 @@ struct rpl_instance {
 #if RPL_WITH_DAO_ACK
   struct ctimer dao_retransmit_timer;
 #endif /* RPL_WITH_DAO_ACK */
+#if RPL_WITH_DAO_COALESCING
+  /* Runs the coalescing window, then the DAO-ACK timeout of the last
+     coalesced DAO while it is not acknowledged */
+  struct ctimer dao_coalesce_timer;
+  uint8_t dao_coalesce_seqno;
+  uint8_t dao_coalesce_transmissions;
+#endif /* RPL_WITH_DAO_COALESCING */
 };
 
 /*---------------------------------------------------------------------------*/
@@ -76,9 +76,9 @@
 /*
  * The objective function (OF) used by a RPL root is configurable through
  * the RPL_CONF_OF_OCP parameter. This is defined as the objective code
- * point (OCP) of the OF, RPL_OCP_OF0 or RPL_OCP_MRHOF. This flag is of
- * no relevance to non-root nodes, which run the OF advertised in the
- * instance they join.
+ * point (OCP) of the OF, RPL_OCP_OF0, RPL_OCP_MRHOF or RPL_OCP_LOADOF.
+ * This flag is of no relevance to non-root nodes, which run the OF
+ * advertised in the instance they join.
  * Make sure the selected of is inRPL_SUPPORTED_OFS.
  */
 #ifdef RPL_CONF_OF_OCP
@@ -90,7 +90,8 @@
 /*
  * The set of objective functions supported at runtime. Nodes are only
  * able to join instances that advertise an OF in this set. To include
- * both OF0 and MRHOF, use {&rpl_of0, &rpl_mrhof}.
+ * both OF0 and MRHOF, use {&rpl_of0, &rpl_mrhof}. The load-aware OF,
+ * rpl_loadof, requires RPL_CONF_WITH_MC.
  */
 #ifdef RPL_CONF_SUPPORTED_OFS
 #define RPL_SUPPORTED_OFS RPL_CONF_SUPPORTED_OFS
@@ -119,6 +120,42 @@
 #define RPL_DAG_MC RPL_DAG_MC_NONE
 #endif /* RPL_CONF_DAG_MC */
 
+/*
+ * The number of DODAGs a node keeps track of. RPL-lite is part of a
+ * single DODAG at a time. With more than one, the roots advertise their
+ * load (the number of nodes they have a route to) in a DAG metric
+ * container, which is relayed down the DODAG, and nodes move to the
+ * least loaded DODAG they hear of.
+ *
+ * The root load is sent in every DIO, in a DAG metric container of type
+ * RPL_DAG_MC_ROOT_LOAD (128), which is not assigned by IANA. Nodes built
+ * with RPL_MAX_INSTANCES 1, and other RPL implementations, discard the
+ * whole DIO when they receive it. Enabling this is therefore opt-in: do
+ * so on all nodes of the network, or on none.
+ * */
+#ifdef RPL_CONF_MAX_INSTANCES
+#define RPL_MAX_INSTANCES RPL_CONF_MAX_INSTANCES
+#else /* RPL_CONF_MAX_INSTANCES */
+#define RPL_MAX_INSTANCES 1
+#endif /* RPL_CONF_MAX_INSTANCES */
+
+/* How much less loaded than ours another root must be before we move to
+ * its DODAG */
+#ifdef RPL_CONF_ROOT_LOAD_THRESHOLD
+#define RPL_ROOT_LOAD_THRESHOLD RPL_CONF_ROOT_LOAD_THRESHOLD
+#else /* RPL_CONF_ROOT_LOAD_THRESHOLD */
+#define RPL_ROOT_LOAD_THRESHOLD 4
+#endif /* RPL_CONF_ROOT_LOAD_THRESHOLD */
+
+/* The minimum time, in seconds, spent in a DODAG before moving to a less
+ * loaded one. A random delay of up to the same duration is added, so
+ * that nodes do not all move at once. */
+#ifdef RPL_CONF_ROOT_LOAD_DWELL
+#define RPL_ROOT_LOAD_DWELL RPL_CONF_ROOT_LOAD_DWELL
+#else /* RPL_CONF_ROOT_LOAD_DWELL */
+#define RPL_ROOT_LOAD_DWELL 300
+#endif /* RPL_CONF_ROOT_LOAD_DWELL */
+
 /*
  * RPL DAO-ACK support. When enabled, DAO-ACK will be sent and requested.
  * This will also enable retransmission of DAO when no ack is received.
@@ -129,6 +166,26 @@
 #define RPL_WITH_DAO_ACK 1
 #endif /* RPL_CONF_WITH_DAO_ACK */
 
+/*
+ * RPL DAO aggregation. When enabled, a node advertises in one DAO all
+ * its addresses in the DAG prefix, and the targets it was given with
+ * rpl_icmp6_dao_add_target() (e.g. RPL-unaware leaves attached to it).
+ * The root applies the targets of each transit option in a batch.
+ * */
+#ifdef RPL_CONF_WITH_DAO_AGGREGATION
+#define RPL_WITH_DAO_AGGREGATION RPL_CONF_WITH_DAO_AGGREGATION
+#else
+#define RPL_WITH_DAO_AGGREGATION 0
+#endif /* RPL_CONF_WITH_DAO_AGGREGATION */
+
+/* The maximum number of targets in a DAO, sent or received, and of
+ * targets added with rpl_icmp6_dao_add_target() */
+#ifdef RPL_CONF_DAO_MAX_TARGETS
+#define RPL_DAO_MAX_TARGETS RPL_CONF_DAO_MAX_TARGETS
+#else
+#define RPL_DAO_MAX_TARGETS 4
+#endif /* RPL_CONF_DAO_MAX_TARGETS */
+
 /*
  * Setting the RPL_TRICKLE_REFRESH_DAO_ROUTES will make the RPL root
  * increase the DTSN (Destination Advertisement Trigger Sequence Number)
@@ -147,6 +204,20 @@
 #endif
 #endif /* RPL_CONF_TRICKLE_REFRESH_DAO_ROUTES */
 
+/*
+ * RPL parent cache. When enabled, the best parent candidate and the rank
+ * via each neighbor are cached, and a state update only re-evaluates the
+ * neighbor that changed since the last one (after a DIO or a
+ * transmission). The whole neighbor table is scanned again when several
+ * neighbors changed, when a neighbor is removed, when the current best
+ * got worse, and at every periodic timer.
+ * */
+#ifdef RPL_CONF_WITH_PARENT_CACHE
+#define RPL_WITH_PARENT_CACHE RPL_CONF_WITH_PARENT_CACHE
+#else
+#define RPL_WITH_PARENT_CACHE 0
+#endif /* RPL_CONF_WITH_PARENT_CACHE */
+
 /*
  * RPL probing. When enabled, probes will be sent periodically to keep
  * neighbor link estimates up to date. Further configurable
@@ -339,11 +410,11 @@
  * use 128 for RPL_MIN_HOPRANKINC, resulting in a rank equal to the
  * ETX path cost. Larger values may also be desirable, as discussed
  * in section 6.1 of RFC6719. */
-#if RPL_OF_OCP == RPL_OCP_MRHOF
+#if RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF
 #define RPL_MIN_HOPRANKINC          128
-#else /* RPL_OF_OCP == RPL_OCP_MRHOF */
+#else /* RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF */
 #define RPL_MIN_HOPRANKINC          256
-#endif /* RPL_OF_OCP == RPL_OCP_MRHOF */
+#endif /* RPL_OF_OCP == RPL_OCP_MRHOF || RPL_OF_OCP == RPL_OCP_LOADOF */
 #else /* RPL_CONF_MIN_HOPRANKINC */
 #define RPL_MIN_HOPRANKINC          RPL_CONF_MIN_HOPRANKINC
 #endif /* RPL_CONF_MIN_HOPRANKINC */
@@ -63,6 +63,13 @@
 #define RPL_DAG_MC_LQL                  6 /* Link Quality Level */
 #define RPL_DAG_MC_ETX                  7 /* Expected Transmission Count */
 #define RPL_DAG_MC_LC                   8 /* Link Color */
+/* Not assigned by IANA: load of the DODAG root, see RPL_MAX_INSTANCES */
+#define RPL_DAG_MC_ROOT_LOAD            128
+/* Not assigned by IANA: queue occupancy and TX duty cycle, see rpl-loadof.c */
+#define RPL_DAG_MC_LOAD                 129
+
+/* Special value indicating an unknown root load */
+#define RPL_ROOT_LOAD_UNKNOWN           0xFFFF
 
 /* IANA Routing Metric/Constraint Common Header Flag field as defined in RFC6551 (bit indexes) */
 #define RPL_DAG_MC_FLAG_P               5
@@ -89,6 +96,8 @@
 /* IANA Objective Code Point as defined in RFC6550 */
 #define RPL_OCP_OF0     0
 #define RPL_OCP_MRHOF   1
+/* Not assigned by IANA: load-aware OF, see rpl-loadof.c */
+#define RPL_OCP_LOADOF  0x80
 
 /*---------------------------------------------------------------------------*/
 /* RPL message types */
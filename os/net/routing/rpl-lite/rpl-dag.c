@@ -46,6 +46,7 @@
 #include "net/ipv6/uip-sr.h"
 #include "net/nbr-table.h"
 #include "net/link-stats.h"
+#include "lib/random.h"
 
 /* Log configuration */
 #include "sys/log.h"
@@ -53,7 +54,7 @@
 #define LOG_LEVEL LOG_LEVEL_RPL
 
 /*---------------------------------------------------------------------------*/
-extern rpl_of_t rpl_of0, rpl_mrhof;
+extern rpl_of_t rpl_of0, rpl_mrhof, rpl_loadof;
 static rpl_of_t * const objective_functions[] = RPL_SUPPORTED_OFS;
 static int init_dag_from_dio(rpl_dio_t *dio);
 
@@ -61,6 +62,21 @@ static int init_dag_from_dio(rpl_dio_t *dio);
 /* Allocate instance table. */
 rpl_instance_t curr_instance;
 
+#if RPL_MAX_INSTANCES > 1
+/* A DODAG we heard DIOs from, and the load of its root */
+struct dag_candidate {
+  uip_ipaddr_t dag_id;
+  unsigned long expires; /* In seconds, 0 if unused */
+  uint16_t root_load;
+  uint8_t instance_id;
+};
+static struct dag_candidate candidates[RPL_MAX_INSTANCES];
+/* When we may move to a less loaded DODAG, in seconds */
+static unsigned long switch_time;
+
+static void check_root_load(void);
+#endif /* RPL_MAX_INSTANCES > 1 */
+
 /*---------------------------------------------------------------------------*/
 
 #ifdef RPL_VALIDATE_DIO_FUNC
@@ -151,6 +167,9 @@ rpl_dag_periodic(unsigned seconds)
         rpl_icmp6_dis_output(rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent));
       }
     }
+#if RPL_MAX_INSTANCES > 1
+    check_root_load();
+#endif /* RPL_MAX_INSTANCES > 1 */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -294,7 +313,7 @@ rpl_dag_update_state(void)
     /* Update better_parent_since flag for each neighbor */
     nbr = nbr_table_head(rpl_neighbors);
     while(nbr != NULL) {
-      if(rpl_neighbor_rank_via_nbr(nbr) < curr_instance.dag.rank) {
+      if(rpl_neighbor_cached_rank_via_nbr(nbr) < curr_instance.dag.rank) {
         /* This neighbor would be a better parent than our current.
         Set 'better_parent_since' if not already set. */
         if(nbr->better_parent_since == 0) {
@@ -388,6 +407,7 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 #if RPL_WITH_MC
   memcpy(&nbr->mc, &dio->mc, sizeof(nbr->mc));
 #endif /* RPL_WITH_MC */
+  rpl_neighbor_mark_changed(nbr);
 
   return nbr;
 }
@@ -587,12 +607,158 @@ process_dio_init_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
   LOG_WARN("just joined, no parent yet, setting timer for leaving\n");
   rpl_timers_schedule_leaving();
 
+#if RPL_MAX_INSTANCES > 1
+  switch_time = clock_seconds() + RPL_ROOT_LOAD_DWELL +
+    random_rand() % (RPL_ROOT_LOAD_DWELL + 1);
+#endif /* RPL_MAX_INSTANCES > 1 */
+
   return 1;
 }
+#if RPL_MAX_INSTANCES > 1
+/*---------------------------------------------------------------------------*/
+static struct dag_candidate *
+get_candidate(uint8_t instance_id, const uip_ipaddr_t *dag_id)
+{
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(candidates[i].expires > clock_seconds()
+       && candidates[i].instance_id == instance_id
+       && uip_ipaddr_cmp(&candidates[i].dag_id, dag_id)) {
+      return &candidates[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct dag_candidate *
+least_loaded_candidate(void)
+{
+  struct dag_candidate *best = NULL;
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(candidates[i].expires > clock_seconds()
+       && (best == NULL || candidates[i].root_load < best->root_load)) {
+      best = &candidates[i];
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_candidate(uip_ipaddr_t *from, rpl_dio_t *dio)
+{
+  struct dag_candidate *c;
+  struct dag_candidate *curr;
+  rpl_nbr_t *parent;
+  int i;
+
+  if(dio->rank == RPL_INFINITE_RANK || dio->root_load == RPL_ROOT_LOAD_UNKNOWN) {
+    return;
+  }
+
+  if(curr_instance.used
+     && curr_instance.instance_id == dio->instance_id
+     && uip_ipaddr_cmp(&curr_instance.dag.dag_id, &dio->dag_id)) {
+    /* In our DODAG, only nodes closer to the root have the load of the
+       root, nodes below us may repeat an older one */
+    parent = curr_instance.dag.preferred_parent;
+    if(dio->rank >= curr_instance.dag.rank
+       && (parent == NULL || rpl_neighbor_get_from_ipaddr(from) != parent)) {
+      return;
+    }
+  }
+
+  c = get_candidate(dio->instance_id, &dio->dag_id);
+  if(c == NULL) {
+    /* Replace the entry that expires first, except for our DODAG */
+    curr = curr_instance.used ?
+      get_candidate(curr_instance.instance_id, &curr_instance.dag.dag_id) : NULL;
+    for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+      if(&candidates[i] != curr
+         && (c == NULL || candidates[i].expires < c->expires)) {
+        c = &candidates[i];
+      }
+    }
+    c->instance_id = dio->instance_id;
+    uip_ipaddr_copy(&c->dag_id, &dio->dag_id);
+  }
+
+  c->root_load = dio->root_load;
+  /* Forget the DODAG after two maximum DIO intervals without news */
+  c->expires = clock_seconds() + 1 +
+    ((2UL << MIN(dio->dag_intmin + dio->dag_intdoubl, 24)) / 1000);
+}
+/*---------------------------------------------------------------------------*/
+/* Tells whether we should join the DODAG of a DIO, i.e. if no DODAG we
+   know of is significantly less loaded */
+static int
+is_least_loaded(rpl_dio_t *dio)
+{
+  struct dag_candidate *best = least_loaded_candidate();
+
+  return best == NULL
+    || (uint32_t)best->root_load + RPL_ROOT_LOAD_THRESHOLD >= dio->root_load
+    || (best->instance_id == dio->instance_id
+        && uip_ipaddr_cmp(&best->dag_id, &dio->dag_id));
+}
+/*---------------------------------------------------------------------------*/
+/* Poisons our DODAG and leaves it if another root is significantly less
+   loaded, after which we will join the DODAG of that root */
+static void
+check_root_load(void)
+{
+  struct dag_candidate *best;
+  uint16_t load;
+
+  if(rpl_dag_root_is_root()
+     || (curr_instance.dag.state != DAG_JOINED && curr_instance.dag.state != DAG_REACHABLE)
+     || clock_seconds() < switch_time) {
+    return;
+  }
+
+  load = rpl_dag_get_root_load();
+  if(load == RPL_ROOT_LOAD_UNKNOWN) {
+    /* No recent DIO with the load of our root, nothing to compare */
+    return;
+  }
+  best = least_loaded_candidate();
+  if(best != NULL && (uint32_t)best->root_load + RPL_ROOT_LOAD_THRESHOLD < load) {
+    LOG_WARN("root load %u, DAG ", load);
+    LOG_WARN_6ADDR(&best->dag_id);
+    LOG_WARN_(" has %u, poison and leave\n", best->root_load);
+    rpl_dag_poison_and_leave();
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+rpl_dag_get_root_load(void)
+{
+  struct dag_candidate *c;
+
+  if(rpl_dag_root_is_root()) {
+    /* The number of nodes we have a route to */
+    return MIN(uip_sr_num_nodes(), RPL_ROOT_LOAD_UNKNOWN - 1);
+  }
+  c = get_candidate(curr_instance.instance_id, &curr_instance.dag.dag_id);
+  return c != NULL ? c->root_load : RPL_ROOT_LOAD_UNKNOWN;
+}
+#endif /* RPL_MAX_INSTANCES > 1 */
 /*---------------------------------------------------------------------------*/
 void
 rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 {
+#if RPL_MAX_INSTANCES > 1
+  if(!rpl_dag_root_is_root()) {
+    update_candidate(from, dio);
+    if(!curr_instance.used && !is_least_loaded(dio)) {
+      LOG_INFO("ignoring DIO, a less loaded DAG is known\n");
+      return;
+    }
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+
   if(!curr_instance.used && !rpl_dag_root_is_root()) {
     /* Attempt to init our DAG from this DIO */
     if(!process_dio_init_dag(from, dio)) {
@@ -623,9 +789,48 @@ rpl_process_dis(uip_ipaddr_t *from, int is_multicast)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_AGGREGATION
+/* Applies the targets of a DAO, those of each transit in a batch.
+   Returns 0 if there was none to apply, or if they did not all fit. */
+static int
+process_dao_targets(rpl_dao_t *dao)
+{
+  const struct rpl_dao_transit *transit;
+  uint8_t first = 0;
+  uint8_t count;
+  uint8_t i, t;
+
+  if(dao->transit_count == 0) {
+    LOG_WARN("no target applies in incoming DAO\n");
+    return 0;
+  }
+  for(t = 0; t < dao->transit_count; t++) {
+    transit = &dao->transits[t];
+    count = transit->targets_end - first;
+    if(transit->lifetime == 0) {
+      for(i = first; i < transit->targets_end; i++) {
+        uip_sr_expire_parent(NULL, &dao->targets[i], &transit->parent_addr);
+      }
+    } else if(uip_sr_update_nodes(NULL, &dao->targets[first], count,
+                                  &transit->parent_addr,
+                                  RPL_LIFETIME(transit->lifetime)) < count) {
+      return 0;
+    }
+    first = transit->targets_end;
+  }
+  return 1;
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
 void
 rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
 {
+#if RPL_WITH_DAO_AGGREGATION
+  if(!process_dao_targets(dao)) {
+    LOG_ERR("failed to add links on incoming DAO\n");
+    return;
+  }
+#else /* RPL_WITH_DAO_AGGREGATION */
   if(dao->lifetime == 0) {
     uip_sr_expire_parent(NULL, from, &dao->parent_addr);
   } else {
@@ -634,6 +839,7 @@ rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
       return;
     }
   }
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
 #if RPL_WITH_DAO_ACK
   if(dao->flags & RPL_DAO_K_FLAG) {
@@ -692,6 +898,7 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
      * the sender's rank from ext header */
     if(sender != NULL) {
       sender->rank = sender_rank;
+      rpl_neighbor_mark_changed(sender);
       /* Select DAG and preferred parent. In case of a parent switch,
       the new parent will be used to forward the current packet. */
       rpl_dag_update_state();
@@ -83,6 +83,15 @@ void rpl_dag_leave(void);
 */
 void rpl_dag_periodic(unsigned seconds);
 
+#if RPL_MAX_INSTANCES > 1
+/**
+ * Returns the load of the root of our DODAG, as advertised in our DIOs
+ *
+ * \return The root load, RPL_ROOT_LOAD_UNKNOWN if unknown
+*/
+uint16_t rpl_dag_get_root_load(void);
+#endif /* RPL_MAX_INSTANCES > 1 */
+
 /**
  * Triggers a RPL global repair
  *
@@ -78,6 +78,12 @@ static void dao_ack_input(void);
 UIP_ICMP6_HANDLER(dao_ack_handler, ICMP6_RPL, RPL_CODE_DAO_ACK, dao_ack_input);
 #endif /* RPL_WITH_DAO_ACK */
 
+#if RPL_WITH_DAO_AGGREGATION
+/* Targets we advertise on behalf of other nodes */
+static uip_ipaddr_t dao_targets[RPL_DAO_MAX_TARGETS];
+static uint8_t dao_target_count;
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
 /*---------------------------------------------------------------------------*/
 static uint32_t
 get32(uint8_t *buffer, int pos)
@@ -190,6 +196,9 @@ dio_input(void)
   dio.ocp = RPL_OF_OCP;
   dio.default_lifetime = RPL_DEFAULT_LIFETIME;
   dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+#if RPL_MAX_INSTANCES > 1
+  dio.root_load = RPL_ROOT_LOAD_UNKNOWN;
+#endif /* RPL_MAX_INSTANCES > 1 */
 
   uip_ipaddr_copy(&from, &UIP_IP_BUF->srcipaddr);
 
@@ -236,6 +245,17 @@ dio_input(void)
           LOG_WARN("dio_input: invalid DAG MC, len %u, discard\n", len);
           goto discard;
         }
+#if RPL_MAX_INSTANCES > 1
+        if(buffer[i + 2] == RPL_DAG_MC_ROOT_LOAD) {
+          /* Sent in its own container, next to the one of the OF */
+          if(len < 8) {
+            LOG_WARN("dio_input: invalid root load MC, len %u, discard\n", len);
+            goto discard;
+          }
+          dio.root_load = get16(buffer, i + 6);
+          break;
+        }
+#endif /* RPL_MAX_INSTANCES > 1 */
         dio.mc.type = buffer[i + 2];
         dio.mc.flags = buffer[i + 3] << 1;
         dio.mc.flags |= buffer[i + 4] >> 7;
@@ -250,6 +270,9 @@ dio_input(void)
         } else if(dio.mc.type == RPL_DAG_MC_ENERGY) {
           dio.mc.obj.energy.flags = buffer[i + 6];
           dio.mc.obj.energy.energy_est = buffer[i + 7];
+        } else if(dio.mc.type == RPL_DAG_MC_LOAD) {
+          dio.mc.obj.load.queue = buffer[i + 6];
+          dio.mc.obj.load.tx = buffer[i + 7];
         } else {
           LOG_WARN("dio_input: unsupported DAG MC type %u, discard\n", (unsigned)dio.mc.type);
           goto discard;
@@ -395,12 +418,26 @@ rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr)
         buffer[pos++] = 2;
         buffer[pos++] = curr_instance.mc.obj.energy.flags;
         buffer[pos++] = curr_instance.mc.obj.energy.energy_est;
+      } else if(curr_instance.mc.type == RPL_DAG_MC_LOAD) {
+        buffer[pos++] = 2;
+        buffer[pos++] = curr_instance.mc.obj.load.queue;
+        buffer[pos++] = curr_instance.mc.obj.load.tx;
       } else {
         LOG_ERR("unable to send DIO because of unsupported DAG MC type %u\n",
                (unsigned)curr_instance.mc.type);
         return;
       }
     }
+#if RPL_MAX_INSTANCES > 1
+    buffer[pos++] = RPL_OPTION_DAG_METRIC_CONTAINER;
+    buffer[pos++] = 6;
+    buffer[pos++] = RPL_DAG_MC_ROOT_LOAD;
+    buffer[pos++] = 0; /* flags */
+    buffer[pos++] = RPL_DAG_MC_AGGR_MAXIMUM << 4; /* no precedence */
+    buffer[pos++] = 2;
+    set16(buffer, pos, rpl_dag_get_root_load());
+    pos += 2;
+#endif /* RPL_MAX_INSTANCES > 1 */
   }
 
   /* Always add a DAG configuration option. */
@@ -451,6 +488,58 @@ rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr)
   uip_icmp6_send(addr, ICMP6_RPL, RPL_CODE_DIO, pos);
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_AGGREGATION
+static void
+dao_input_target(rpl_dao_t *dao)
+{
+  /* The root knows nodes by their interface identifier in the DAG prefix */
+  if(dao->prefixlen != 128 ||
+     !uip_ipaddr_prefixcmp(&dao->prefix, &curr_instance.dag.dag_id, 64)) {
+    LOG_WARN("dao_input: target ");
+    LOG_WARN_6ADDR(&dao->prefix);
+    LOG_WARN_(" not in the DAG prefix, ignore\n");
+    dao->targets_ignored = 1;
+    return;
+  }
+  if(dao->target_count >= RPL_DAO_MAX_TARGETS) {
+    LOG_WARN("dao_input: too many targets, ignore ");
+    LOG_WARN_6ADDR(&dao->prefix);
+    LOG_WARN_("\n");
+    dao->targets_ignored = 1;
+    return;
+  }
+  uip_ipaddr_copy(&dao->targets[dao->target_count++], &dao->prefix);
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_input_transit(rpl_dao_t *dao, const uip_ipaddr_t *from)
+{
+  struct rpl_dao_transit *transit;
+  uint8_t first;
+
+  first = dao->transit_count > 0 ? dao->transits[dao->transit_count - 1].targets_end : 0;
+  if(dao->targets_ignored) {
+    /* The targets before this transit were not all kept. If none was,
+       the transit applies to none, not to the sender. */
+    dao->targets_ignored = 0;
+    if(dao->target_count == first) {
+      return;
+    }
+  } else if(dao->target_count == first) {
+    /* No target before this transit, it applies to the sender */
+    if(dao->target_count >= RPL_DAO_MAX_TARGETS) {
+      return;
+    }
+    uip_ipaddr_copy(&dao->targets[dao->target_count++], from);
+  }
+
+  transit = &dao->transits[dao->transit_count++];
+  uip_ipaddr_copy(&transit->parent_addr, &dao->parent_addr);
+  transit->lifetime = dao->lifetime;
+  transit->targets_end = dao->target_count;
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
 static void
 dao_input(void)
 {
@@ -511,6 +600,9 @@ dao_input(void)
         dao.prefixlen = buffer[i + 3];
         memset(&dao.prefix, 0, sizeof(dao.prefix));
         memcpy(&dao.prefix, buffer + i + 4, (dao.prefixlen + 7) / CHAR_BIT);
+#if RPL_WITH_DAO_AGGREGATION
+        dao_input_target(&dao);
+#endif /* RPL_WITH_DAO_AGGREGATION */
         break;
       case RPL_OPTION_TRANSIT:
         /* The path sequence and control are ignored. */
@@ -520,6 +612,9 @@ dao_input(void)
         if(len >= 20) {
           memcpy(&dao.parent_addr, buffer + i + 6, 16);
         }
+#if RPL_WITH_DAO_AGGREGATION
+        dao_input_transit(&dao, &from);
+#endif /* RPL_WITH_DAO_AGGREGATION */
         break;
     }
   }
@@ -532,6 +627,10 @@ dao_input(void)
   LOG_INFO_(", prefix length %u, parent ", dao.prefixlen);
   LOG_INFO_6ADDR(&dao.parent_addr);
   LOG_INFO_(" \n");
+#if RPL_WITH_DAO_AGGREGATION
+  LOG_INFO("DAO with %u targets in %u transits\n",
+           dao.target_count, dao.transit_count);
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
   rpl_process_dao(&from, &dao);
 
@@ -539,14 +638,158 @@ dao_input(void)
     uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
+static int
+dao_output_target(unsigned char *buffer, int pos, const uip_ipaddr_t *prefix)
+{
+  uint8_t prefixlen = sizeof(*prefix) * CHAR_BIT;
+
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_output_transit(unsigned char *buffer, int pos, uint8_t lifetime,
+                   const uip_ipaddr_t *parent_ipaddr)
+{
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 20;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+
+  /* Include parent global IP address */
+  memcpy(buffer + pos, &curr_instance.dag.dag_id, 8); /* Prefix */
+  pos += 8;
+  memcpy(buffer + pos, ((const unsigned char *)parent_ipaddr) + 8, 8); /* Interface identifier */
+  pos += 8;
+  return pos;
+}
+#if RPL_WITH_DAO_AGGREGATION
+/*---------------------------------------------------------------------------*/
+int
+rpl_icmp6_dao_add_target(const uip_ipaddr_t *addr)
+{
+  uint8_t i;
+
+  /* The root knows nodes by their interface identifier in the DAG prefix */
+  if(!curr_instance.used ||
+     !uip_ipaddr_prefixcmp(addr, &curr_instance.dag.dag_id, 64)) {
+    LOG_WARN("rpl_icmp6_dao_add_target: not in the DAG prefix, ");
+    LOG_WARN_6ADDR(addr);
+    LOG_WARN_("\n");
+    return 0;
+  }
+  for(i = 0; i < dao_target_count; i++) {
+    if(uip_ipaddr_cmp(&dao_targets[i], addr)) {
+      return 1;
+    }
+  }
+  if(dao_target_count >= RPL_DAO_MAX_TARGETS) {
+    LOG_WARN("rpl_icmp6_dao_add_target: no space left for ");
+    LOG_WARN_6ADDR(addr);
+    LOG_WARN_("\n");
+    return 0;
+  }
+  uip_ipaddr_copy(&dao_targets[dao_target_count++], addr);
+  rpl_timers_schedule_dao();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Collects our addresses in the DAG prefix, one per interface identifier
+   as the root knows nodes by it. Returns how many were found. */
+static uint8_t
+dao_own_targets(const uip_ipaddr_t *targets[])
+{
+  const uip_ipaddr_t *ipaddr;
+  uint8_t count = 0;
+  uint8_t i, j;
+
+  for(i = 0; i < UIP_DS6_ADDR_NB && count < RPL_DAO_MAX_TARGETS; i++) {
+    ipaddr = &uip_ds6_if.addr_list[i].ipaddr;
+    if(!uip_ds6_if.addr_list[i].isused ||
+       uip_ds6_if.addr_list[i].state != ADDR_PREFERRED ||
+       !uip_ipaddr_prefixcmp(ipaddr, &curr_instance.dag.dag_id, 64)) {
+      continue;
+    }
+    for(j = 0; j < count && memcmp(&targets[j]->u8[8], &ipaddr->u8[8], 8); j++);
+    if(j == count) {
+      targets[count++] = ipaddr;
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a No-path DAO for a target we no longer advertise, so that the
+   root removes the route to it */
+static void
+dao_output_no_path_target(const uip_ipaddr_t *target)
+{
+  const uip_ipaddr_t *own_targets[RPL_DAO_MAX_TARGETS];
+  unsigned char *buffer;
+  int pos;
+
+  if(!curr_instance.used || curr_instance.dag.preferred_parent == NULL
+     || curr_instance.mop == RPL_MOP_NO_DOWNWARD_ROUTES) {
+    return;
+  }
+  if(dao_own_targets(own_targets) == 0) {
+    LOG_WARN("rpl_icmp6_dao_remove_target: no address in the DAG prefix, skip sending No-path DAO\n");
+    return;
+  }
+
+  RPL_LOLLIPOP_INCREMENT(curr_instance.dag.dao_curr_seqno);
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  buffer[pos++] = curr_instance.instance_id;
+  buffer[pos++] = 0; /* flags */
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = curr_instance.dag.dao_curr_seqno;
+  pos = dao_output_target(buffer, pos, target);
+  pos = dao_output_transit(buffer, pos, 0, own_targets[0]);
+
+  LOG_INFO("sending a No-path DAO seqno %u for target ",
+           curr_instance.dag.dao_curr_seqno);
+  LOG_INFO_6ADDR(target);
+  LOG_INFO_("\n");
+
+  uip_icmp6_send(&curr_instance.dag.dag_id, ICMP6_RPL, RPL_CODE_DAO, pos);
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_icmp6_dao_remove_target(const uip_ipaddr_t *addr)
+{
+  uint8_t i;
+
+  for(i = 0; i < dao_target_count; i++) {
+    if(uip_ipaddr_cmp(&dao_targets[i], addr)) {
+      uip_ipaddr_copy(&dao_targets[i], &dao_targets[--dao_target_count]);
+      dao_output_no_path_target(addr);
+      return;
+    }
+  }
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
 void
 rpl_icmp6_dao_output(uint8_t lifetime)
 {
   unsigned char *buffer;
-  uint8_t prefixlen;
   int pos;
   const uip_ipaddr_t *prefix = rpl_get_global_address();
   uip_ipaddr_t *parent_ipaddr = rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent);
+#if RPL_WITH_DAO_AGGREGATION
+  const uip_ipaddr_t *own_targets[RPL_DAO_MAX_TARGETS];
+  uint8_t own_count;
+  uint8_t i;
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
   /* Make sure we're up-to-date before sending data out */
   rpl_dag_update_state();
@@ -581,28 +824,35 @@ rpl_icmp6_dao_output(uint8_t lifetime)
   buffer[pos++] = 0; /* reserved */
   buffer[pos++] = curr_instance.dag.dao_curr_seqno;
 
+#if RPL_WITH_DAO_AGGREGATION
+  own_count = dao_own_targets(own_targets);
+  if(own_count == 0) {
+    /* The root would not know us by an address outside its prefix */
+    LOG_WARN("rpl_icmp6_dao_output: no address in the DAG prefix, skip sending DAO\n");
+    return;
+  }
+
+  /* The targets we advertise for other nodes, with us as parent. Come
+     first, so that a root considering only the last transit still gets
+     our own parent right. */
+  for(i = 0; i < dao_target_count && own_count + i < RPL_DAO_MAX_TARGETS; i++) {
+    pos = dao_output_target(buffer, pos, &dao_targets[i]);
+  }
+  if(i > 0) {
+    pos = dao_output_transit(buffer, pos, lifetime, own_targets[0]);
+  }
+
+  /* Our own targets, with our preferred parent */
+  for(i = 0; i < own_count; i++) {
+    pos = dao_output_target(buffer, pos, own_targets[i]);
+  }
+#else /* RPL_WITH_DAO_AGGREGATION */
   /* create target subopt */
-  prefixlen = sizeof(*prefix) * CHAR_BIT;
-  buffer[pos++] = RPL_OPTION_TARGET;
-  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = prefixlen;
-  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
-  pos += ((prefixlen + 7) / CHAR_BIT);
+  pos = dao_output_target(buffer, pos, prefix);
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
   /* Create a transit information sub-option. */
-  buffer[pos++] = RPL_OPTION_TRANSIT;
-  buffer[pos++] = 20;
-  buffer[pos++] = 0; /* flags - ignored */
-  buffer[pos++] = 0; /* path control - ignored */
-  buffer[pos++] = 0; /* path seq - ignored */
-  buffer[pos++] = lifetime;
-
-  /* Include parent global IP address */
-  memcpy(buffer + pos, &curr_instance.dag.dag_id, 8); /* Prefix */
-  pos += 8;
-  memcpy(buffer + pos, ((const unsigned char *)parent_ipaddr) + 8, 8); /* Interface identifier */
-  pos += 8;
+  pos = dao_output_transit(buffer, pos, lifetime, parent_ipaddr);
 
   LOG_INFO("sending a %sDAO seqno %u, tx count %u, lifetime %u, prefix ",
          lifetime == 0 ? "No-path " : "",
@@ -69,9 +69,21 @@ struct rpl_dio {
   rpl_prefix_t destination_prefix;
   rpl_prefix_t prefix_info;
   struct rpl_metric_container mc;
+#if RPL_MAX_INSTANCES > 1
+  uint16_t root_load;
+#endif /* RPL_MAX_INSTANCES > 1 */
 };
 typedef struct rpl_dio rpl_dio_t;
 
+#if RPL_WITH_DAO_AGGREGATION
+/* A transit information option of a DAO, and the targets it applies to */
+struct rpl_dao_transit {
+  uip_ipaddr_t parent_addr;
+  uint8_t lifetime;
+  uint8_t targets_end; /* Index in rpl_dao.targets after its last target */
+};
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
 /* Logical representation of a Destination Advertisement Object (DAO.) */
 struct rpl_dao {
   uip_ipaddr_t parent_addr;
@@ -81,6 +93,13 @@ struct rpl_dao {
   uint8_t lifetime;
   uint8_t prefixlen;
   uint8_t flags;
+#if RPL_WITH_DAO_AGGREGATION
+  uint8_t target_count;
+  uint8_t transit_count;
+  uint8_t targets_ignored; /* Targets ignored since the last transit */
+  uip_ipaddr_t targets[RPL_DAO_MAX_TARGETS];
+  struct rpl_dao_transit transits[RPL_DAO_MAX_TARGETS];
+#endif /* RPL_WITH_DAO_AGGREGATION */
 };
 typedef struct rpl_dao rpl_dao_t;
 
@@ -115,11 +134,35 @@ void rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr);
 /**
  * Creates an ICMPv6 DAO packet and sends it to the root, advertising the
  * current preferred parent, and with our global address as prefix.
+ * With RPL_WITH_DAO_AGGREGATION, all our addresses in the DAG prefix are
+ * advertised, and the targets added with rpl_icmp6_dao_add_target()
+ * with us as parent.
  *
  * \param lifetime The DAO lifetime. Use 0 to send a No-path DAO
 */
 void rpl_icmp6_dao_output(uint8_t lifetime);
 
+#if RPL_WITH_DAO_AGGREGATION
+/**
+ * Adds a target to advertise in our DAOs, with us as parent, e.g. a
+ * RPL-unaware leaf attached to us. Its address must be in the prefix
+ * of the DAG we are part of. Schedules a DAO.
+ *
+ * \param addr The IPv6 address of the target
+ * \return 1 if the target was added or already there, 0 if it is not
+ * in the DAG prefix or there was no space left
+*/
+int rpl_icmp6_dao_add_target(const uip_ipaddr_t *addr);
+
+/**
+ * Stops advertising a target added with rpl_icmp6_dao_add_target(),
+ * and sends a No-path DAO for it so that the root removes its route.
+ *
+ * \param addr The IPv6 address of the target
+*/
+void rpl_icmp6_dao_remove_target(const uip_ipaddr_t *addr);
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
 /**
  * Creates an ICMPv6 DAO-ACK packet and sends it to the originator
  * of the ACK.
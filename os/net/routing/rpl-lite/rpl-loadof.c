@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup rpl-lite
+ * @{
+ *
+ * \file
+ *         A load-aware objective function.
+ *
+ *         The rank is computed from the ETX, as with MRHOF. Parents are
+ *         however selected on a path cost that also accounts for the load
+ *         of the most loaded node on the path: the occupancy of its MAC
+ *         queue and the share of time it spends transmitting. Each node
+ *         advertises the load of its path in a DAG metric container,
+ *         aggregated as a maximum. Keeping the load out of the rank
+ *         avoids propagating its fluctuations down the DODAG.
+ *
+ *         Requires RPL_CONF_WITH_MC. The TX duty cycle is measured with
+ *         energest, and taken as zero unless ENERGEST_CONF_ON is set.
+ */
+
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/nbr-table.h"
+#include "net/link-stats.h"
+#include "net/queuebuf.h"
+#include "sys/energest.h"
+#if MAC_CONF_WITH_TSCH
+#include "net/mac/tsch/tsch.h"
+#elif MAC_CONF_WITH_CSMA
+#include "net/mac/csma/csma-output.h"
+#endif /* MAC_CONF_WITH_TSCH */
+
+#include <string.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "RPL"
+#define LOG_LEVEL LOG_LEVEL_RPL
+
+#if RPL_WITH_MC
+
+/* Reject parents that have a higher link metric than the following. */
+#ifdef RPL_LOADOF_CONF_MAX_LINK_METRIC
+#define MAX_LINK_METRIC     RPL_LOADOF_CONF_MAX_LINK_METRIC
+#else /* RPL_LOADOF_CONF_MAX_LINK_METRIC */
+#define MAX_LINK_METRIC     512 /* Eq ETX of 4 */
+#endif /* RPL_LOADOF_CONF_MAX_LINK_METRIC */
+
+/* Reject parents that have a higher path cost than the following. */
+#define MAX_PATH_COST      32768   /* Eq path ETX of 256 */
+
+/* The path cost added for a fully loaded path. With 512, a path through
+ * a node with a full queue costs as much as four more perfect hops. */
+#ifdef RPL_LOADOF_CONF_LOAD_WEIGHT
+#define LOAD_WEIGHT         RPL_LOADOF_CONF_LOAD_WEIGHT
+#else /* RPL_LOADOF_CONF_LOAD_WEIGHT */
+#define LOAD_WEIGHT         512 /* Eq ETX of 4 */
+#endif /* RPL_LOADOF_CONF_LOAD_WEIGHT */
+
+/* Hysteresis: the path cost must differ more than COST_THRESHOLD in order
+ * to switch preferred parent, as in MRHOF. */
+#ifdef RPL_LOADOF_CONF_COST_THRESHOLD
+#define COST_THRESHOLD      RPL_LOADOF_CONF_COST_THRESHOLD
+#else /* RPL_LOADOF_CONF_COST_THRESHOLD */
+#define COST_THRESHOLD      192 /* Eq ETX of 1.5 */
+#endif /* RPL_LOADOF_CONF_COST_THRESHOLD */
+
+/* Additional, custom hysteresis based on time, as in MRHOF. */
+#define TIME_THRESHOLD (10 * 60 * CLOCK_SECOND)
+
+/* How often our own load is measured. Each measurement is smoothed with
+ * an EWMA of weight 1/4, so that a short burst of traffic does not
+ * change the parent of the nodes below us. */
+#ifdef RPL_LOADOF_CONF_SAMPLE_INTERVAL
+#define SAMPLE_INTERVAL     RPL_LOADOF_CONF_SAMPLE_INTERVAL
+#else /* RPL_LOADOF_CONF_SAMPLE_INTERVAL */
+#define SAMPLE_INTERVAL     (10 * CLOCK_SECOND)
+#endif /* RPL_LOADOF_CONF_SAMPLE_INTERVAL */
+
+static struct rpl_metric_object_load own_load;
+static struct timer sample_timer;
+static uint64_t last_tx_time;
+static uint64_t last_total_time;
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+queue_occupancy(void)
+{
+#if MAC_CONF_WITH_TSCH
+  return MIN(tsch_queue_global_packet_count() * 100 / QUEUEBUF_NUM, 100);
+#elif MAC_CONF_WITH_CSMA
+  return csma_output_queue_occupancy();
+#else /* MAC_CONF_WITH_TSCH */
+  return 0;
+#endif /* MAC_CONF_WITH_TSCH */
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_own_load(void)
+{
+  uint64_t tx_time;
+  uint64_t total_time;
+  uint8_t tx = 0;
+
+  if(!timer_expired(&sample_timer)) {
+    return;
+  }
+  timer_set(&sample_timer, SAMPLE_INTERVAL);
+
+  energest_flush();
+  tx_time = energest_type_time(ENERGEST_TYPE_TRANSMIT);
+  total_time = ENERGEST_GET_TOTAL_TIME();
+  if(total_time > last_total_time) {
+    tx = MIN((tx_time - last_tx_time) * 100 / (total_time - last_total_time), 100);
+  }
+  last_tx_time = tx_time;
+  last_total_time = total_time;
+
+  own_load.queue = ((uint16_t)own_load.queue * 3 + queue_occupancy()) / 4;
+  own_load.tx = ((uint16_t)own_load.tx * 3 + tx) / 4;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(void)
+{
+  LOG_INFO("reset LoadOF\n");
+  memset(&own_load, 0, sizeof(own_load));
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+nbr_link_metric(rpl_nbr_t *nbr)
+{
+  const struct link_stats *stats = rpl_neighbor_get_link_stats(nbr);
+  return stats != NULL ? stats->etx : 0xffff;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+nbr_etx_cost(rpl_nbr_t *nbr)
+{
+  /* path cost upper bound: 0xffff */
+  return MIN((uint32_t)nbr->rank + nbr_link_metric(nbr), 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+nbr_path_cost(rpl_nbr_t *nbr)
+{
+  uint8_t load = 0;
+
+  if(nbr == NULL) {
+    return 0xffff;
+  }
+
+  if(curr_instance.mc.type == RPL_DAG_MC_LOAD) {
+    load = MAX(nbr->mc.obj.load.queue, nbr->mc.obj.load.tx);
+  }
+
+  return MIN((uint32_t)nbr_etx_cost(nbr) + (uint32_t)LOAD_WEIGHT * load / 100, 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_rank_t
+rank_via_nbr(rpl_nbr_t *nbr)
+{
+  uint16_t min_hoprankinc;
+
+  if(nbr == NULL) {
+    return RPL_INFINITE_RANK;
+  }
+
+  min_hoprankinc = curr_instance.min_hoprankinc;
+
+  /* Rank lower-bound: nbr rank + min_hoprankinc */
+  return MAX(MIN((uint32_t)nbr->rank + min_hoprankinc, RPL_INFINITE_RANK),
+             nbr_etx_cost(nbr));
+}
+/*---------------------------------------------------------------------------*/
+static int
+nbr_has_usable_link(rpl_nbr_t *nbr)
+{
+  uint16_t link_metric = nbr_link_metric(nbr);
+  /* Exclude links with too high link metrics  */
+  return link_metric <= MAX_LINK_METRIC;
+}
+/*---------------------------------------------------------------------------*/
+static int
+nbr_is_acceptable_parent(rpl_nbr_t *nbr)
+{
+  uint16_t path_cost = nbr_path_cost(nbr);
+  /* Exclude links with too high link metrics or path cost */
+  return nbr_has_usable_link(nbr) && path_cost <= MAX_PATH_COST;
+}
+/*---------------------------------------------------------------------------*/
+static int
+within_hysteresis(rpl_nbr_t *nbr)
+{
+  uint16_t path_cost = nbr_path_cost(nbr);
+  uint16_t parent_path_cost = nbr_path_cost(curr_instance.dag.preferred_parent);
+
+  int within_cost_hysteresis = path_cost + COST_THRESHOLD > parent_path_cost;
+  int within_time_hysteresis = nbr->better_parent_since == 0
+    || (clock_time() - nbr->better_parent_since) <= TIME_THRESHOLD;
+
+  return within_cost_hysteresis && within_time_hysteresis;
+}
+/*---------------------------------------------------------------------------*/
+static rpl_nbr_t *
+best_parent(rpl_nbr_t *nbr1, rpl_nbr_t *nbr2)
+{
+  int nbr1_is_acceptable;
+  int nbr2_is_acceptable;
+
+  nbr1_is_acceptable = nbr1 != NULL && nbr_is_acceptable_parent(nbr1);
+  nbr2_is_acceptable = nbr2 != NULL && nbr_is_acceptable_parent(nbr2);
+
+  if(!nbr1_is_acceptable) {
+    return nbr2_is_acceptable ? nbr2 : NULL;
+  }
+  if(!nbr2_is_acceptable) {
+    return nbr1_is_acceptable ? nbr1 : NULL;
+  }
+
+  /* Maintain stability of the preferred parent */
+  if(nbr1 == curr_instance.dag.preferred_parent && within_hysteresis(nbr2)) {
+    return nbr1;
+  }
+  if(nbr2 == curr_instance.dag.preferred_parent && within_hysteresis(nbr1)) {
+    return nbr2;
+  }
+
+  return nbr_path_cost(nbr1) < nbr_path_cost(nbr2) ? nbr1 : nbr2;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_metric_container(void)
+{
+  rpl_nbr_t *parent;
+  struct rpl_metric_object_load load;
+
+  if(!curr_instance.used) {
+    LOG_WARN("cannot update the metric container when not joined\n");
+    return;
+  }
+
+  update_own_load();
+  load = own_load;
+
+  if(curr_instance.dag.rank == ROOT_RANK) {
+    /* Configure MC at root only, other nodes are auto-configured when joining */
+    curr_instance.mc.type = RPL_DAG_MC_LOAD;
+    curr_instance.mc.flags = 0;
+    curr_instance.mc.aggr = RPL_DAG_MC_AGGR_MAXIMUM;
+    curr_instance.mc.prec = 0;
+  } else if(curr_instance.mc.type == RPL_DAG_MC_LOAD) {
+    /* The load of the path is that of its most loaded node */
+    parent = curr_instance.dag.preferred_parent;
+    if(parent != NULL) {
+      load.queue = MAX(load.queue, parent->mc.obj.load.queue);
+      load.tx = MAX(load.tx, parent->mc.obj.load.tx);
+    }
+  } else {
+    LOG_WARN("LoadOF, non-supported MC %u\n", curr_instance.mc.type);
+    return;
+  }
+
+  curr_instance.mc.length = sizeof(curr_instance.mc.obj.load);
+  curr_instance.mc.obj.load = load;
+}
+/*---------------------------------------------------------------------------*/
+rpl_of_t rpl_loadof = {
+  reset,
+  nbr_link_metric,
+  nbr_has_usable_link,
+  nbr_is_acceptable_parent,
+  nbr_path_cost,
+  rank_via_nbr,
+  best_parent,
+  update_metric_container,
+  RPL_OCP_LOADOF
+};
+
+#endif /* RPL_WITH_MC */
+
+/** @}*/
@@ -64,6 +64,21 @@ static rpl_nbr_t * best_parent(int fresh_only);
 /* Per-neighbor RPL information */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
 
+#if RPL_WITH_PARENT_CACHE
+uint32_t rpl_neighbor_full_selections;
+uint32_t rpl_neighbor_incremental_selections;
+
+/* The best parent candidate as of the last selection, and its path cost */
+static rpl_nbr_t *cached_best;
+static uint16_t cached_best_path_cost;
+/* The maximum acceptable rank the candidates were filtered with */
+static rpl_rank_t cached_max_rank;
+/* The only neighbor that changed since the last selection, if any */
+static rpl_nbr_t *changed_nbr;
+/* Set if all neighbors must be evaluated at the next selection */
+static uint8_t all_changed = 1;
+#endif /* RPL_WITH_PARENT_CACHE */
+
 /*---------------------------------------------------------------------------*/
 static int
 max_acceptable_rank(void)
@@ -160,6 +175,11 @@ rpl_neighbor_print_list(const char *str)
       LOG_INFO("nbr: %s\n", buf);
       nbr = nbr_table_next(rpl_neighbors, nbr);
     }
+#if RPL_WITH_PARENT_CACHE
+    LOG_INFO("nbr: parent selections: %lu full, %lu incremental\n",
+        (unsigned long)rpl_neighbor_full_selections,
+        (unsigned long)rpl_neighbor_incremental_selections);
+#endif /* RPL_WITH_PARENT_CACHE */
     LOG_INFO("nbr: end of list\n");
   }
 }
@@ -202,6 +222,15 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+#if RPL_WITH_PARENT_CACHE
+  if(nbr == cached_best) {
+    cached_best = NULL;
+  }
+  if(nbr == changed_nbr) {
+    changed_nbr = NULL;
+  }
+  all_changed = 1;
+#endif /* RPL_WITH_PARENT_CACHE */
   nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
@@ -344,6 +373,32 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_candidate(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    /* Exclude neighbors with a rank that is not acceptable) */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  {
+  uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
@@ -356,33 +411,82 @@ best_parent(int fresh_only)
 
   /* Search for the best parent according to the OF */
   for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
-
-    if(!acceptable_rank(nbr->rank) || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable) */
-      continue;
+    if(is_candidate(nbr, fresh_only)) {
+      /* Now we have an acceptable parent, check if it is the new best */
+      best = curr_instance.of->best_parent(best, nbr);
     }
+  }
 
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
-      continue;
-    }
+  return best;
+}
+#if RPL_WITH_PARENT_CACHE
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_mark_changed(rpl_nbr_t *nbr)
+{
+  if(changed_nbr != NULL && changed_nbr != nbr) {
+    /* More than one neighbor changed, evaluate them all */
+    all_changed = 1;
+  }
+  changed_nbr = nbr;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_mark_all_changed(void)
+{
+  all_changed = 1;
+}
+/*---------------------------------------------------------------------------*/
+rpl_rank_t
+rpl_neighbor_cached_rank_via_nbr(rpl_nbr_t *nbr)
+{
+  return nbr != NULL ? nbr->rank_via : RPL_INFINITE_RANK;
+}
+/*---------------------------------------------------------------------------*/
+/* Same as best_parent(0), re-evaluating only the neighbor that changed
+   since the last call when possible */
+static rpl_nbr_t *
+cached_best_parent(void)
+{
+  rpl_nbr_t *nbr;
 
-#if UIP_ND6_SEND_NS
-    {
-    uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
-      continue;
+  if(curr_instance.used == 0) {
+    return NULL;
+  }
+
+  if(!all_changed && cached_max_rank == max_acceptable_rank()
+     && (cached_best == NULL || is_candidate(cached_best, 0))) {
+    nbr = changed_nbr;
+    changed_nbr = NULL;
+    if(nbr == NULL) {
+      rpl_neighbor_incremental_selections++;
+      return cached_best;
     }
+    /* If our best got worse, another neighbor might be better now */
+    if(nbr != cached_best
+       || curr_instance.of->nbr_path_cost(nbr) <= cached_best_path_cost) {
+      nbr->rank_via = rpl_neighbor_rank_via_nbr(nbr);
+      if(nbr != cached_best && is_candidate(nbr, 0)) {
+        cached_best = curr_instance.of->best_parent(cached_best, nbr);
+      }
+      cached_best_path_cost = curr_instance.of->nbr_path_cost(cached_best);
+      rpl_neighbor_incremental_selections++;
+      return cached_best;
     }
-#endif /* UIP_ND6_SEND_NS */
-
-    /* Now we have an acceptable parent, check if it is the new best */
-    best = curr_instance.of->best_parent(best, nbr);
   }
 
-  return best;
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    nbr->rank_via = rpl_neighbor_rank_via_nbr(nbr);
+  }
+  cached_best = best_parent(0);
+  cached_best_path_cost = curr_instance.of->nbr_path_cost(cached_best);
+  cached_max_rank = max_acceptable_rank();
+  changed_nbr = NULL;
+  all_changed = 0;
+  rpl_neighbor_full_selections++;
+  return cached_best;
 }
+#endif /* RPL_WITH_PARENT_CACHE */
 /*---------------------------------------------------------------------------*/
 rpl_nbr_t *
 rpl_neighbor_select_best(void)
@@ -394,7 +498,11 @@ rpl_neighbor_select_best(void)
   }
 
   /* Look for best parent (regardless of freshness) */
+#if RPL_WITH_PARENT_CACHE
+  best = cached_best_parent();
+#else /* RPL_WITH_PARENT_CACHE */
   best = best_parent(0);
+#endif /* RPL_WITH_PARENT_CACHE */
 
 #if RPL_WITH_PROBING
   if(best != NULL) {
@@ -425,6 +533,9 @@ rpl_neighbor_select_best(void)
 
       /* Look for the best fresh parent. */
       best_fresh = best_parent(1);
+#if RPL_WITH_PARENT_CACHE
+      rpl_neighbor_full_selections++;
+#endif /* RPL_WITH_PARENT_CACHE */
       if(best_fresh == NULL) {
         if(curr_instance.dag.preferred_parent == NULL) {
           /* We will wait to find a fresh node before selecting our first parent */
@@ -192,6 +192,39 @@ void rpl_neighbor_remove_all(void);
 */
 rpl_nbr_t *rpl_neighbor_select_best(void);
 
+#if RPL_WITH_PARENT_CACHE
+/**
+ * Tells that the rank or the link of a neighbor has changed, so that the
+ * next parent selection re-evaluates it
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_mark_changed(rpl_nbr_t *nbr);
+
+/**
+ * Makes the next parent selection re-evaluate all neighbors
+*/
+void rpl_neighbor_mark_all_changed(void);
+
+/**
+ * Returns our rank if we select a given neighbor as preferred parent, as
+ * of the last parent selection
+ *
+ * \param nbr The neighbor
+ * \return The cached rank via nbr
+*/
+rpl_rank_t rpl_neighbor_cached_rank_via_nbr(rpl_nbr_t *nbr);
+
+/** The number of parent selections that scanned all neighbors */
+extern uint32_t rpl_neighbor_full_selections;
+/** The number of parent selections that re-evaluated only one neighbor */
+extern uint32_t rpl_neighbor_incremental_selections;
+#else /* RPL_WITH_PARENT_CACHE */
+#define rpl_neighbor_mark_changed(nbr)
+#define rpl_neighbor_mark_all_changed()
+#define rpl_neighbor_cached_rank_via_nbr(nbr) rpl_neighbor_rank_via_nbr(nbr)
+#endif /* RPL_WITH_PARENT_CACHE */
+
 /**
 * Print a textual description of RPL neighbor into a string
 *
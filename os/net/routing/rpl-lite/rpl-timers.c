@@ -517,6 +517,7 @@ handle_periodic_timer(void *ptr)
 
   /* Useful because part of the state update is time-dependent, e.g.,
   the meaning of last_advertised_rank changes with time */
+  rpl_neighbor_mark_all_changed();
   rpl_dag_update_state();
 
   if(LOG_INFO_ENABLED) {
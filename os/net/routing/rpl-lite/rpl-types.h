@@ -109,6 +109,12 @@ struct rpl_metric_object_energy {
   uint8_t energy_est;
 };
 
+/** \brief Load of the most loaded node on the path, in percent */
+struct rpl_metric_object_load {
+  uint8_t queue; /* MAC queue occupancy */
+  uint8_t tx; /* Share of time spent transmitting */
+};
+
 /** \brief Logical representation of a DAG Metric Container. */
 struct rpl_metric_container {
   uint8_t type;
@@ -119,6 +125,7 @@ struct rpl_metric_container {
   union metric_object {
    struct rpl_metric_object_energy energy;
    uint16_t etx;
+   struct rpl_metric_object_load load;
   } obj;
 };
 typedef struct rpl_metric_container rpl_metric_container_t;
@@ -141,6 +148,10 @@ struct rpl_nbr {
   rpl_metric_container_t mc;
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
+#if RPL_WITH_PARENT_CACHE
+  rpl_rank_t rank_via; /* Our rank via this neighbor, as of the last
+  parent selection */
+#endif /* RPL_WITH_PARENT_CACHE */
   uint8_t dtsn;
 };
 typedef struct rpl_nbr rpl_nbr_t;
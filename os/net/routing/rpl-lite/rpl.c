@@ -109,6 +109,7 @@ rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
       LOG_INFO("packet sent to ");
       LOG_INFO_LLADDR(addr);
       LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
+      rpl_neighbor_mark_changed(nbr);
       rpl_timers_schedule_state_update();
     }
   }
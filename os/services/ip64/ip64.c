@@ -269,42 +269,11 @@ ip64_set_ipv6_address(const uip_ip6addr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 static uint16_t
-chksum(uint16_t sum, const uint8_t *data, uint16_t len)
-{
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  while(dataptr < last_byte) {	/* At least two more bytes */
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-    dataptr += 2;
-  }
-
-  if(dataptr == last_byte) {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-  }
-
-  /* Return sum in host byte order. */
-  return sum;
-}
-/*---------------------------------------------------------------------------*/
-static uint16_t
 ipv4_checksum(struct ipv4_hdr *hdr)
 {
   uint16_t sum;
 
-  sum = chksum(0, (uint8_t *)hdr, IPV4_HDRLEN);
+  sum = uip_chksum_add(0, hdr, IPV4_HDRLEN);
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
@@ -323,14 +292,14 @@ ipv4_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
     /* IP protocol and length fields. This addition cannot carry. */
     sum = transport_layer_len + proto;
     /* Sum IP source and destination addresses. */
-    sum = chksum(sum, (uint8_t *)&v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
+    sum = uip_chksum_add(sum, &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
   } else {
     /* ping replies' checksums are calculated over the icmp-part only */
     sum = 0;
   }
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV4_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV4_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
@@ -349,15 +318,43 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   /* IP protocol and length fields. This addition cannot carry. */
   sum = transport_layer_len + proto;
   /* Sum IP source and destination addresses. */
-  sum = chksum(sum, (uint8_t *)&v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
-  sum = chksum(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, &v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, &v6hdr->destipaddr, sizeof(uip_ip6addr_t));
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV6_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV6_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+icmp6_pseudo_hdr_sum(const struct ipv6_hdr *v6hdr, uint16_t len)
+{
+  uint16_t sum;
+
+  /* IP protocol and length fields. This addition cannot carry. */
+  sum = len + IP_PROTO_ICMPV6;
+  /* Sum IP source and destination addresses. */
+  return uip_chksum_add(sum, &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t));
+}
+/*---------------------------------------------------------------------------*/
+/* The transport layer payload is copied without modification, so
+   unless it has been rewritten by DNS64, the TCP or UDP checksum only
+   has to be updated for the new pseudo-header addresses and the
+   translated port numbers (RFC 1624). */
+static uint16_t
+translate_transport_chksum(uint16_t chksum,
+                           const void *old_addrs, uint16_t old_addrs_len,
+                           const void *new_addrs, uint16_t new_addrs_len,
+                           const struct udp_hdr *old_hdr,
+                           const struct udp_hdr *new_hdr)
+{
+  chksum = uip_chksum_update(chksum, old_addrs, old_addrs_len,
+                             new_addrs, new_addrs_len);
+  chksum = uip_chksum_update16(chksum, old_hdr->srcport, new_hdr->srcport);
+  return uip_chksum_update16(chksum, old_hdr->destport, new_hdr->destport);
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
@@ -369,6 +366,7 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv6len, ipv4len;
+  uint8_t recompute_chksum = 0;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)ipv6packet;
@@ -424,15 +422,8 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   case IP_PROTO_TCP:
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
-
-    /* Compute and check the TCP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
-    if(ipv6_transport_checksum(ipv6packet, ipv6len,
-                               IP_PROTO_TCP) != 0xffff) {
-      PRINTF("Bad TCP checksum, dropping packet\n");
-    }
-
+    /* The checksum is updated incrementally below, so a segment with
+       a bad checksum still has a bad one after the translation. */
     break;
 
   case IP_PROTO_UDP:
@@ -446,11 +437,18 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
                       ipv6len - IPV6_HDRLEN - sizeof(struct udp_hdr),
                       (uint8_t *)udphdr + sizeof(struct udp_hdr),
                       BUFSIZE - IPV4_HDRLEN - sizeof(struct udp_hdr));
+      recompute_chksum = 1;
+    }
+    /* A zero checksum is not valid in IPv6, so there is nothing to
+       update incrementally. */
+    if(udphdr->udpchksum == 0) {
+      recompute_chksum = 1;
     }
     /* Compute and check the UDP checksum - since we're going to
        recompute it ourselves, we must ensure that it was correct in
        the first place. */
-    if(ipv6_transport_checksum(ipv6packet, ipv6len,
+    if(recompute_chksum &&
+       ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_UDP) != 0xffff) {
       PRINTF("Bad UDP checksum, dropping packet\n");
     }
@@ -619,22 +617,41 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
      field. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_chksum(tcphdr->tcpchksum,
+                                 &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                 &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                 (struct udp_hdr *)&ipv6packet[IPV6_HDRLEN],
+                                 udphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_UDP));
+    if(recompute_chksum) {
+      udphdr->udpchksum = 0;
+      udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
+                                                    IP_PROTO_UDP));
+    } else {
+      udphdr->udpchksum =
+        translate_transport_chksum(udphdr->udpchksum,
+                                   &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                   &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                   (struct udp_hdr *)&ipv6packet[IPV6_HDRLEN],
+                                   udphdr);
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
     break;
   case IP_PROTO_ICMPV4:
-    icmpv4hdr->icmpchksum = 0;
-    icmpv4hdr->icmpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						      IP_PROTO_ICMPV4));
+    /* ICMPv4 has no pseudo-header, so the ICMPv6 one is taken out of
+       the checksum along with the old message type. */
+    icmpv4hdr->icmpchksum =
+      uip_chksum_update16(icmpv4hdr->icmpchksum,
+                          uip_htons(icmp6_pseudo_hdr_sum(v6hdr, ipv6len - IPV6_HDRLEN)),
+                          0);
+    icmpv4hdr->icmpchksum =
+      uip_chksum_update16(icmpv4hdr->icmpchksum,
+                          UIP_HTONS(ICMP6_ECHO_REPLY << 8),
+                          UIP_HTONS(ICMP_ECHO_REPLY << 8));
     break;
 
   default:
@@ -658,6 +675,7 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv4len, ipv6len, ipv6_packet_len;
+  uint8_t recompute_chksum = 0;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)resultpacket;
@@ -741,7 +759,12 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
       v6hdr->len[0] = ipv6_packet_len >> 8;
       v6hdr->len[1] = ipv6_packet_len & 0xff;
       ipv6len = ipv6_packet_len + IPV6_HDRLEN;
-
+      recompute_chksum = 1;
+    }
+    /* A zero checksum means that the IPv4 sender did not compute one,
+       but IPv6 requires it. */
+    if(udphdr->udpchksum == 0) {
+      recompute_chksum = 1;
     }
     break;
 
@@ -854,28 +877,45 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_chksum(tcphdr->tcpchksum,
+                                 &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                 &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                 (struct udp_hdr *)&ipv4packet[IPV4_HDRLEN],
+                                 udphdr);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    /* As the udplen might have changed (DNS) we need to update it also */
-    udphdr->udplen = uip_htons(ipv6_packet_len);
-    udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_UDP));
+    if(recompute_chksum) {
+      udphdr->udpchksum = 0;
+      /* As the udplen might have changed (DNS) we need to update it also */
+      udphdr->udplen = uip_htons(ipv6_packet_len);
+      udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
+                                                    ipv6len,
+                                                    IP_PROTO_UDP));
+    } else {
+      udphdr->udpchksum =
+        translate_transport_chksum(udphdr->udpchksum,
+                                   &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                   &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                   (struct udp_hdr *)&ipv4packet[IPV4_HDRLEN],
+                                   udphdr);
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
     break;
 
   case IP_PROTO_ICMPV6:
-    icmpv6hdr->icmpchksum = 0;
-    icmpv6hdr->icmpchksum = ~(ipv6_transport_checksum(resultpacket,
-                                                ipv6len,
-                                                IP_PROTO_ICMPV6));
+    /* ICMPv6 covers a pseudo-header that ICMPv4 does not, so it is
+       added to the checksum along with the new message type. */
+    icmpv6hdr->icmpchksum =
+      uip_chksum_update16(icmpv6hdr->icmpchksum,
+                          0,
+                          uip_htons(icmp6_pseudo_hdr_sum(v6hdr, ipv6_packet_len)));
+    icmpv6hdr->icmpchksum =
+      uip_chksum_update16(icmpv6hdr->icmpchksum,
+                          UIP_HTONS(ICMP_ECHO << 8),
+                          UIP_HTONS(ICMP6_ECHO << 8));
     break;
   default:
     PRINTF("ip64_4to6: transport protocol %d not implemented\n", v4hdr->proto);
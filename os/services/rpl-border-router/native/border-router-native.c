@@ -57,8 +57,13 @@
 
 extern long slip_sent;
 extern long slip_received;
+extern long slip_frames_sent;
+extern long slip_frames_received;
+extern long slip_frames_dropped;
+extern long slip_reads;
 
 static uint8_t mac_set;
+static unsigned long start_seconds;
 
 extern int contiki_argc;
 extern char **contiki_argv;
@@ -94,8 +99,20 @@ border_router_set_mac(const uint8_t *data)
 void
 border_router_print_stat()
 {
+  unsigned long uptime = clock_seconds() - start_seconds;
+
   printf("bytes received over SLIP: %ld\n", slip_received);
   printf("bytes sent over SLIP: %ld\n", slip_sent);
+  printf("frames received over SLIP: %ld (%ld dropped)\n",
+         slip_frames_received, slip_frames_dropped);
+  printf("frames sent over SLIP: %ld\n", slip_frames_sent);
+  printf("SLIP reads: %ld (%ld bytes per read)\n", slip_reads,
+         slip_reads > 0 ? slip_received / slip_reads : 0);
+  if(uptime > 0) {
+    printf("SLIP throughput: %lu bytes/s in, %lu bytes/s out\n",
+           (unsigned long)slip_received / uptime,
+           (unsigned long)slip_sent / uptime);
+  }
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
@@ -104,6 +121,7 @@ PROCESS_THREAD(border_router_process, ev, data)
 
   PROCESS_BEGIN();
   prefix_set = 0;
+  start_seconds = clock_seconds();
 
   PROCESS_PAUSE();
 
@@ -70,13 +70,22 @@ extern speed_t slip_config_b_rate;
 #define SEND_DELAY 0
 #endif
 
-int devopen(const char *dev, int flags);
+/* Size of the chunks read from the serial line or slip server */
+#ifdef SLIP_DEV_CONF_READ_BUFSIZE
+#define SLIP_DEV_READ_BUFSIZE SLIP_DEV_CONF_READ_BUFSIZE
+#else
+#define SLIP_DEV_READ_BUFSIZE 1024
+#endif
 
-static FILE *inslip;
+int devopen(const char *dev, int flags);
 
 /* for statistics */
 long slip_sent = 0;
 long slip_received = 0;
+long slip_frames_sent = 0;
+long slip_frames_received = 0;
+long slip_frames_dropped = 0;
+long slip_reads = 0;
 
 int slipfd = 0;
 
@@ -168,123 +177,138 @@ slip_packet_input(unsigned char *data, int len)
   NETSTACK_MAC.input();
 }
 /*---------------------------------------------------------------------------*/
-/*
- * Read from serial, when we have a packet call slip_packet_input. No output
- * buffering, input buffered by stdio.
- */
-void
-serial_input(FILE *inslip)
+static void
+slip_frame_input(unsigned char *inbuf, int inbufptr)
 {
-  static unsigned char inbuf[2048];
-  static int inbufptr = 0;
-  int ret, i;
-  unsigned char c;
-
-#ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) {
-    err(1, "serial_input: read");
-  }
-  goto after_fread;
-#endif
+  int i;
 
-read_more:
-  if(inbufptr >= sizeof(inbuf)) {
-    fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
-    inbufptr = 0;
-  }
-  ret = fread(&c, 1, 1, inslip);
-#ifdef linux
-after_fread:
-#endif
-  if(ret == -1) {
-    err(1, "serial_input: read");
-  }
-  if(ret == 0) {
-    clearerr(inslip);
-    return;
-  }
-  slip_received++;
-  switch(c) {
-  case SLIP_END:
-    if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
-        command_context = CMD_CONTEXT_RADIO;
-        cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
+  if(inbuf[0] == '!') {
+    command_context = CMD_CONTEXT_RADIO;
+    cmd_input(inbuf, inbufptr);
+  } else if(inbuf[0] == '?') {
 #define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-        fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
-        if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
-        }
-      } else {
-        if(slip_config_verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if(slip_config_verbose > 4) {
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, inbufptr)) {
+    if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
+      fwrite(inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(slip_config_verbose > 2) {
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if(slip_config_verbose > 4) {
 #if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-            for(i = 0; i < inbufptr; i++) {
-              printf(" %02x", inbuf[i]);
-            }
+        printf("0000");
+        for(i = 0; i < inbufptr; i++) {
+          printf(" %02x", inbuf[i]);
+        }
 #else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
-              if((i & 3) == 3) {
-                printf(" ");
-              }
-              if((i & 15) == 15) {
-                printf("\n         ");
-              }
-            }
-#endif
-            printf("\n");
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) {
+            printf(" ");
+          }
+          if((i & 15) == 15) {
+            printf("\n         ");
           }
         }
-        slip_packet_input(inbuf, inbufptr);
+#endif
+        printf("\n");
       }
-      inbufptr = 0;
     }
-    break;
+    slip_frames_received++;
+    slip_packet_input(inbuf, inbufptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Read from serial, when we have a packet call slip_packet_input. Input is
+ * read in chunks of up to SLIP_DEV_READ_BUFSIZE bytes until the
+ * (non-blocking) file descriptor is drained, and each chunk is decoded in
+ * one pass, possibly completing several frames. The decoder state is kept
+ * across calls so frames and escape sequences may span chunks.
+ */
+void
+serial_input(void)
+{
+  static unsigned char inbuf[2048];
+  static int inbufptr = 0;
+  static uint8_t escaped = 0;
+  static unsigned char readbuf[SLIP_DEV_READ_BUFSIZE];
+  ssize_t ret;
+  ssize_t i;
+  unsigned char c;
 
-  case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
-      /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
-      return;
+  while(1) {
+    ret = read(slipfd, readbuf, sizeof(readbuf));
+    if(ret == -1) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return;
+      }
+      err(1, "serial_input: read");
     }
-
-    switch(c) {
-    case SLIP_ESC_END:
-      c = SLIP_END;
-      break;
-    case SLIP_ESC_ESC:
-      c = SLIP_ESC;
-      break;
+    if(ret == 0) {
+      if(isatty(slipfd)) {
+        /* With VMIN=0 and VTIME=0, nothing more to read for now */
+        return;
+      }
+      /* The slip server closed the connection */
+      errx(1, "serial_input: end of file");
     }
-    /* FALLTHROUGH */
-  default:
-    inbuf[inbufptr++] = c;
-
-    /* Echo lines as they are received for verbose=2,3,5+ */
-    /* Echo all printable characters for verbose==4 */
-    if(slip_config_verbose == 4) {
-      if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
-        fwrite(&c, 1, 1, stdout);
+    slip_reads++;
+    slip_received += ret;
+
+    for(i = 0; i < ret; i++) {
+      c = readbuf[i];
+
+      if(escaped) {
+        escaped = 0;
+        switch(c) {
+        case SLIP_ESC_END:
+          c = SLIP_END;
+          break;
+        case SLIP_ESC_ESC:
+          c = SLIP_ESC;
+          break;
+        }
+      } else if(c == SLIP_END) {
+        if(inbufptr > 0) {
+          slip_frame_input(inbuf, inbufptr);
+          inbufptr = 0;
+        }
+        continue;
+      } else if(c == SLIP_ESC) {
+        escaped = 1;
+        continue;
       }
-    } else if(slip_config_verbose >= 2) {
-      if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
-        fwrite(inbuf, inbufptr, 1, stdout);
+
+      if(inbufptr >= sizeof(inbuf)) {
+        fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
+        slip_frames_dropped++;
         inbufptr = 0;
       }
+      inbuf[inbufptr++] = c;
+
+      /* Echo lines as they are received for verbose=2,3,5+ */
+      /* Echo all printable characters for verbose==4 */
+      if(slip_config_verbose == 4) {
+        if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
+          fwrite(&c, 1, 1, stdout);
+        }
+      } else if(slip_config_verbose >= 2) {
+        if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
+          fwrite(inbuf, inbufptr, 1, stdout);
+          inbufptr = 0;
+        }
+      }
     }
-    break;
-  }
 
-  goto read_more;
+    if((size_t)ret < sizeof(readbuf)) {
+      /* Drained, no need for another read() that would fail with EAGAIN */
+      return;
+    }
+  }
 }
 unsigned char slip_buf[2048];
 int slip_end, slip_begin, slip_packet_end, slip_packet_count;
@@ -413,6 +437,7 @@ write_to_serial(int outfd, const uint8_t *inbuf, int len)
     }
   }
   slip_send(outfd, SLIP_END);
+  slip_frames_sent++;
   PROGRESS("t");
 }
 /*---------------------------------------------------------------------------*/
@@ -499,7 +524,7 @@ static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
   if(FD_ISSET(slipfd, rset)) {
-    serial_input(inslip);
+    serial_input();
   }
 
   if(FD_ISSET(slipfd, wset)) {
@@ -560,9 +585,5 @@ slip_init(void)
 
   timer_set(&send_delay_timer, 0);
   slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) {
-    err(1, "slip_init: fdopen");
-  }
 }
 /*---------------------------------------------------------------------------*/
@@ -46,6 +46,7 @@
 #include "shell.h"
 #include "shell-commands.h"
 #include "lib/list.h"
+#include "lib/memb.h"
 #include "sys/log.h"
 #include "dev/watchdog.h"
 #include "net/ipv6/uip.h"
@@ -657,6 +658,30 @@ PT_THREAD(cmd_routes(struct pt *pt, shell_output_func output, char *args))
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+#if MEMB_STATS
+static
+PT_THREAD(cmd_memb(struct pt *pt, shell_output_func output, char *args))
+{
+  struct memb *m;
+
+  PT_BEGIN(pt);
+
+  m = memb_head();
+  if(m == NULL) {
+    SHELL_OUTPUT(output, "No memory blocks in use\n");
+  } else {
+    SHELL_OUTPUT(output, "Memory blocks:\n");
+    for(; m != NULL; m = memb_next(m)) {
+      SHELL_OUTPUT(output, "-- %s: %u bytes x %u, used %u, peak %u\n",
+                   m->label, m->size, m->num,
+                   memb_numused(m), memb_peak(m));
+    }
+  }
+
+  PT_END(pt);
+}
+#endif /* MEMB_STATS */
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(cmd_reboot(struct pt *pt, shell_output_func output, char *args))
 {
@@ -848,6 +873,9 @@ const struct shell_command_t builtin_shell_commands[] = {
   { "reboot",               cmd_reboot,               "'> reboot': Reboot the board by watchdog_reboot()" },
   { "ip-addr",              cmd_ipaddr,               "'> ip-addr': Shows all IPv6 addresses" },
   { "ip-nbr",               cmd_ip_neighbors,         "'> ip-nbr': Shows all IPv6 neighbors" },
+#if MEMB_STATS
+  { "memb",                 cmd_memb,                 "'> memb': Shows the usage and peak usage of the memory blocks" },
+#endif /* MEMB_STATS */
   { "log",                  cmd_log,                  "'> log module level': Sets log level (0--4) for a given module (or \"all\"). For module \"mac\", level 4 also enables per-slot logging." },
   { "ping",                 cmd_ping,                 "'> ping addr': Pings the IPv6 address 'addr'" },
 #if UIP_CONF_IPV6_RPL
@@ -49,11 +49,313 @@
 #include "sys/etimer.h"
 #include "sys/process.h"
 
-static struct etimer *timerlist;
+#include <string.h>
+
 static clock_time_t next_expiration;
 
 PROCESS(etimer_process, "Event timer");
 /*---------------------------------------------------------------------------*/
+#if ETIMER_WHEEL
+
+#define WHEEL_SLOTS (1 << ETIMER_WHEEL_BITS)
+#define WHEEL_MASK  (WHEEL_SLOTS - 1)
+/* Index of the list of timers that have expired but not been posted */
+#define WHEEL_DUE   (ETIMER_WHEEL_LEVELS * WHEEL_SLOTS)
+
+#if WHEEL_DUE > 255
+#error "ETIMER_WHEEL_LEVELS * 2^ETIMER_WHEEL_BITS must be at most 255"
+#endif
+#if ETIMER_WHEEL_LEVELS * ETIMER_WHEEL_BITS >= 32
+#error "ETIMER_WHEEL_LEVELS * ETIMER_WHEEL_BITS must be less than 32"
+#endif
+
+#define LEVEL_SHIFT(level) ((level) * ETIMER_WHEEL_BITS)
+
+/* Whether time a comes before time b, taking clock wraps into account */
+#define WHEEL_BEFORE(a, b) \
+  ((clock_time_t)((a) - (b)) > ((clock_time_t)~(clock_time_t)0 >> 1))
+
+/*
+ * Level l of the wheel holds the timers that expire between
+ * 2^(l * BITS) and 2^((l + 1) * BITS) ticks after wheel_time, in the slot
+ * given by the corresponding bits of their expiration time. A slot of
+ * level l > 0 is moved one level down when wheel_time reaches the start
+ * of the range of ticks it covers.
+ */
+static struct etimer *wheel[WHEEL_DUE + 1];
+/* All ticks up to and including wheel_time have been handled */
+static clock_time_t wheel_time;
+/* The first tick after wheel_time at which a slot needs handling */
+static clock_time_t next_work;
+/* Number of timers in the wheel, not counting the due ones */
+static unsigned short wheel_count;
+/*---------------------------------------------------------------------------*/
+/* Returns the first tick after wheel_time at which a slot is handled */
+static clock_time_t
+slot_tick(int level, int idx)
+{
+  clock_time_t base;
+  clock_time_t k;
+
+  base = wheel_time >> LEVEL_SHIFT(level);
+  k = (idx - base) & WHEEL_MASK;
+  if(k == 0) {
+    k = WHEEL_SLOTS;
+  }
+  return (base + k) << LEVEL_SHIFT(level);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_insert(struct etimer *t)
+{
+  clock_time_t expiration;
+  clock_time_t delta;
+  clock_time_t tick;
+  int level;
+  int idx;
+
+  expiration = t->timer.start + t->timer.interval;
+  delta = expiration - wheel_time;
+
+  if(wheel_count == 0 && wheel[WHEEL_DUE] == NULL) {
+    next_expiration = expiration;
+  } else if(WHEEL_BEFORE(expiration, next_expiration)) {
+    next_expiration = expiration;
+  }
+
+  if(delta == 0 || WHEEL_BEFORE(expiration, wheel_time)) {
+    t->slot = WHEEL_DUE;
+    t->next = wheel[WHEEL_DUE];
+    wheel[WHEEL_DUE] = t;
+    return;
+  }
+
+  for(level = 0; level < ETIMER_WHEEL_LEVELS - 1; level++) {
+    if(delta < ((clock_time_t)1 << LEVEL_SHIFT(level + 1))) {
+      break;
+    }
+  }
+  if(delta < ((clock_time_t)1 << LEVEL_SHIFT(ETIMER_WHEEL_LEVELS))) {
+    idx = (expiration >> LEVEL_SHIFT(level)) & WHEEL_MASK;
+  } else {
+    /* Out of range: park in the slot of the coarsest level that is
+       handled last, and insert again from there */
+    idx = (wheel_time >> LEVEL_SHIFT(level)) & WHEEL_MASK;
+  }
+
+  t->slot = level * WHEEL_SLOTS + idx;
+  t->next = wheel[t->slot];
+  wheel[t->slot] = t;
+
+  tick = slot_tick(level, idx);
+  if(wheel_count == 0 || WHEEL_BEFORE(tick, next_work)) {
+    next_work = tick;
+  }
+  wheel_count++;
+}
+/*---------------------------------------------------------------------------*/
+/* Recomputes next_work and next_expiration after the wheel has moved */
+static void
+wheel_update(void)
+{
+  clock_time_t tick;
+  clock_time_t expiration;
+  struct etimer *t;
+  int level;
+  int k;
+  int idx;
+  int found;
+  int work_found;
+
+  found = 0;
+  work_found = 0;
+  if(wheel[WHEEL_DUE] != NULL) {
+    next_expiration = wheel_time;
+    found = 1;
+  }
+
+  if(wheel_count == 0) {
+    return;
+  }
+
+  for(level = 0; level < ETIMER_WHEEL_LEVELS; level++) {
+    for(k = 1; k <= WHEEL_SLOTS; k++) {
+      idx = ((wheel_time >> LEVEL_SHIFT(level)) + k) & WHEEL_MASK;
+      t = wheel[level * WHEEL_SLOTS + idx];
+      if(t == NULL) {
+        continue;
+      }
+
+      tick = slot_tick(level, idx);
+      if(!work_found || WHEEL_BEFORE(tick, next_work)) {
+        next_work = tick;
+        work_found = 1;
+      }
+
+      if(level == ETIMER_WHEEL_LEVELS - 1) {
+        /* Timers parked out of range may expire before the others in
+           the coarsest level, so only the start of the slot is known to
+           be early enough */
+        if(!found || WHEEL_BEFORE(tick, next_expiration)) {
+          next_expiration = tick;
+          found = 1;
+        }
+        break;
+      }
+
+      /* The timers of a slot all expire before those of the later slots
+         of the same level */
+      for(; t != NULL; t = t->next) {
+        expiration = t->timer.start + t->timer.interval;
+        if(!found || WHEEL_BEFORE(expiration, next_expiration)) {
+          next_expiration = expiration;
+          found = 1;
+        }
+      }
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(struct etimer *t)
+{
+  struct etimer **tp;
+  clock_time_t expiration;
+
+  if(t->slot > WHEEL_DUE) {
+    return;
+  }
+
+  for(tp = &wheel[t->slot]; *tp != NULL; tp = &(*tp)->next) {
+    if(*tp == t) {
+      *tp = t->next;
+      t->next = NULL;
+      if(t->slot != WHEEL_DUE) {
+        wheel_count--;
+      }
+      /* next_expiration may have come from this timer, or from the start
+         of its slot if it was in the coarsest level */
+      expiration = t->timer.start + t->timer.interval;
+      if(!WHEEL_BEFORE(next_expiration, expiration) || wheel[t->slot] == NULL) {
+        wheel_update();
+      }
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Moves the wheel to the given tick, which must be next_work */
+static void
+wheel_handle_tick(clock_time_t tick)
+{
+  struct etimer *list;
+  struct etimer *t;
+  int level;
+  int slot;
+
+  wheel_time = tick;
+
+  /* Move the timers of the coarser slots that start at this tick down */
+  for(level = ETIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+    if((tick & (((clock_time_t)1 << LEVEL_SHIFT(level)) - 1)) == 0) {
+      slot = level * WHEEL_SLOTS +
+        ((tick >> LEVEL_SHIFT(level)) & WHEEL_MASK);
+      list = wheel[slot];
+      wheel[slot] = NULL;
+      while(list != NULL) {
+        t = list;
+        list = t->next;
+        wheel_count--;
+        wheel_insert(t);
+      }
+    }
+  }
+
+  /* The timers of the finest slot expire at this tick */
+  slot = tick & WHEEL_MASK;
+  while(wheel[slot] != NULL) {
+    t = wheel[slot];
+    wheel[slot] = t->next;
+    wheel_count--;
+    t->slot = WHEEL_DUE;
+    t->next = wheel[WHEEL_DUE];
+    wheel[WHEEL_DUE] = t;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_run(void)
+{
+  clock_time_t now;
+  struct etimer *t;
+
+  now = clock_time();
+
+  while(1) {
+    if(wheel[WHEEL_DUE] != NULL) {
+      while(wheel[WHEEL_DUE] != NULL) {
+        t = wheel[WHEEL_DUE];
+        if(process_post(t->p, PROCESS_EVENT_TIMER, t) != PROCESS_ERR_OK) {
+          /* Retry on the next poll */
+          etimer_request_poll();
+          return;
+        }
+        /* Reset the process ID of the event timer, to signal that the
+           etimer has expired. This is later checked in the
+           etimer_expired() function. */
+        t->p = PROCESS_NONE;
+        wheel[WHEEL_DUE] = t->next;
+        t->next = NULL;
+      }
+      /* next_expiration pointed at the due timers */
+      wheel_update();
+    }
+
+    if(wheel_count == 0 || WHEEL_BEFORE(now, next_work)) {
+      /* Nothing to handle until now */
+      wheel_time = now;
+      return;
+    }
+
+    wheel_handle_tick(next_work);
+    wheel_update();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove_process(struct process *p)
+{
+  struct etimer **tp;
+  int slot;
+
+  int removed;
+
+  removed = 0;
+  for(slot = 0; slot <= WHEEL_DUE; slot++) {
+    tp = &wheel[slot];
+    while(*tp != NULL) {
+      if((*tp)->p == p) {
+        if(slot != WHEEL_DUE) {
+          wheel_count--;
+        }
+        *tp = (*tp)->next;
+        removed = 1;
+      } else {
+        tp = &(*tp)->next;
+      }
+    }
+  }
+
+  if(removed) {
+    wheel_update();
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* ETIMER_WHEEL */
+
+static struct etimer *timerlist;
+/*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
@@ -77,17 +379,34 @@ update_time(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#endif /* ETIMER_WHEEL */
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
 {
+#if !ETIMER_WHEEL
   struct etimer *t, *u;
+#endif /* !ETIMER_WHEEL */
 	
   PROCESS_BEGIN();
 
+#if ETIMER_WHEEL
+  memset(wheel, 0, sizeof(wheel));
+  wheel_count = 0;
+  wheel_time = clock_time();
+#else /* ETIMER_WHEEL */
   timerlist = NULL;
+#endif /* ETIMER_WHEEL */
   
   while(1) {
     PROCESS_YIELD();
 
+#if ETIMER_WHEEL
+    if(ev == PROCESS_EVENT_EXITED) {
+      wheel_remove_process(data);
+    } else if(ev == PROCESS_EVENT_POLL) {
+      wheel_run();
+    }
+#else /* ETIMER_WHEEL */
     if(ev == PROCESS_EVENT_EXITED) {
       struct process *p = data;
 
@@ -135,6 +454,7 @@ PROCESS_THREAD(etimer_process, ev, data)
       }
       u = t;
     }
+#endif /* ETIMER_WHEEL */
     
   }
   
@@ -150,6 +470,15 @@ etimer_request_poll(void)
 static void
 add_timer(struct etimer *timer)
 {
+#if ETIMER_WHEEL
+  etimer_request_poll();
+
+  if(timer->p != PROCESS_NONE) {
+    wheel_remove(timer);
+  }
+  timer->p = PROCESS_CURRENT();
+  wheel_insert(timer);
+#else /* ETIMER_WHEEL */
   struct etimer *t;
 
   etimer_request_poll();
@@ -171,6 +500,7 @@ add_timer(struct etimer *timer)
   timerlist = timer;
 
   update_time();
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -205,8 +535,18 @@ etimer_restart(struct etimer *et)
 void
 etimer_adjust(struct etimer *et, int timediff)
 {
+#if ETIMER_WHEEL
+  if(et->p != PROCESS_NONE) {
+    wheel_remove(et);
+    et->timer.start += timediff;
+    wheel_insert(et);
+  } else {
+    et->timer.start += timediff;
+  }
+#else /* ETIMER_WHEEL */
   et->timer.start += timediff;
   update_time();
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -230,7 +570,11 @@ etimer_start_time(struct etimer *et)
 int
 etimer_pending(void)
 {
+#if ETIMER_WHEEL
+  return wheel_count != 0 || wheel[WHEEL_DUE] != NULL;
+#else /* ETIMER_WHEEL */
   return timerlist != NULL;
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 clock_time_t
@@ -242,6 +586,11 @@ etimer_next_expiration_time(void)
 void
 etimer_stop(struct etimer *et)
 {
+#if ETIMER_WHEEL
+  if(et->p != PROCESS_NONE) {
+    wheel_remove(et);
+  }
+#else /* ETIMER_WHEEL */
   struct etimer *t;
 
   /* First check if et is the first event timer on the list. */
@@ -262,6 +611,7 @@ etimer_stop(struct etimer *et)
       update_time();
     }
   }
+#endif /* ETIMER_WHEEL */
 
   /* Remove the next pointer from the item to be removed. */
   et->next = NULL;
@@ -64,6 +64,38 @@
 
 #include "contiki.h"
 
+/**
+ * \name Timer wheel configuration
+ *
+ * By default, pending event timers are kept on a single list that is
+ * scanned whenever a timer is set and whenever the event timer process
+ * is polled. With ETIMER_CONF_WHEEL set, they are instead kept in a
+ * hierarchical timer wheel of ETIMER_CONF_WHEEL_LEVELS levels of
+ * 2^ETIMER_CONF_WHEEL_BITS slots each. Setting a timer is then O(1) and
+ * a poll only does work on the ticks at which a timer expires or has to
+ * move to a finer level. Timers beyond the range of the wheel wait in
+ * its coarsest level until they get in range.
+ * @{
+ */
+#ifdef ETIMER_CONF_WHEEL
+#define ETIMER_WHEEL ETIMER_CONF_WHEEL
+#else
+#define ETIMER_WHEEL 0
+#endif
+
+#ifdef ETIMER_CONF_WHEEL_BITS
+#define ETIMER_WHEEL_BITS ETIMER_CONF_WHEEL_BITS
+#else
+#define ETIMER_WHEEL_BITS 4
+#endif
+
+#ifdef ETIMER_CONF_WHEEL_LEVELS
+#define ETIMER_WHEEL_LEVELS ETIMER_CONF_WHEEL_LEVELS
+#else
+#define ETIMER_WHEEL_LEVELS 4
+#endif
+/** @} */
+
 /**
  * A timer.
  *
@@ -76,6 +108,9 @@ struct etimer {
   struct timer timer;
   struct etimer *next;
   struct process *p;
+#if ETIMER_WHEEL
+  unsigned char slot;
+#endif
 };
 
 /**
@@ -44,6 +44,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "contiki.h"
 #include "sys/process.h"
@@ -65,11 +66,22 @@ struct event_data {
   struct process *p;
 };
 
-static process_num_events_t nevents, fevent;
-static struct event_data events[PROCESS_CONF_NUMEVENTS];
+/*
+ * One ring of events per priority level. nevents is the total number
+ * of queued events over all levels.
+ */
+struct event_queue {
+  process_num_events_t nevents, fevent;
+  struct event_data events[PROCESS_CONF_NUMEVENTS];
+};
+
+static process_num_events_t nevents;
+static struct event_queue queues[PROCESS_PRIORITY_LEVELS];
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
+process_num_events_t process_maxevents_priority[PROCESS_PRIORITY_LEVELS];
+uint16_t process_dropped_events[PROCESS_PRIORITY_LEVELS];
 #endif
 
 static volatile unsigned char poll_requested;
@@ -95,6 +107,17 @@ process_alloc_event(void)
   return lastevent++;
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_PRIORITY_LEVELS > 1
+void
+process_set_priority(struct process *p, unsigned char priority)
+{
+  if(priority > PROCESS_PRIORITY_HIGH) {
+    priority = PROCESS_PRIORITY_HIGH;
+  }
+  p->priority = priority;
+}
+#endif /* PROCESS_PRIORITY_LEVELS > 1 */
+/*---------------------------------------------------------------------------*/
 void
 process_start(struct process *p, process_data_t data)
 {
@@ -209,9 +232,12 @@ process_init(void)
 {
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  nevents = 0;
+  memset(queues, 0, sizeof(queues));
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
+  memset(process_maxevents_priority, 0, sizeof(process_maxevents_priority));
+  memset(process_dropped_events, 0, sizeof(process_dropped_events));
 #endif /* PROCESS_CONF_STATS */
 
   process_current = process_list = NULL;
@@ -249,6 +275,7 @@ do_event(void)
   process_data_t data;
   struct process *receiver;
   struct process *p;
+  struct event_queue *q;
 
   /*
    * If there are any events in the queue, take the first one and walk
@@ -260,15 +287,22 @@ do_event(void)
 
   if(nevents > 0) {
 
-    /* There are events that we should deliver. */
-    ev = events[fevent].ev;
+    /* There are events that we should deliver. Take them from the
+       highest priority level that has any. */
+    q = &queues[PROCESS_PRIORITY_HIGH];
+    while(q->nevents == 0) {
+      q--;
+    }
+
+    ev = q->events[q->fevent].ev;
 
-    data = events[fevent].data;
-    receiver = events[fevent].p;
+    data = q->events[q->fevent].data;
+    receiver = q->events[q->fevent].p;
 
     /* Since we have seen the new event, we move pointer upwards
        and decrease the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    q->fevent = (q->fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    --q->nevents;
     --nevents;
 
     /* If this is a broadcast event, we deliver it to all events, in
@@ -319,9 +353,28 @@ process_nevents(void)
 }
 /*---------------------------------------------------------------------------*/
 int
+process_nevents_priority(unsigned char priority)
+{
+  if(priority >= PROCESS_PRIORITY_LEVELS) {
+    return 0;
+  }
+  return queues[priority].nevents;
+}
+/*---------------------------------------------------------------------------*/
+int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   process_num_events_t snum;
+  unsigned char priority;
+  struct event_queue *q;
+
+#if PROCESS_PRIORITY_LEVELS > 1
+  priority = (p == PROCESS_BROADCAST || p == PROCESS_ZOMBIE) ?
+    PROCESS_PRIORITY_NORMAL : p->priority;
+#else /* PROCESS_PRIORITY_LEVELS > 1 */
+  priority = PROCESS_PRIORITY_NORMAL;
+#endif /* PROCESS_PRIORITY_LEVELS > 1 */
+  q = &queues[priority];
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event %d to process '%s', nevents %d\n",
@@ -332,7 +385,7 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
   }
 
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  if(q->nevents == PROCESS_CONF_NUMEVENTS) {
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -340,19 +393,26 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
       printf("soft panic: event queue is full when event %d was posted to %s from %s\n", ev, PROCESS_NAME_STRING(p), PROCESS_NAME_STRING(process_current));
     }
 #endif /* DEBUG */
+#if PROCESS_CONF_STATS
+    process_dropped_events[priority]++;
+#endif /* PROCESS_CONF_STATS */
     return PROCESS_ERR_FULL;
   }
 
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
-  events[snum].ev = ev;
-  events[snum].data = data;
-  events[snum].p = p;
+  snum = (process_num_events_t)(q->fevent + q->nevents) % PROCESS_CONF_NUMEVENTS;
+  q->events[snum].ev = ev;
+  q->events[snum].data = data;
+  q->events[snum].p = p;
+  ++q->nevents;
   ++nevents;
 
 #if PROCESS_CONF_STATS
   if(nevents > process_maxevents) {
     process_maxevents = nevents;
   }
+  if(q->nevents > process_maxevents_priority[priority]) {
+    process_maxevents_priority[priority] = q->nevents;
+  }
 #endif /* PROCESS_CONF_STATS */
 
   return PROCESS_ERR_OK;
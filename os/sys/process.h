@@ -56,6 +56,8 @@
 #include "sys/pt.h"
 #include "sys/cc.h"
 
+#include <stdint.h>
+
 typedef unsigned char process_event_t;
 typedef void *        process_data_t;
 typedef unsigned char process_num_events_t;
@@ -88,6 +90,27 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/**
+ * \name Event priorities
+ *
+ * With more than one priority level, each level has its own event
+ * queue of PROCESS_CONF_NUMEVENTS entries. Events are queued at the
+ * priority of their receiving process (broadcast events at
+ * PROCESS_PRIORITY_NORMAL), and process_run() always delivers from the
+ * highest non-empty level first. A burst of application events can
+ * then neither delay nor crowd out events for e.g. the network stack.
+ * @{
+ */
+#ifdef PROCESS_CONF_PRIORITY_LEVELS
+#define PROCESS_PRIORITY_LEVELS PROCESS_CONF_PRIORITY_LEVELS
+#else /* PROCESS_CONF_PRIORITY_LEVELS */
+#define PROCESS_PRIORITY_LEVELS 1
+#endif /* PROCESS_CONF_PRIORITY_LEVELS */
+
+#define PROCESS_PRIORITY_NORMAL 0
+#define PROCESS_PRIORITY_HIGH   (PROCESS_PRIORITY_LEVELS - 1)
+/** @} */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -323,6 +346,9 @@ struct process {
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
   unsigned char state, needspoll;
+#if PROCESS_PRIORITY_LEVELS > 1
+  unsigned char priority;
+#endif /* PROCESS_PRIORITY_LEVELS > 1 */
 };
 
 /**
@@ -452,6 +478,22 @@ process_current = p
  */
 process_event_t process_alloc_event(void);
 
+/**
+ * \brief      Set the priority of the events posted to a process.
+ * \param p    A pointer to the process' process structure.
+ * \param priority The priority, from PROCESS_PRIORITY_NORMAL (the
+ *             default) up to PROCESS_PRIORITY_HIGH.
+ *
+ *             Events that are already queued for the process keep
+ *             their priority. Without multiple priority levels, this
+ *             does nothing.
+ */
+#if PROCESS_PRIORITY_LEVELS > 1
+void process_set_priority(struct process *p, unsigned char priority);
+#else /* PROCESS_PRIORITY_LEVELS > 1 */
+#define process_set_priority(p, priority)
+#endif /* PROCESS_PRIORITY_LEVELS > 1 */
+
 /** @} */
 
 /**
@@ -519,6 +561,25 @@ int process_is_running(struct process *p);
  */
 int process_nevents(void);
 
+/**
+ *  Number of events waiting to be processed at a given priority.
+ *
+ * \param priority The priority level.
+ * \return The number of events that are currently queued at that
+ * priority.
+ */
+int process_nevents_priority(unsigned char priority);
+
+#if PROCESS_CONF_STATS
+/** The highest number of events that have been queued at once */
+extern process_num_events_t process_maxevents;
+/** The highest number of events queued at once, per priority level */
+extern process_num_events_t process_maxevents_priority[PROCESS_PRIORITY_LEVELS];
+/** The number of events dropped because their queue was full, per
+    priority level */
+extern uint16_t process_dropped_events[PROCESS_PRIORITY_LEVELS];
+#endif /* PROCESS_CONF_STATS */
+
 /** @} */
 
 extern struct process *process_list;
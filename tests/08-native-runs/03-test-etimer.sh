@@ -0,0 +1,43 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Test code directory
+CODE_DIR=$CONTIKI/tests/08-native-runs/code-etimer/
+CODE=test-etimer
+
+rm -f $CODE.log
+
+# Run the test with the timer list and with the timer wheel
+for DEFINES in ETIMER_CONF_WHEEL=0 ETIMER_CONF_WHEEL=1; do
+  echo "Building and running $CODE with $DEFINES"
+  make -C $CODE_DIR TARGET=native clean > /dev/null 2>&1
+  rm -f $CODE_DIR/Makefile.native.defines
+  make -C $CODE_DIR TARGET=native DEFINES=$DEFINES > make.log 2> make.err
+  echo "=== $DEFINES" >> $CODE.log
+  timeout 10 $CODE_DIR/$CODE.native >> $CODE.log 2> $CODE.err
+done
+rm -f $CODE_DIR/Makefile.native.defines
+
+if grep -q "=check-me= FAILED" $CODE.log ||
+   [ $(grep -c "=check-me= DONE" $CODE.log) -ne 2 ] ; then
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log;
+  echo "==== $CODE.err ====" ; cat $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+else
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log
+rm $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks the scheduling of the CSMA queues with priority queueing: that
+ * control frames are sent before data frames, also while the link to
+ * another neighbor fails and is retried, and that data frames are
+ * shared between neighbors with deficit round-robin.
+ */
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/mac/csma/csma.h"
+#include "net/mac/csma/csma-output.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(csma_priority_test_process, "CSMA priority test process");
+AUTOSTART_PROCESSES(&csma_priority_test_process);
+/*---------------------------------------------------------------------------*/
+/* The neighbors of the node */
+#define A 1
+#define B 2
+#define C 3
+
+static linkaddr_t lladdr[4];
+
+/* The neighbor that does not acknowledge frames, if any */
+static int failing;
+
+/* The frames sent over the radio, in order: the letter of their
+   neighbor, in upper case for control frames */
+static char txlog[32];
+static int txlen;
+
+/* The frames the MAC layer is done with */
+static int sent_count;
+static int last_status;
+
+static uint8_t dsn;
+static int ack_pending;
+
+static struct etimer et;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+neighbor_of(const linkaddr_t *addr)
+{
+  int i;
+
+  for(i = A; i <= C; i++) {
+    if(linkaddr_cmp(addr, &lladdr[i])) {
+      return i;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_init(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short payload_len)
+{
+  dsn = ((const uint8_t *)payload)[2];
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit(unsigned short transmit_len)
+{
+  int to = neighbor_of(packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  char c = 'a' + to - A;
+
+  if(packetbuf_attr(PACKETBUF_ATTR_PRIORITY) == PACKETBUF_ATTR_PRIORITY_CONTROL) {
+    c += 'A' - 'a';
+  }
+  if(txlen < (int)sizeof(txlog) - 1) {
+    txlog[txlen++] = c;
+  }
+  ack_pending = to != failing;
+  process_poll(&csma_priority_test_process);
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short payload_len)
+{
+  prepare(payload, payload_len);
+  return transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+read(void *buf, unsigned short buf_len)
+{
+  uint8_t *ack = buf;
+
+  if(!ack_pending || buf_len < CSMA_ACK_LEN) {
+    return 0;
+  }
+  ack_pending = 0;
+  ack[0] = FRAME802154_ACKFRAME;
+  ack[1] = 0;
+  ack[2] = dsn;
+  return CSMA_ACK_LEN;
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  return ack_pending;
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver test_radio_driver = {
+  radio_init,
+  prepare,
+  transmit,
+  send,
+  read,
+  channel_clear,
+  receiving_packet,
+  pending_packet,
+  on,
+  off,
+  get_value,
+  set_value,
+  get_object,
+  set_object
+};
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+output(const linkaddr_t *localdest)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_network_driver = {
+  "test",
+  init,
+  input,
+  output
+};
+/*---------------------------------------------------------------------------*/
+static void
+packet_sent(void *ptr, int status, int num_tx)
+{
+  sent_count++;
+  last_status = status;
+}
+/*---------------------------------------------------------------------------*/
+/* Queues a frame of len bytes for a neighbor */
+static void
+send_frame(int to, uint8_t priority, int len, int max_transmissions)
+{
+  packetbuf_clear();
+  memset(packetbuf_dataptr(), to, len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &lladdr[to]);
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, priority);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS, max_transmissions);
+  NETSTACK_MAC.send(packet_sent, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset_log(void)
+{
+  memset(txlog, 0, sizeof(txlog));
+  txlen = 0;
+  sent_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_fair_share,
+                   "Control first, then data with deficit round-robin");
+UNIT_TEST(test_fair_share)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("txlog %s\n", txlog);
+  UNIT_TEST_ASSERT(sent_count == 10);
+  UNIT_TEST_ASSERT(csma_output_priority_stats()->control_drops == 0);
+  /* The control frames overtake the data frames queued before them,
+     including the one a was about to send. Each turn of a then sends
+     up to 128 bytes of 25-byte frames, and each turn of b one 100-byte
+     frame, with the unused 28 bytes saved for its next turn. */
+  UNIT_TEST_ASSERT(strcmp(txlog, "CBaaaaabab") == 0);
+  UNIT_TEST_ASSERT(last_status == MAC_TX_OK);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_failing_link,
+                   "Control frames do not wait behind retransmissions");
+UNIT_TEST(test_failing_link)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("txlog %s\n", txlog);
+  UNIT_TEST_ASSERT(sent_count == 2);
+  /* The control frame for b goes between two attempts to a */
+  UNIT_TEST_ASSERT(strcmp(txlog, "aBaaa") == 0);
+  /* a still gets all its attempts */
+  UNIT_TEST_ASSERT(last_status == MAC_TX_NOACK);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(csma_priority_test_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  for(i = A; i <= C; i++) {
+    lladdr[i] = linkaddr_node_addr;
+    lladdr[i].u8[LINKADDR_SIZE - 1] += i;
+  }
+
+  /* Data for a and b, then control frames for c and b */
+  reset_log();
+  for(i = 0; i < 6; i++) {
+    send_frame(A, PACKETBUF_ATTR_PRIORITY_DATA, 25, 1);
+  }
+  for(i = 0; i < 2; i++) {
+    send_frame(B, PACKETBUF_ATTR_PRIORITY_DATA, 100, 1);
+  }
+  send_frame(C, PACKETBUF_ATTR_PRIORITY_CONTROL, 40, 1);
+  send_frame(B, PACKETBUF_ATTR_PRIORITY_CONTROL, 40, 1);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_fair_share);
+
+  /* a stops acknowledging. A control frame for b is queued once the
+     first attempt to a is done. */
+  reset_log();
+  failing = A;
+  send_frame(A, PACKETBUF_ATTR_PRIORITY_DATA, 40, 4);
+  PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+  send_frame(B, PACKETBUF_ATTR_PRIORITY_CONTROL, 40, 1);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_failing_link);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(etimer_test_process, "Event timer test process");
+AUTOSTART_PROCESSES(&etimer_test_process);
+/*---------------------------------------------------------------------------*/
+/* Intervals in different levels of the timer wheel, if enabled */
+#define SHORT_INTERVAL  10
+#define MEDIUM_INTERVAL 200
+#define LONG_INTERVAL   3000
+
+static struct etimer timers[3];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_stop, "Next expiration after stopping timers");
+UNIT_TEST(test_stop)
+{
+  UNIT_TEST_BEGIN();
+
+  etimer_set(&timers[0], SHORT_INTERVAL);
+  etimer_set(&timers[1], MEDIUM_INTERVAL);
+  etimer_set(&timers[2], LONG_INTERVAL);
+  UNIT_TEST_ASSERT(etimer_next_expiration_time() ==
+                   etimer_expiration_time(&timers[0]));
+
+  /* Stopping the earliest timer moves the next expiration to the next one */
+  etimer_stop(&timers[0]);
+  UNIT_TEST_ASSERT(etimer_next_expiration_time() ==
+                   etimer_expiration_time(&timers[1]));
+
+  /* Stopping a later timer does not change it */
+  etimer_stop(&timers[2]);
+  UNIT_TEST_ASSERT(etimer_next_expiration_time() ==
+                   etimer_expiration_time(&timers[1]));
+
+  etimer_stop(&timers[1]);
+  UNIT_TEST_ASSERT(!etimer_pending());
+  UNIT_TEST_ASSERT(etimer_next_expiration_time() == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_expired, "Next expiration after a timer expired");
+UNIT_TEST(test_expired)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Run once timers[0] has expired, with timers[1] still pending */
+  UNIT_TEST_ASSERT(etimer_expired(&timers[0]));
+  UNIT_TEST_ASSERT(!etimer_expired(&timers[1]));
+  UNIT_TEST_ASSERT(etimer_next_expiration_time() ==
+                   etimer_expiration_time(&timers[1]));
+
+  etimer_stop(&timers[1]);
+  UNIT_TEST_ASSERT(!etimer_pending());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(etimer_test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_stop);
+
+  etimer_set(&timers[0], SHORT_INTERVAL);
+  etimer_set(&timers[1], MEDIUM_INTERVAL);
+  PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && data == &timers[0]);
+
+  UNIT_TEST_RUN(test_expired);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
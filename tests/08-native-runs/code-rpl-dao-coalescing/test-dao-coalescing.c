@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks that a storing-mode router coalescing the DAOs of its children
+ * validates their options, requests a DAO-ACK for the coalesced DAO it
+ * sends to its parent, sends it again until acknowledged, and only then
+ * considers its routes advertised.
+ */
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/routing/rpl-classic/rpl-private.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(dao_coalescing_test_process, "DAO coalescing test process");
+AUTOSTART_PROCESSES(&dao_coalescing_test_process);
+/*---------------------------------------------------------------------------*/
+/* The neighbors of the node: its parent and a child */
+#define PARENT 1
+#define CHILD  2
+
+static linkaddr_t lladdr[3];
+static uip_ipaddr_t ipaddr[3];
+
+/* The last DAO and DAO-ACK sent by the node */
+static unsigned dao_count;
+static uip_ipaddr_t dao_dest;
+static uint8_t dao[64];
+static unsigned dao_ack_count;
+static uint8_t dao_ack[4];
+
+static struct etimer et;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+output(const linkaddr_t *localdest)
+{
+  const struct uip_icmp_hdr *icmp = (struct uip_icmp_hdr *)&uip_buf[UIP_IPH_LEN];
+  const uint8_t *payload = &uip_buf[UIP_IPH_LEN + UIP_ICMPH_LEN];
+
+  if(UIP_IP_BUF->proto != UIP_PROTO_ICMP6 || icmp->type != ICMP6_RPL) {
+    return 1;
+  }
+  if(icmp->icode == RPL_CODE_DAO) {
+    dao_count++;
+    uip_ipaddr_copy(&dao_dest, &UIP_IP_BUF->destipaddr);
+    memcpy(dao, payload, sizeof(dao));
+  } else if(icmp->icode == RPL_CODE_DAO_ACK) {
+    dao_ack_count++;
+    memcpy(dao_ack, payload, sizeof(dao_ack));
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver test_network_driver = {
+  "test",
+  init,
+  input,
+  output
+};
+/*---------------------------------------------------------------------------*/
+/* Hands an RPL message from a neighbor to the node */
+static void
+receive_rpl(int from, uint8_t code, const uint8_t *payload, int len)
+{
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = 64;
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &ipaddr[from]);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &ipaddr[0]);
+  memcpy(&uip_buf[UIP_IPH_LEN + UIP_ICMPH_LEN], payload, len);
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + len;
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &lladdr[from]);
+  uip_icmp6_input(ICMP6_RPL, code);
+}
+/*---------------------------------------------------------------------------*/
+/* Hands a DAO from the child to the node, with a target option of the
+   given prefix length, and a transit option with the given lifetime */
+static void
+receive_child_dao(const uip_ipaddr_t *target, uint8_t prefixlen,
+                  uint8_t lifetime, uint8_t sequence)
+{
+  uint8_t buf[32];
+  int pos = 0;
+
+  buf[pos++] = RPL_DEFAULT_INSTANCE;
+  buf[pos++] = RPL_DAO_K_FLAG;
+  buf[pos++] = 0;
+  buf[pos++] = sequence;
+  buf[pos++] = RPL_OPTION_TARGET;
+  buf[pos++] = 2 + 16;
+  buf[pos++] = 0;
+  buf[pos++] = prefixlen;
+  memcpy(&buf[pos], target, 16);
+  pos += 16;
+  buf[pos++] = RPL_OPTION_TRANSIT;
+  buf[pos++] = 4;
+  buf[pos++] = 0;
+  buf[pos++] = 0;
+  buf[pos++] = 0;
+  buf[pos++] = lifetime;
+  receive_rpl(CHILD, RPL_CODE_DAO, buf, pos);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive_parent_dao_ack(uint8_t sequence, uint8_t status)
+{
+  uint8_t buf[4] = { RPL_DEFAULT_INSTANCE, 0, sequence, status };
+
+  receive_rpl(PARENT, RPL_CODE_DAO_ACK, buf, sizeof(buf));
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the offset of the first option of the last DAO sent */
+static int
+dao_options(void)
+{
+  return (dao[1] & RPL_DAO_D_FLAG) ? 4 + 16 : 4;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the last DAO sent has the target as first option */
+static int
+dao_has_target(const uip_ipaddr_t *target)
+{
+  const uint8_t *option = &dao[dao_options()];
+
+  return option[0] == RPL_OPTION_TARGET && option[3] == 128 &&
+    memcmp(&option[4], target, 16) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+join_dag(void)
+{
+  rpl_dio_t dio;
+
+  memset(&dio, 0, sizeof(dio));
+  dio.instance_id = RPL_DEFAULT_INSTANCE;
+  dio.ocp = RPL_OF_OCP;
+  dio.mop = RPL_MOP_STORING_NO_MULTICAST;
+  dio.version = RPL_LOLLIPOP_INIT;
+  dio.rank = RPL_MIN_HOPRANKINC;
+  dio.grounded = 1;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &lladdr[PARENT]);
+  rpl_process_dio(&ipaddr[PARENT], &dio);
+}
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t child_target;
+static uip_ipaddr_t bad_target;
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_child_dao, "Child DAO absorbed and acknowledged");
+UNIT_TEST(test_child_dao)
+{
+  rpl_instance_t *instance = rpl_get_instance(RPL_DEFAULT_INSTANCE);
+  uip_ds6_route_t *route;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(instance != NULL && instance->current_dag != NULL);
+  UNIT_TEST_ASSERT(instance->current_dag->preferred_parent != NULL);
+  /* The regular DAO timer would refresh the routes at random times */
+  rpl_cancel_dao(instance);
+
+  receive_child_dao(&child_target, 128, RPL_DEFAULT_LIFETIME, 10);
+  route = uip_ds6_route_lookup(&child_target);
+  UNIT_TEST_ASSERT(route != NULL);
+  UNIT_TEST_ASSERT(RPL_ROUTE_IS_DAO_DELTA(route));
+  UNIT_TEST_ASSERT(dao_ack_count == 1);
+  UNIT_TEST_ASSERT(dao_ack[2] == 10 && dao_ack[3] < RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+  UNIT_TEST_ASSERT(dao_count == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_malformed_dao, "Malformed child DAOs rejected");
+UNIT_TEST(test_malformed_dao)
+{
+  uint8_t buf[32];
+  int pos = 0;
+
+  UNIT_TEST_BEGIN();
+
+  /* A prefix longer than an address */
+  receive_child_dao(&bad_target, 200, RPL_DEFAULT_LIFETIME, 11);
+  UNIT_TEST_ASSERT(uip_ds6_route_lookup(&bad_target) == NULL);
+  UNIT_TEST_ASSERT(dao_ack_count == 2);
+  UNIT_TEST_ASSERT(dao_ack[2] == 11 && dao_ack[3] >= RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+
+  /* A target option that runs past the end of the message */
+  buf[pos++] = RPL_DEFAULT_INSTANCE;
+  buf[pos++] = RPL_DAO_K_FLAG;
+  buf[pos++] = 0;
+  buf[pos++] = 12;
+  buf[pos++] = RPL_OPTION_TARGET;
+  buf[pos++] = 2 + 16;
+  buf[pos++] = 0;
+  buf[pos++] = 128;
+  memcpy(&buf[pos], &bad_target, 8);
+  pos += 8;
+  receive_rpl(CHILD, RPL_CODE_DAO, buf, pos);
+  UNIT_TEST_ASSERT(uip_ds6_route_lookup(&bad_target) == NULL);
+  UNIT_TEST_ASSERT(dao_ack_count == 3);
+  UNIT_TEST_ASSERT(dao_ack[2] == 12 && dao_ack[3] >= RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_coalesced_dao, "Coalesced DAO requests a DAO-ACK");
+UNIT_TEST(test_coalesced_dao)
+{
+  uip_ds6_route_t *route = uip_ds6_route_lookup(&child_target);
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dao_count == 1);
+  UNIT_TEST_ASSERT(uip_ipaddr_cmp(&dao_dest, &ipaddr[PARENT]));
+  UNIT_TEST_ASSERT(dao[1] & RPL_DAO_K_FLAG);
+  UNIT_TEST_ASSERT(dao_has_target(&child_target));
+  /* Still to be advertised until acknowledged */
+  UNIT_TEST_ASSERT(route != NULL && RPL_ROUTE_IS_DAO_DELTA(route));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t first_sequence;
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_retransmission, "Coalesced DAO sent again without DAO-ACK");
+UNIT_TEST(test_retransmission)
+{
+  uip_ds6_route_t *route = uip_ds6_route_lookup(&child_target);
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dao_count == 2);
+  UNIT_TEST_ASSERT(dao[1] & RPL_DAO_K_FLAG);
+  UNIT_TEST_ASSERT(dao[3] != first_sequence);
+  UNIT_TEST_ASSERT(dao_has_target(&child_target));
+  UNIT_TEST_ASSERT(route != NULL && RPL_ROUTE_IS_DAO_DELTA(route));
+
+  /* A DAO-ACK for the first transmission is too late */
+  receive_parent_dao_ack(first_sequence, RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  UNIT_TEST_ASSERT(RPL_ROUTE_IS_DAO_DELTA(route));
+
+  receive_parent_dao_ack(dao[3], RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  UNIT_TEST_ASSERT(!RPL_ROUTE_IS_DAO_DELTA(route));
+  UNIT_TEST_ASSERT(dao_count == 2);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_acknowledged, "No retransmission once acknowledged");
+UNIT_TEST(test_acknowledged)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dao_count == 2);
+
+  /* The No-Path DAO of the child goes the same way */
+  receive_child_dao(&child_target, 128, RPL_ZERO_LIFETIME, 13);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_no_path, "Coalesced No-Path DAO kept until acknowledged");
+UNIT_TEST(test_no_path)
+{
+  uip_ds6_route_t *route = uip_ds6_route_lookup(&child_target);
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dao_count == 3);
+  UNIT_TEST_ASSERT(dao_has_target(&child_target));
+  /* The transit option follows the only target */
+  UNIT_TEST_ASSERT(dao[dao_options() + 20] == RPL_OPTION_TRANSIT);
+  UNIT_TEST_ASSERT(dao[dao_options() + 25] == RPL_ZERO_LIFETIME);
+  UNIT_TEST_ASSERT(route != NULL && RPL_ROUTE_IS_DAO_DELTA(route));
+
+  /* The removal delay ends before the No-Path is acknowledged */
+  route->state.lifetime = 1;
+  rpl_purge_routes();
+  rpl_purge_routes();
+  UNIT_TEST_ASSERT(uip_ds6_route_lookup(&child_target) == route);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_no_path_retransmission, "No-Path route removed once acknowledged");
+UNIT_TEST(test_no_path_retransmission)
+{
+  uip_ds6_route_t *route = uip_ds6_route_lookup(&child_target);
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(route != NULL);
+  UNIT_TEST_ASSERT(dao_count == 4);
+  UNIT_TEST_ASSERT(dao_has_target(&child_target));
+  UNIT_TEST_ASSERT(dao[dao_options() + 25] == RPL_ZERO_LIFETIME);
+
+  receive_parent_dao_ack(dao[3], RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  UNIT_TEST_ASSERT(!RPL_ROUTE_IS_DAO_DELTA(route));
+  rpl_purge_routes();
+  UNIT_TEST_ASSERT(uip_ds6_route_lookup(&child_target) == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(dao_coalescing_test_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  /* Give the node, its parent and its child link-local addresses */
+  for(i = 0; i < 3; i++) {
+    lladdr[i] = linkaddr_node_addr;
+    lladdr[i].u8[LINKADDR_SIZE - 1] += i;
+    uip_ip6addr(&ipaddr[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddr[i], (uip_lladdr_t *)&lladdr[i]);
+  }
+  uip_ip6addr(&child_target, 0xfd00, 0, 0, 0, 0, 0, 0, 2);
+  uip_ip6addr(&bad_target, 0xfd00, 0, 0, 0, 0, 0, 0, 3);
+
+  join_dag();
+
+  UNIT_TEST_RUN(test_child_dao);
+  UNIT_TEST_RUN(test_malformed_dao);
+
+  /* The coalescing window ends */
+  etimer_set(&et, RPL_DAO_COALESCE_WINDOW + CLOCK_SECOND / 16);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_coalesced_dao);
+  first_sequence = dao[3];
+
+  /* No DAO-ACK comes in time */
+  etimer_set(&et, RPL_DAO_RETRANSMISSION_TIMEOUT);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_retransmission);
+
+  etimer_set(&et, RPL_DAO_RETRANSMISSION_TIMEOUT * 2);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_acknowledged);
+
+  etimer_set(&et, RPL_DAO_COALESCE_WINDOW + CLOCK_SECOND / 16);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_no_path);
+
+  etimer_set(&et, RPL_DAO_RETRANSMISSION_TIMEOUT);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(test_no_path_retransmission);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
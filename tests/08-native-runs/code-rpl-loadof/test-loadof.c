@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks the hysteresis of the parent selection of LoadOF: a node keeps
+ * its preferred parent while the load of its path costs less than
+ * RPL_LOADOF_CONF_COST_THRESHOLD more than that of another parent, and
+ * switches beyond it.
+ */
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/link-stats.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(loadof_test_process, "LoadOF test process");
+AUTOSTART_PROCESSES(&loadof_test_process);
+/*---------------------------------------------------------------------------*/
+/* Two candidate parents, with the same rank and link quality */
+#define A 0
+#define B 1
+
+static linkaddr_t lladdr[2];
+static uip_ipaddr_t ipaddr[2];
+static rpl_dio_t dio[2];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Hands a DIO advertising the load of its path from a neighbor to the
+   node, in percent */
+static void
+receive_dio(int from, uint8_t queue, uint8_t tx)
+{
+  dio[from].mc.obj.load.queue = queue;
+  dio[from].mc.obj.load.tx = tx;
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &lladdr[from]);
+  rpl_process_dio(&ipaddr[from], &dio[from]);
+  rpl_dag_update_state();
+}
+/*---------------------------------------------------------------------------*/
+static int
+parent_is(int nbr)
+{
+  rpl_nbr_t *parent = curr_instance.dag.preferred_parent;
+
+  return parent != NULL
+    && linkaddr_cmp(rpl_neighbor_get_lladdr(parent), &lladdr[nbr]);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_join, "Join with LoadOF");
+UNIT_TEST(test_join)
+{
+  UNIT_TEST_BEGIN();
+
+  receive_dio(A, 0, 0);
+  receive_dio(B, 0, 0);
+  UNIT_TEST_ASSERT(curr_instance.used);
+  UNIT_TEST_ASSERT(curr_instance.of->ocp == RPL_OCP_LOADOF);
+  UNIT_TEST_ASSERT(curr_instance.mc.type == RPL_DAG_MC_LOAD);
+  UNIT_TEST_ASSERT(parent_is(A));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_within_hysteresis, "Parent kept within hysteresis");
+UNIT_TEST(test_within_hysteresis)
+{
+  UNIT_TEST_BEGIN();
+
+  /* 30% of the load weight is less than the cost threshold */
+  receive_dio(A, 30, 10);
+  UNIT_TEST_ASSERT(parent_is(A));
+  /* The load of the path is relayed to the nodes below */
+  UNIT_TEST_ASSERT(curr_instance.mc.obj.load.queue == 30);
+  UNIT_TEST_ASSERT(curr_instance.mc.obj.load.tx == 10);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_beyond_hysteresis, "Parent switched beyond hysteresis");
+UNIT_TEST(test_beyond_hysteresis)
+{
+  UNIT_TEST_BEGIN();
+
+  /* 60% of the load weight is more than the cost threshold */
+  receive_dio(A, 60, 10);
+  UNIT_TEST_ASSERT(parent_is(B));
+  UNIT_TEST_ASSERT(curr_instance.mc.obj.load.queue == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_hysteresis_both_ways, "Hysteresis applies to the new parent");
+UNIT_TEST(test_hysteresis_both_ways)
+{
+  UNIT_TEST_BEGIN();
+
+  /* A less loaded former parent is not enough to move back */
+  receive_dio(B, 20, 30);
+  receive_dio(A, 10, 5);
+  UNIT_TEST_ASSERT(parent_is(B));
+
+  /* The transmissions of the parent count as much as its queue */
+  receive_dio(B, 20, 90);
+  UNIT_TEST_ASSERT(parent_is(A));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(loadof_test_process, ev, data)
+{
+  int i;
+  int j;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  for(i = 0; i < 2; i++) {
+    lladdr[i] = linkaddr_node_addr;
+    lladdr[i].u8[LINKADDR_SIZE - 1] += i + 1;
+    uip_ip6addr(&ipaddr[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddr[i], (uip_lladdr_t *)&lladdr[i]);
+    /* Enough transmissions for fresh statistics, with a perfect ETX */
+    for(j = 0; j < 8; j++) {
+      link_stats_packet_sent(&lladdr[i], MAC_TX_OK, 1);
+    }
+
+    memset(&dio[i], 0, sizeof(dio[i]));
+    dio[i].instance_id = RPL_DEFAULT_INSTANCE;
+    dio[i].ocp = RPL_OCP_LOADOF;
+    dio[i].mop = RPL_MOP_DEFAULT;
+    dio[i].version = RPL_LOLLIPOP_INIT;
+    dio[i].rank = RPL_MIN_HOPRANKINC;
+    dio[i].grounded = 1;
+    dio[i].dag_max_rankinc = RPL_MAX_RANKINC;
+    dio[i].dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+    dio[i].dag_intmin = RPL_DIO_INTERVAL_MIN;
+    dio[i].dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+    dio[i].dag_redund = RPL_DIO_REDUNDANCY;
+    dio[i].default_lifetime = RPL_DEFAULT_LIFETIME;
+    dio[i].lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+    dio[i].mc.type = RPL_DAG_MC_LOAD;
+    dio[i].mc.aggr = RPL_DAG_MC_AGGR_MAXIMUM;
+    dio[i].mc.length = sizeof(dio[i].mc.obj.load);
+    uip_ip6addr(&dio[i].dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+    uip_ip6addr(&dio[i].prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+    dio[i].prefix_info.length = 64;
+    dio[i].prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  }
+
+  UNIT_TEST_RUN(test_join);
+  UNIT_TEST_RUN(test_within_hysteresis);
+  UNIT_TEST_RUN(test_beyond_hysteresis);
+  UNIT_TEST_RUN(test_hysteresis_both_ways);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
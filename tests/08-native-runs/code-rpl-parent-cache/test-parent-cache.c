@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks that the RPL parent cache always selects the same parent as a
+ * scan of all neighbors, and that it is invalidated when a neighbor is
+ * removed, when the rank or the link of the current best changes, and
+ * by rpl_neighbor_mark_all_changed().
+ */
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(parent_cache_test_process, "Parent cache test process");
+AUTOSTART_PROCESSES(&parent_cache_test_process);
+/*---------------------------------------------------------------------------*/
+/* The neighbors, D only shows up once the table is full */
+#define A 0
+#define B 1
+#define C 2
+#define D 3
+#define NUM_NBRS 4
+
+static linkaddr_t lladdr[NUM_NBRS];
+static uip_ipaddr_t ipaddr[NUM_NBRS];
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive_dio(int from, rpl_rank_t rank)
+{
+  rpl_dio_t dio;
+
+  memset(&dio, 0, sizeof(dio));
+  dio.instance_id = RPL_DEFAULT_INSTANCE;
+  dio.ocp = RPL_OF_OCP;
+  dio.mop = RPL_MOP_DEFAULT;
+  dio.version = RPL_LOLLIPOP_INIT;
+  dio.rank = rank;
+  dio.grounded = 1;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&dio.prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  dio.prefix_info.length = 64;
+  dio.prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &lladdr[from]);
+  rpl_process_dio(&ipaddr[from], &dio);
+}
+/*---------------------------------------------------------------------------*/
+/* Reports transmissions to a neighbor, as the MAC layer would */
+static void
+send_packets(int to, int status, int numtx, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++) {
+    link_stats_packet_sent(&lladdr[to], status, numtx);
+    rpl_link_callback(&lladdr[to], status, numtx);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static rpl_nbr_t *
+nbr(int i)
+{
+  return rpl_neighbor_get_from_lladdr((uip_lladdr_t *)&lladdr[i]);
+}
+/*---------------------------------------------------------------------------*/
+static int
+index_of(rpl_nbr_t *n)
+{
+  int i;
+
+  for(i = 0; i < NUM_NBRS && nbr(i) != n; i++);
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+/* The best parent from a scan of all neighbors, as without the cache */
+static rpl_nbr_t *
+scan_best_parent(void)
+{
+  rpl_nbr_t *n;
+  rpl_nbr_t *best = NULL;
+  rpl_rank_t max_rank;
+
+  max_rank = MIN((uint32_t)curr_instance.dag.lowest_rank + curr_instance.max_rankinc,
+                 RPL_INFINITE_RANK);
+  for(n = nbr_table_head(rpl_neighbors); n != NULL; n = nbr_table_next(rpl_neighbors, n)) {
+    if(n->rank != RPL_INFINITE_RANK && n->rank >= ROOT_RANK && n->rank <= max_rank
+       && curr_instance.of->nbr_is_acceptable_parent(n)) {
+      best = curr_instance.of->best_parent(best, n);
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_join, "Parent selected from the neighbors");
+UNIT_TEST(test_join)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(curr_instance.used);
+  UNIT_TEST_ASSERT(nbr(A) != NULL && nbr(B) != NULL && nbr(C) != NULL);
+  UNIT_TEST_ASSERT(curr_instance.dag.preferred_parent == nbr(A));
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_incremental, "One changed neighbor re-evaluated alone");
+UNIT_TEST(test_incremental)
+{
+  uint32_t full = rpl_neighbor_full_selections;
+  uint32_t incremental = rpl_neighbor_incremental_selections;
+
+  UNIT_TEST_BEGIN();
+
+  /* The link to a neighbor other than the best gets worse */
+  send_packets(C, MAC_TX_OK, 3, 4);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections == full);
+  UNIT_TEST_ASSERT(rpl_neighbor_incremental_selections == incremental + 1);
+
+  /* The link to the best gets better */
+  send_packets(A, MAC_TX_OK, 1, 4);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == nbr(A));
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections == full);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_rank_change, "Cache invalidated when the best rank gets worse");
+UNIT_TEST(test_rank_change)
+{
+  uint32_t full = rpl_neighbor_full_selections;
+
+  UNIT_TEST_BEGIN();
+
+  receive_dio(A, 4 * ROOT_RANK);
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections > full);
+  UNIT_TEST_ASSERT(curr_instance.dag.preferred_parent == nbr(B));
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+
+  /* A neighbor other than the best getting better is evaluated alone */
+  full = rpl_neighbor_full_selections;
+  receive_dio(A, ROOT_RANK);
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections == full);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_link_change, "Cache invalidated when the best link gets worse");
+UNIT_TEST(test_link_change)
+{
+  uint32_t full = rpl_neighbor_full_selections;
+  rpl_nbr_t *best = rpl_neighbor_select_best();
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(best != NULL);
+  send_packets(index_of(best), MAC_TX_NOACK, 4, 8);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() != best);
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections > full);
+  rpl_dag_update_state();
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_mark_all_changed, "Cache invalidated by the periodic update");
+UNIT_TEST(test_mark_all_changed)
+{
+  uint32_t full = rpl_neighbor_full_selections;
+
+  UNIT_TEST_BEGIN();
+
+  rpl_neighbor_select_best();
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections == full);
+
+  rpl_neighbor_mark_all_changed();
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections == full + 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_removal, "Cache invalidated by neighbor removal");
+UNIT_TEST(test_removal)
+{
+  uint32_t full = rpl_neighbor_full_selections;
+  int removed = 0;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* In a full table, a new neighbor replaces the one with the worst
+     rank, which must not be selected anymore */
+  receive_dio(D, ROOT_RANK);
+  UNIT_TEST_ASSERT(nbr(D) != NULL);
+  for(i = A; i <= C; i++) {
+    removed += nbr(i) == NULL;
+  }
+  UNIT_TEST_ASSERT(removed == 1);
+  UNIT_TEST_ASSERT(rpl_neighbor_full_selections > full);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == scan_best_parent());
+
+  rpl_neighbor_remove_all();
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == NULL);
+  UNIT_TEST_ASSERT(scan_best_parent() == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(parent_cache_test_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  for(i = 0; i < NUM_NBRS; i++) {
+    lladdr[i] = linkaddr_node_addr;
+    lladdr[i].u8[LINKADDR_SIZE - 1] += i + 1;
+    uip_ip6addr(&ipaddr[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddr[i], (uip_lladdr_t *)&lladdr[i]);
+  }
+
+  /* The first DIO creates the DAG, the next ones add the neighbors.
+     Enough transmissions for fresh statistics, with a perfect ETX. */
+  receive_dio(A, ROOT_RANK);
+  receive_dio(A, ROOT_RANK);
+  send_packets(A, MAC_TX_OK, 1, 8);
+  receive_dio(B, 2 * ROOT_RANK);
+  send_packets(B, MAC_TX_OK, 1, 8);
+  receive_dio(C, 3 * ROOT_RANK);
+  send_packets(C, MAC_TX_OK, 1, 8);
+  rpl_dag_update_state();
+
+  UNIT_TEST_RUN(test_join);
+  UNIT_TEST_RUN(test_incremental);
+  UNIT_TEST_RUN(test_rank_change);
+  UNIT_TEST_RUN(test_link_change);
+  UNIT_TEST_RUN(test_mark_all_changed);
+  UNIT_TEST_RUN(test_removal);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks the 6LoRH compression of RPL headers (RFC 8138): packets with
+ * an RPL option, a source routing header and IPv6-in-IPv6 encapsulation
+ * are compressed, handed back to sicslowpan as received frames, and
+ * must be rebuilt as they were. The 6LoRH headers of the frames are
+ * compared with the layouts of the examples of RFC 8138, Appendix A,
+ * and frames cut in the middle of a 6LoRH header must be dropped.
+ */
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/routing/routing.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(lorh_test_process, "6LoRH test process");
+AUTOSTART_PROCESSES(&lorh_test_process);
+/*---------------------------------------------------------------------------*/
+/* The neighbor the packets are sent to */
+static linkaddr_t peer;
+
+/* The root of the DODAG, which the node is, and addresses below it */
+static uip_ipaddr_t root;
+static uip_ipaddr_t node[5];
+static uip_ipaddr_t host;
+
+/* The packet given to sicslowpan, and the frame it was compressed to.
+   Other frames, such as those of the packets the node forwards once
+   rebuilt, are not captured. */
+static uint8_t packet[UIP_BUFSIZE];
+static uint16_t packet_len;
+static uint8_t capturing;
+static uint8_t frame[PACKETBUF_SIZE];
+static uint16_t frame_len;
+
+/* The packet rebuilt from the frame, if it was not dropped */
+static uint8_t rebuilt[UIP_BUFSIZE];
+static uint16_t rebuilt_len;
+/*---------------------------------------------------------------------------*/
+void
+print_test_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+send(mac_callback_t sent, void *ptr)
+{
+  if(capturing) {
+    frame_len = packetbuf_datalen();
+    memcpy(frame, packetbuf_dataptr(), frame_len);
+    capturing = 0;
+  }
+  mac_call_sent_callback(sent, ptr, MAC_TX_OK, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+max_payload(void)
+{
+  return 127 - 2 - 15;
+}
+/*---------------------------------------------------------------------------*/
+const struct mac_driver test_mac_driver = {
+  "test",
+  init,
+  send,
+  input,
+  on,
+  off,
+  max_payload
+};
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_input(void)
+{
+  rebuilt_len = uip_len;
+  memcpy(rebuilt, uip_buf, uip_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_output(int mac_status)
+{
+}
+/*---------------------------------------------------------------------------*/
+NETSTACK_SNIFFER(rebuilt_sniffer, sniffer_input, sniffer_output);
+/*---------------------------------------------------------------------------*/
+/* Writes an IPv6 header, with its payload length left to set_length() */
+static uint8_t *
+put_ip(uint8_t *ptr, uint8_t proto, uint8_t ttl,
+       const uip_ipaddr_t *src, const uip_ipaddr_t *dest)
+{
+  struct uip_ip_hdr *ip_hdr = (struct uip_ip_hdr *)ptr;
+
+  memset(ip_hdr, 0, UIP_IPH_LEN);
+  ip_hdr->vtc = 0x60;
+  ip_hdr->proto = proto;
+  ip_hdr->ttl = ttl;
+  uip_ipaddr_copy(&ip_hdr->srcipaddr, src);
+  uip_ipaddr_copy(&ip_hdr->destipaddr, dest);
+  return ptr + UIP_IPH_LEN;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes a hop-by-hop header holding the RPL option (RFC 6553) */
+static uint8_t *
+put_rpi(uint8_t *ptr, uint8_t next, uint8_t flags, uint8_t instance,
+        uint16_t rank)
+{
+  ptr[0] = next;
+  ptr[1] = 0;
+  ptr[2] = UIP_EXT_HDR_OPT_RPL;
+  ptr[3] = 4;
+  ptr[4] = flags;
+  ptr[5] = instance;
+  ptr[6] = rank >> 8;
+  ptr[7] = rank & 0xff;
+  return ptr + 8;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes a source routing header (RFC 6554) for hops that only differ
+   from the destination of the packet in their last two bytes, with
+   CmprI and CmprE of 14 */
+static uint8_t *
+put_srh(uint8_t *ptr, uint8_t next, const uip_ipaddr_t *hops, int n)
+{
+  uint8_t len = 8 + 2 * n;
+  uint8_t pad = (8 - (len & 7)) & 7;
+  int i;
+
+  ptr[0] = next;
+  ptr[1] = (len + pad - 8) >> 3;
+  ptr[2] = 3;
+  ptr[3] = n;
+  ptr[4] = 0xee;
+  ptr[5] = pad << 4;
+  ptr[6] = 0;
+  ptr[7] = 0;
+  ptr += 8;
+  for(i = 0; i < n; i++) {
+    *ptr++ = hops[i].u8[14];
+    *ptr++ = hops[i].u8[15];
+  }
+  memset(ptr, 0, pad);
+  return ptr + pad;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes a UDP header and payload */
+static uint8_t *
+put_udp(uint8_t *ptr, int len)
+{
+  int i;
+
+  ptr[0] = 0xf0;
+  ptr[1] = 0xb1;
+  ptr[2] = 0x16;
+  ptr[3] = 0x33;
+  ptr[4] = (UIP_UDPH_LEN + len) >> 8;
+  ptr[5] = (UIP_UDPH_LEN + len) & 0xff;
+  ptr[6] = 0x12;
+  ptr[7] = 0x34;
+  ptr += UIP_UDPH_LEN;
+  for(i = 0; i < len; i++) {
+    *ptr++ = i;
+  }
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
+/* Sets the payload length of the IPv6 header at hdr, which ends at end */
+static void
+set_length(uint8_t *hdr, const uint8_t *end)
+{
+  uipbuf_set_len_field((struct uip_ip_hdr *)hdr, end - hdr - UIP_IPH_LEN);
+}
+/*---------------------------------------------------------------------------*/
+/* Hands the first len bytes of the frame back to sicslowpan, with the
+   link-layer addresses it was sent with, so that IPHC rebuilds the IIDs
+   it elided. Returns 1 if a packet was rebuilt from it. */
+static int
+receive(uint16_t len)
+{
+  rebuilt_len = 0;
+  packetbuf_clear();
+  /* The bytes past len stay in packetbuf, where a parser that does not
+     check the length would find them */
+  packetbuf_copyfrom(frame, frame_len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &peer);
+  NETSTACK_NETWORK.input();
+  return rebuilt_len > 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Compresses the packet that ends at end, and rebuilds it from the
+   frame. Returns 1 if it was rebuilt as it was. */
+static int
+round_trip(const uint8_t *end)
+{
+  packet_len = end - packet;
+  memcpy(uip_buf, packet, packet_len);
+  uip_len = packet_len;
+  frame_len = 0;
+  capturing = 1;
+  NETSTACK_NETWORK.output(&peer);
+  capturing = 0;
+  if(frame_len == 0) {
+    return 0;
+  }
+
+  if(!receive(frame_len)) {
+    return 0;
+  }
+  if(rebuilt_len != packet_len || memcmp(rebuilt, packet, packet_len) != 0) {
+    printf("rebuilt packet differs, %u bytes instead of %u\n",
+           rebuilt_len, packet_len);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Tells whether the frame starts with the given 6LoRH headers, after
+   the Page 1 dispatch, and then goes on with IPHC */
+static int
+frame_starts_with(const uint8_t *lorh, int len)
+{
+  return frame_len > 1 + len && frame[0] == 0xf1 &&
+    memcmp(&frame[1], lorh, len) == 0 && (frame[1 + len] & 0xe0) == 0x60;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_rpi, "RPI-6LoRH");
+UNIT_TEST(test_rpi)
+{
+  /* RPI-6LoRH with the R flag, the I and K flags clear, then
+     the RPLInstanceID and SenderRank (RFC 8138, Section 6.3) */
+  static const uint8_t lorh[] = { 0x80 | 0x08, 0x05, 0x1e, 0x02, 0x34 };
+  uint8_t *ptr;
+
+  UNIT_TEST_BEGIN();
+
+  ptr = put_ip(packet, UIP_PROTO_HBHO, 64, &root, &node[2]);
+  ptr = put_rpi(ptr, UIP_PROTO_UDP, 0x40, 0x1e, 0x0234);
+  ptr = put_udp(ptr, 20);
+  set_length(packet, ptr);
+
+  UNIT_TEST_ASSERT(round_trip(ptr));
+  UNIT_TEST_ASSERT(frame_starts_with(lorh, sizeof(lorh)));
+
+  /* Cut in the SenderRank */
+  UNIT_TEST_ASSERT(!receive(1 + sizeof(lorh) - 1));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_rh3, "RH3-6LoRH without IP-in-IP");
+UNIT_TEST(test_rh3)
+{
+  /* One RH3-6LoRH of three 2-byte hops, each compressed against the
+     previous one, from the destination of the packet on */
+  static const uint8_t lorh[] = { 0x82, 0x01, 0x20, 0x02, 0x30, 0x03, 0x40, 0x04 };
+  uint8_t *ptr;
+
+  UNIT_TEST_BEGIN();
+
+  ptr = put_ip(packet, UIP_PROTO_ROUTING, 64, &root, &node[1]);
+  ptr = put_srh(ptr, UIP_PROTO_UDP, &node[2], 3);
+  ptr = put_udp(ptr, 20);
+  set_length(packet, ptr);
+
+  UNIT_TEST_ASSERT(round_trip(ptr));
+  UNIT_TEST_ASSERT(frame_starts_with(lorh, sizeof(lorh)));
+
+  /* Cut in the hops */
+  UNIT_TEST_ASSERT(!receive(1 + sizeof(lorh) - 3));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_rh3_ip_in_ip, "RH3-6LoRH with IP-in-IP");
+UNIT_TEST(test_rh3_ip_in_ip)
+{
+  /* The downward packet in Non-Storing mode of RFC 8138, Appendix A:
+     Page 1, an RH3-6LoRH of type 1 with Size 3, the RPI-6LoRH, and the
+     IP-in-IP 6LoRH, with the encapsulator elided as it is the root. The
+     RPI-6LoRH is the most compressed one, with the O flag set. */
+  static const uint8_t lorh[] = {
+    0x83, 0x01, 0x10, 0x01, 0x20, 0x02, 0x30, 0x03, 0x40, 0x04,
+    0x80 | 0x10 | 0x03, 0x05, 0x01,
+    0xa1, 0x06, 0x40
+  };
+  uint8_t *ptr;
+  uint8_t *inner;
+
+  UNIT_TEST_BEGIN();
+
+  ptr = put_ip(packet, UIP_PROTO_HBHO, 64, &root, &node[1]);
+  ptr = put_rpi(ptr, UIP_PROTO_ROUTING, 0x80, 0, 0x0100);
+  ptr = put_srh(ptr, UIP_PROTO_IPV6, &node[2], 3);
+  inner = ptr;
+  ptr = put_ip(ptr, UIP_PROTO_UDP, 63, &host, &node[4]);
+  ptr = put_udp(ptr, 20);
+  set_length(inner, ptr);
+  set_length(packet, ptr);
+
+  UNIT_TEST_ASSERT(round_trip(ptr));
+  UNIT_TEST_ASSERT(frame_starts_with(lorh, sizeof(lorh)));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_ip_in_ip, "IP-in-IP 6LoRH");
+UNIT_TEST(test_ip_in_ip)
+{
+  /* A packet tunnelled up to the root, as in RFC 8138, Appendix A: Page
+     1, the RPI-6LoRH, and the IP-in-IP 6LoRH with the hop limit and the
+     encapsulator, in the 2 bytes where it differs from the root. There
+     is no RH3-6LoRH, as the root is the destination of the tunnel. */
+  static const uint8_t lorh[] = {
+    0x80 | 0x03, 0x05, 0x03,
+    0xa3, 0x06, 0x40, 0x10, 0x01
+  };
+  uint8_t *ptr;
+  uint8_t *inner;
+
+  UNIT_TEST_BEGIN();
+
+  ptr = put_ip(packet, UIP_PROTO_HBHO, 64, &node[1], &root);
+  ptr = put_rpi(ptr, UIP_PROTO_IPV6, 0, 0, 0x0300);
+  inner = ptr;
+  ptr = put_ip(ptr, UIP_PROTO_UDP, 64, &node[1], &host);
+  ptr = put_udp(ptr, 20);
+  set_length(inner, ptr);
+  set_length(packet, ptr);
+
+  UNIT_TEST_ASSERT(round_trip(ptr));
+  UNIT_TEST_ASSERT(frame_starts_with(lorh, sizeof(lorh)));
+
+  /* Cut in the encapsulator */
+  UNIT_TEST_ASSERT(!receive(1 + sizeof(lorh) - 1));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lorh_test_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  peer = linkaddr_node_addr;
+  peer.u8[LINKADDR_SIZE - 1]++;
+
+  /* The node is the root, so that the IP-in-IP 6LoRH may carry the
+     encapsulator relative to it */
+  NETSTACK_ROUTING.root_start();
+  if(!NETSTACK_ROUTING.get_root_ipaddr(&root)) {
+    printf("=check-me= FAILED   - could not start the DODAG\n");
+    exit(0);
+  }
+  for(i = 0; i < 5; i++) {
+    uip_ipaddr_copy(&node[i], &root);
+    node[i].u8[14] = i << 4;
+    node[i].u8[15] = i;
+  }
+  uip_ip6addr(&host, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1);
+
+  netstack_sniffer_add(&rebuilt_sniffer);
+
+  UNIT_TEST_RUN(test_rpi);
+  UNIT_TEST_RUN(test_rh3);
+  UNIT_TEST_RUN(test_rh3_ip_in_ip);
+  UNIT_TEST_RUN(test_ip_in_ip);
+
+  printf("=check-me= DONE\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/